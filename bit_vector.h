@@ -0,0 +1,775 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "cpu_features.h"
+#include "isa_dispatch.h"
+#include "span.h"
+#include "vector.h"
+#include "vector_search.h"
+
+/*
+*   Битовый вектор: флаги хранятся по 64 в слове uint64_t, а не по байту на флаг, как в Vector<bool>.
+*
+*   Биты последнего слова за пределами размера всегда равны нулю, поэтому подсчёт единиц,
+*   поиск и побитовые операции работают целыми словами без масок на границе.
+*   Подсчёт единиц, поиск ненулевого слова и операции AND/OR/XOR/ANDNOT над двумя векторами
+*   выполняют векторные ядра уровня процессора: POPCNT на SSE4.2, подсчёт по тетрадам через
+*   таблицу в регистре (VPSHUFB) и сумму байт (VPSADBW) на AVX2 и AVX-512.
+*
+*   Rank и Select работают и без вспомогательных структур, просматривая слова от начала.
+*   BuildRankIndex строит индекс: накопленные суммы по блокам из RANK_BLOCK_WORDS слов и номера
+*   блоков для каждой SELECT_SAMPLE-й единицы. С индексом Rank просматривает не больше блока,
+*   а Select — двоичный поиск между соседними образцами. Любое изменение битов сбрасывает индекс.
+*/
+
+//  Побитовая операция над словами двух векторов: dst = dst OP src
+enum class BitOp {
+    And,
+    Or,
+    Xor,
+    AndNot
+};
+
+inline constexpr size_t BIT_OP_COUNT = 4;
+
+inline constexpr size_t BITS_PER_WORD = 64;
+
+template <BitOp OP>
+constexpr uint64_t ApplyBitOp(uint64_t dst, uint64_t src) noexcept {
+    if constexpr (OP == BitOp::And) {
+        return dst & src;
+    }
+    else if constexpr (OP == BitOp::Or) {
+        return dst | src;
+    }
+    else if constexpr (OP == BitOp::Xor) {
+        return dst ^ src;
+    }
+    else {
+        return dst & ~src;
+    }
+}
+
+/*
+*   Подсчёт единиц в четыре независимых аккумулятора. Встраивается и в скалярные ядра,
+*   и в ядра с целевым набором POPCNT, где __builtin_popcountll становится одной инструкцией.
+*/
+FV_FORCE_INLINE size_t PopCountWordsKernel(const uint64_t* words, size_t count) noexcept {
+    size_t acc[4] = {};
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        acc[0] += PopCount64(words[i]);
+        acc[1] += PopCount64(words[i + 1]);
+        acc[2] += PopCount64(words[i + 2]);
+        acc[3] += PopCount64(words[i + 3]);
+    }
+    for (; i < count; ++i) {
+        acc[0] += PopCount64(words[i]);
+    }
+    return acc[0] + acc[1] + acc[2] + acc[3];
+}
+
+/* СКАЛЯРНЫЕ ЯДРА. FindNonZero возвращает count, если все слова нулевые */
+
+struct ScalarBits {
+    static size_t PopCount(const uint64_t* words, size_t count) noexcept {
+        return PopCountWordsKernel(words, count);
+    }
+
+    template <BitOp OP>
+    static void Combine(uint64_t* dst, const uint64_t* src, size_t count) noexcept {
+        for (size_t i = 0; i < count; ++i) {
+            dst[i] = ApplyBitOp<OP>(dst[i], src[i]);
+        }
+    }
+
+    static size_t FindNonZero(const uint64_t* words, size_t count) noexcept {
+        size_t i = 0;
+        while (i < count && words[i] == 0) {
+            ++i;
+        }
+        return i;
+    }
+};
+
+#if FV_X86
+
+/*
+*   Регистры одного уровня для битовых ядер: Load, Store, Apply<OP>, IsZero и, на AVX2 и AVX-512,
+*   CountBits — количество единиц в каждой 64-битной дорожке (VPSHUFB по тетрадам и VPSADBW).
+*/
+struct Sse42BitLanes {
+    using Register = __m128i;
+    static constexpr size_t WORDS = 2;
+
+    FV_TARGET("sse4.2") static Register Load(const uint64_t* words) noexcept {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+    }
+
+    FV_TARGET("sse4.2") static void Store(uint64_t* words, Register value) noexcept {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(words), value);
+    }
+
+    FV_TARGET("sse4.2") static Register Or(Register lhs, Register rhs) noexcept {
+        return _mm_or_si128(lhs, rhs);
+    }
+
+    template <BitOp OP>
+    FV_TARGET("sse4.2") static Register Apply(Register dst, Register src) noexcept {
+        if constexpr (OP == BitOp::And) {
+            return _mm_and_si128(dst, src);
+        }
+        else if constexpr (OP == BitOp::Or) {
+            return _mm_or_si128(dst, src);
+        }
+        else if constexpr (OP == BitOp::Xor) {
+            return _mm_xor_si128(dst, src);
+        }
+        else {
+            return _mm_andnot_si128(src, dst);
+        }
+    }
+
+    FV_TARGET("sse4.2") static bool IsZero(Register value) noexcept {
+        return _mm_testz_si128(value, value) != 0;
+    }
+};
+
+struct Avx2BitLanes {
+    using Register = __m256i;
+    static constexpr size_t WORDS = 4;
+
+    FV_TARGET("avx2") static Register Load(const uint64_t* words) noexcept {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+    }
+
+    FV_TARGET("avx2") static void Store(uint64_t* words, Register value) noexcept {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(words), value);
+    }
+
+    FV_TARGET("avx2") static Register Or(Register lhs, Register rhs) noexcept {
+        return _mm256_or_si256(lhs, rhs);
+    }
+
+    template <BitOp OP>
+    FV_TARGET("avx2") static Register Apply(Register dst, Register src) noexcept {
+        if constexpr (OP == BitOp::And) {
+            return _mm256_and_si256(dst, src);
+        }
+        else if constexpr (OP == BitOp::Or) {
+            return _mm256_or_si256(dst, src);
+        }
+        else if constexpr (OP == BitOp::Xor) {
+            return _mm256_xor_si256(dst, src);
+        }
+        else {
+            return _mm256_andnot_si256(src, dst);
+        }
+    }
+
+    FV_TARGET("avx2") static bool IsZero(Register value) noexcept {
+        return _mm256_testz_si256(value, value) != 0;
+    }
+
+    FV_TARGET("avx2") static Register Zero() noexcept {
+        return _mm256_setzero_si256();
+    }
+
+    FV_TARGET("avx2") static Register CountBits(Register value) noexcept {
+        const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+        const __m256i low = _mm256_and_si256(value, low_nibbles);
+        const __m256i high = _mm256_and_si256(_mm256_srli_epi16(value, 4), low_nibbles);
+        const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(table, low), _mm256_shuffle_epi8(table, high));
+        return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+    }
+
+    FV_TARGET("avx2") static Register Add(Register lhs, Register rhs) noexcept {
+        return _mm256_add_epi64(lhs, rhs);
+    }
+
+    FV_TARGET("avx2") static size_t HorizontalSum(Register value) noexcept {
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), value);
+        return static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    }
+};
+
+struct Avx512BitLanes {
+    using Register = __m512i;
+    static constexpr size_t WORDS = 8;
+
+    FV_TARGET(FV_AVX512) static Register Load(const uint64_t* words) noexcept {
+        return _mm512_loadu_si512(words);
+    }
+
+    FV_TARGET(FV_AVX512) static void Store(uint64_t* words, Register value) noexcept {
+        _mm512_storeu_si512(words, value);
+    }
+
+    FV_TARGET(FV_AVX512) static Register Or(Register lhs, Register rhs) noexcept {
+        return _mm512_or_si512(lhs, rhs);
+    }
+
+    template <BitOp OP>
+    FV_TARGET(FV_AVX512) static Register Apply(Register dst, Register src) noexcept {
+        if constexpr (OP == BitOp::And) {
+            return _mm512_and_si512(dst, src);
+        }
+        else if constexpr (OP == BitOp::Or) {
+            return _mm512_or_si512(dst, src);
+        }
+        else if constexpr (OP == BitOp::Xor) {
+            return _mm512_xor_si512(dst, src);
+        }
+        else {
+            // dst & ~src одной инструкцией: у _mm512_andnot_si512 в GCC 12 ложное предупреждение о неинициализированном регистре
+            return _mm512_ternarylogic_epi64(dst, src, src, 0x30);
+        }
+    }
+
+    FV_TARGET(FV_AVX512) static bool IsZero(Register value) noexcept {
+        return _mm512_test_epi64_mask(value, value) == 0;
+    }
+
+    FV_TARGET(FV_AVX512) static Register Zero() noexcept {
+        return _mm512_setzero_si512();
+    }
+
+    FV_TARGET(FV_AVX512) static Register CountBits(Register value) noexcept {
+        const __m512i table = _mm512_set4_epi64(0x0403030203020201, 0x0302020102010100, 0x0403030203020201, 0x0302020102010100);
+        const __m512i low_nibbles = _mm512_set1_epi8(0x0F);
+        const __m512i low = _mm512_and_si512(value, low_nibbles);
+        const __m512i high = _mm512_and_si512(_mm512_srli_epi16(value, 4), low_nibbles);
+        const __m512i bytes = _mm512_add_epi8(_mm512_shuffle_epi8(table, low), _mm512_shuffle_epi8(table, high));
+        return _mm512_sad_epu8(bytes, _mm512_setzero_si512());
+    }
+
+    FV_TARGET(FV_AVX512) static Register Add(Register lhs, Register rhs) noexcept {
+        return _mm512_add_epi64(lhs, rhs);
+    }
+
+    FV_TARGET(FV_AVX512) static size_t HorizontalSum(Register value) noexcept {
+        alignas(64) uint64_t lanes[8];
+        _mm512_store_si512(lanes, value);
+        uint64_t sum = 0;
+        for (uint64_t lane : lanes) {
+            sum += lane;
+        }
+        return static_cast<size_t>(sum);
+    }
+};
+
+/*
+*   ОБОБЩЁННЫЕ ЯДРА. Встраиваются в обёртки уровней, поэтому регистры не передаются между
+*   функциями с разными наборами инструкций (см. vector_search.h).
+*/
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+template <typename Lanes, BitOp OP>
+FV_FORCE_INLINE void CombineKernel(uint64_t* dst, const uint64_t* src, size_t count) noexcept {
+    constexpr size_t WORDS = Lanes::WORDS;
+    size_t i = 0;
+    for (; i + 2 * WORDS <= count; i += 2 * WORDS) {
+        const auto low = Lanes::template Apply<OP>(Lanes::Load(dst + i), Lanes::Load(src + i));
+        const auto high = Lanes::template Apply<OP>(Lanes::Load(dst + i + WORDS), Lanes::Load(src + i + WORDS));
+        Lanes::Store(dst + i, low);
+        Lanes::Store(dst + i + WORDS, high);
+    }
+    ScalarBits::Combine<OP>(dst + i, src + i, count - i);
+}
+
+template <typename Lanes>
+FV_FORCE_INLINE size_t FindNonZeroKernel(const uint64_t* words, size_t count) noexcept {
+    constexpr size_t WORDS = Lanes::WORDS;
+    size_t i = 0;
+    for (; i + 2 * WORDS <= count; i += 2 * WORDS) {
+        if (!Lanes::IsZero(Lanes::Or(Lanes::Load(words + i), Lanes::Load(words + i + WORDS)))) {
+            break;
+        }
+    }
+    return i + ScalarBits::FindNonZero(words + i, count - i);
+}
+
+template <typename Lanes>
+FV_FORCE_INLINE size_t PopCountLanesKernel(const uint64_t* words, size_t count) noexcept {
+    constexpr size_t WORDS = Lanes::WORDS;
+    auto low = Lanes::Zero();
+    auto high = Lanes::Zero();
+    size_t i = 0;
+    for (; i + 2 * WORDS <= count; i += 2 * WORDS) {
+        low = Lanes::Add(low, Lanes::CountBits(Lanes::Load(words + i)));
+        high = Lanes::Add(high, Lanes::CountBits(Lanes::Load(words + i + WORDS)));
+    }
+    return Lanes::HorizontalSum(Lanes::Add(low, high)) + PopCountWordsKernel(words + i, count - i);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+struct Sse42Bits {
+    FV_TARGET("sse4.2,popcnt") static size_t PopCount(const uint64_t* words, size_t count) noexcept {
+        return PopCountWordsKernel(words, count);
+    }
+
+    template <BitOp OP>
+    FV_TARGET("sse4.2,popcnt") static void Combine(uint64_t* dst, const uint64_t* src, size_t count) noexcept {
+        CombineKernel<Sse42BitLanes, OP>(dst, src, count);
+    }
+
+    FV_TARGET("sse4.2,popcnt") static size_t FindNonZero(const uint64_t* words, size_t count) noexcept {
+        return FindNonZeroKernel<Sse42BitLanes>(words, count);
+    }
+};
+
+struct Avx2Bits {
+    FV_TARGET("avx2,popcnt") static size_t PopCount(const uint64_t* words, size_t count) noexcept {
+        return PopCountLanesKernel<Avx2BitLanes>(words, count);
+    }
+
+    template <BitOp OP>
+    FV_TARGET("avx2,popcnt") static void Combine(uint64_t* dst, const uint64_t* src, size_t count) noexcept {
+        CombineKernel<Avx2BitLanes, OP>(dst, src, count);
+    }
+
+    FV_TARGET("avx2,popcnt") static size_t FindNonZero(const uint64_t* words, size_t count) noexcept {
+        return FindNonZeroKernel<Avx2BitLanes>(words, count);
+    }
+};
+
+struct Avx512Bits {
+    FV_TARGET(FV_AVX512 ",popcnt") static size_t PopCount(const uint64_t* words, size_t count) noexcept {
+        return PopCountLanesKernel<Avx512BitLanes>(words, count);
+    }
+
+    template <BitOp OP>
+    FV_TARGET(FV_AVX512 ",popcnt") static void Combine(uint64_t* dst, const uint64_t* src, size_t count) noexcept {
+        CombineKernel<Avx512BitLanes, OP>(dst, src, count);
+    }
+
+    FV_TARGET(FV_AVX512 ",popcnt") static size_t FindNonZero(const uint64_t* words, size_t count) noexcept {
+        return FindNonZeroKernel<Avx512BitLanes>(words, count);
+    }
+};
+
+#endif
+
+/*
+*   Таблица битовых ядер. Active() — таблица активного уровня (ActiveIsaLevel),
+*   Dispatch() позволяет получить и сравнить таблицы всех уровней.
+*/
+class BitKernels {
+public:
+    using PopCountFn = size_t (*)(const uint64_t*, size_t);
+    using CombineFn = void (*)(uint64_t*, const uint64_t*, size_t);
+    using FindNonZeroFn = size_t (*)(const uint64_t*, size_t);
+
+    struct Table {
+        PopCountFn pop_count;
+        CombineFn combine[BIT_OP_COUNT];
+        FindNonZeroFn find_non_zero;
+    };
+
+    static const IsaDispatch<Table>& Dispatch() noexcept {
+        static constexpr Table SCALAR{ &ScalarBits::PopCount,
+            { &ScalarBits::Combine<BitOp::And>, &ScalarBits::Combine<BitOp::Or>,
+              &ScalarBits::Combine<BitOp::Xor>, &ScalarBits::Combine<BitOp::AndNot> },
+            &ScalarBits::FindNonZero };
+#if FV_X86
+        static constexpr Table SSE42{ &Sse42Bits::PopCount,
+            { &Sse42Bits::Combine<BitOp::And>, &Sse42Bits::Combine<BitOp::Or>,
+              &Sse42Bits::Combine<BitOp::Xor>, &Sse42Bits::Combine<BitOp::AndNot> },
+            &Sse42Bits::FindNonZero };
+        static constexpr Table AVX2{ &Avx2Bits::PopCount,
+            { &Avx2Bits::Combine<BitOp::And>, &Avx2Bits::Combine<BitOp::Or>,
+              &Avx2Bits::Combine<BitOp::Xor>, &Avx2Bits::Combine<BitOp::AndNot> },
+            &Avx2Bits::FindNonZero };
+        static constexpr Table AVX512{ &Avx512Bits::PopCount,
+            { &Avx512Bits::Combine<BitOp::And>, &Avx512Bits::Combine<BitOp::Or>,
+              &Avx512Bits::Combine<BitOp::Xor>, &Avx512Bits::Combine<BitOp::AndNot> },
+            &Avx512Bits::FindNonZero };
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR, &SSE42, &AVX2, &AVX512);
+#else
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR);
+#endif
+        return DISPATCH;
+    }
+
+    static const Table& Active() noexcept {
+        static const Table& table = Dispatch().Active();
+        return table;
+    }
+
+    static const Table& ForLevel(IsaLevel level) noexcept {
+        return Dispatch().ForLevel(level);
+    }
+};
+
+//  Позиция единицы номер rank (с нуля) в слове word. В слове должно быть больше rank единиц
+inline size_t SelectInWord(uint64_t word, size_t rank) noexcept {
+    size_t bit = 0;
+    for (;;) {
+        const size_t count = static_cast<size_t>(PopCount(static_cast<uint32_t>(word & 0xFF)));
+        if (rank < count) {
+            break;
+        }
+        rank -= count;
+        word >>= 8;
+        bit += 8;
+    }
+    for (; rank > 0; --rank) {
+        word &= word - 1;
+    }
+    return bit + static_cast<size_t>(CountTrailingZeros64(word));
+}
+
+class BitVector {
+public:
+    //  Размер блока индекса Rank в словах: строка кэша из восьми слов
+    static constexpr size_t RANK_BLOCK_WORDS = 8;
+    static constexpr size_t RANK_BLOCK_BITS = RANK_BLOCK_WORDS * BITS_PER_WORD;
+    //  Индекс Select запоминает блок каждой SELECT_SAMPLE-й единицы
+    static constexpr size_t SELECT_SAMPLE = 4096;
+
+    BitVector() = default;
+
+    explicit BitVector(size_t size, bool value = false)
+        : words_(WordsFor(size))
+        , size_(size) {
+        FillWords(0, WordsFor(size), value);
+        ClearTail();
+    }
+
+    BitVector(const BitVector& other)
+        : words_(other.WordCount())
+        , size_(other.size_) {
+        CopyWords(other.words_.GetAddress(), other.WordCount(), words_.GetAddress());
+    }
+
+    BitVector(BitVector&& other) noexcept {
+        Swap(other);
+    }
+
+    BitVector& operator=(const BitVector& rhs) {
+        if (this != &rhs) {
+            BitVector copy(rhs);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    BitVector& operator=(BitVector&& rhs) noexcept {
+        Swap(rhs);
+        return *this;
+    }
+
+    void Swap(BitVector& other) noexcept {
+        words_.Swap(other.words_);
+        std::swap(size_, other.size_);
+        block_ranks_.Swap(other.block_ranks_);
+        select_samples_.Swap(other.select_samples_);
+        std::swap(rank_index_valid_, other.rank_index_valid_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
+
+    //  Вместимость в битах
+    size_t Capacity() const noexcept {
+        return words_.Capacity() * BITS_PER_WORD;
+    }
+
+    size_t WordCount() const noexcept {
+        return WordsFor(size_);
+    }
+
+    //  Слова вектора: бит i хранится в бите i % 64 слова i / 64
+    Span<const uint64_t> Words() const noexcept {
+        return Span<const uint64_t>(words_.GetAddress(), WordCount());
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity > Capacity()) {
+            Reallocate(WordsFor(new_capacity));
+        }
+    }
+
+    void ShrinkToFit() {
+        if (WordCount() < words_.Capacity()) {
+            Reallocate(WordCount());
+        }
+    }
+
+    //  Новые биты получают значение value
+    void Resize(size_t new_size, bool value = false) {
+        Reserve(new_size);
+        if (new_size > size_) {
+            const size_t old_words = WordCount();
+            if (value && size_ % BITS_PER_WORD != 0) {
+                words_[old_words - 1] |= ~uint64_t{ 0 } << (size_ % BITS_PER_WORD);
+            }
+            FillWords(old_words, WordsFor(new_size), value);
+        }
+        size_ = new_size;
+        ClearTail();
+        rank_index_valid_ = false;
+    }
+
+    void Clear() noexcept {
+        size_ = 0;
+        rank_index_valid_ = false;
+    }
+
+    void PushBack(bool value) {
+        if (size_ == Capacity()) {
+            Reallocate(words_.Capacity() == 0 ? 1 : words_.Capacity() * 2);
+        }
+        const size_t word = size_ / BITS_PER_WORD;
+        const uint64_t bit = uint64_t{ value } << (size_ % BITS_PER_WORD);
+        words_[word] = size_ % BITS_PER_WORD == 0 ? bit : words_[word] | bit;
+        ++size_;
+        rank_index_valid_ = false;
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        --size_;
+        ClearTail();
+        rank_index_valid_ = false;
+    }
+
+    bool Test(size_t index) const noexcept {
+        assert(index < size_);
+        return (words_[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
+    }
+
+    bool operator[](size_t index) const noexcept {
+        return Test(index);
+    }
+
+    void Set(size_t index) noexcept {
+        assert(index < size_);
+        words_[index / BITS_PER_WORD] |= Bit(index);
+        rank_index_valid_ = false;
+    }
+
+    void Set(size_t index, bool value) noexcept {
+        assert(index < size_);
+        uint64_t& word = words_[index / BITS_PER_WORD];
+        word = (word & ~Bit(index)) | (uint64_t{ value } << (index % BITS_PER_WORD));
+        rank_index_valid_ = false;
+    }
+
+    void Reset(size_t index) noexcept {
+        assert(index < size_);
+        words_[index / BITS_PER_WORD] &= ~Bit(index);
+        rank_index_valid_ = false;
+    }
+
+    void Flip(size_t index) noexcept {
+        assert(index < size_);
+        words_[index / BITS_PER_WORD] ^= Bit(index);
+        rank_index_valid_ = false;
+    }
+
+    //  Заменяет слово index целиком. Биты слова за пределами размера должны быть нулевыми
+    void SetWord(size_t index, uint64_t word) noexcept {
+        assert(index < WordCount());
+        assert(index + 1 < WordCount() || size_ % BITS_PER_WORD == 0 || word >> (size_ % BITS_PER_WORD) == 0);
+        words_[index] = word;
+        rank_index_valid_ = false;
+    }
+
+    //  Присваивает value всем битам
+    void Fill(bool value) noexcept {
+        FillWords(0, WordCount(), value);
+        ClearTail();
+        rank_index_valid_ = false;
+    }
+
+    /*
+    *   Побитовые операции с вектором того же размера: this = this OP other.
+    *   other может быть этим же вектором.
+    */
+    void And(const BitVector& other) noexcept {
+        Combine<BitOp::And>(other);
+    }
+
+    void Or(const BitVector& other) noexcept {
+        Combine<BitOp::Or>(other);
+    }
+
+    void Xor(const BitVector& other) noexcept {
+        Combine<BitOp::Xor>(other);
+    }
+
+    //  Сбрасывает биты, установленные в other
+    void AndNot(const BitVector& other) noexcept {
+        Combine<BitOp::AndNot>(other);
+    }
+
+    //  Количество установленных битов
+    size_t Count() const noexcept {
+        return BitKernels::Active().pop_count(words_.GetAddress(), WordCount());
+    }
+
+    //  Позиция первого установленного бита с индексом не меньше from, либо NOT_FOUND
+    size_t FindNext(size_t from) const noexcept {
+        if (from >= size_) {
+            return NOT_FOUND;
+        }
+        size_t word = from / BITS_PER_WORD;
+        const uint64_t head = words_[word] & (~uint64_t{ 0 } << (from % BITS_PER_WORD));
+        if (head != 0) {
+            return word * BITS_PER_WORD + static_cast<size_t>(CountTrailingZeros64(head));
+        }
+        ++word;
+        word += BitKernels::Active().find_non_zero(words_ + word, WordCount() - word);
+        if (word == WordCount()) {
+            return NOT_FOUND;
+        }
+        return word * BITS_PER_WORD + static_cast<size_t>(CountTrailingZeros64(words_[word]));
+    }
+
+    size_t FindFirst() const noexcept {
+        return FindNext(0);
+    }
+
+    /*
+    *   Строит индекс Rank и Select для текущего содержимого. Индекс занимает около 1/512
+    *   объёма вектора на Rank и по слову на каждые SELECT_SAMPLE единиц на Select
+    *   и действует до следующего изменения битов.
+    */
+    void BuildRankIndex() {
+        const size_t words = WordCount();
+        const size_t blocks = (words + RANK_BLOCK_WORDS - 1) / RANK_BLOCK_WORDS;
+        Vector<uint64_t> block_ranks(blocks + 1);
+        Vector<size_t> select_samples;
+        const auto pop_count = BitKernels::Active().pop_count;
+        uint64_t rank = 0;
+        for (size_t block = 0; block < blocks; ++block) {
+            block_ranks[block] = rank;
+            const size_t first = block * RANK_BLOCK_WORDS;
+            const uint64_t next = rank + pop_count(words_ + first, std::min(RANK_BLOCK_WORDS, words - first));
+            // Образец j указывает на блок, в котором находится единица номер j * SELECT_SAMPLE
+            for (uint64_t sample = select_samples.Size() * SELECT_SAMPLE; sample < next; sample += SELECT_SAMPLE) {
+                select_samples.PushBack(block);
+            }
+            rank = next;
+        }
+        block_ranks[blocks] = rank;
+        block_ranks_.Swap(block_ranks);
+        select_samples_.Swap(select_samples);
+        rank_index_valid_ = true;
+    }
+
+    bool HasRankIndex() const noexcept {
+        return rank_index_valid_;
+    }
+
+    //  Количество установленных битов с индексами меньше position
+    size_t Rank(size_t position) const noexcept {
+        assert(position <= size_);
+        size_t word = 0;
+        size_t rank = 0;
+        if (rank_index_valid_) {
+            const size_t block = position / RANK_BLOCK_BITS;
+            word = block * RANK_BLOCK_WORDS;
+            rank = static_cast<size_t>(block_ranks_[block]);
+        }
+        const size_t last = position / BITS_PER_WORD;
+        rank += BitKernels::Active().pop_count(words_ + word, last - word);
+        if (position % BITS_PER_WORD != 0) {
+            rank += static_cast<size_t>(PopCount64(words_[last] & (Bit(position) - 1)));
+        }
+        return rank;
+    }
+
+    //  Позиция установленного бита номер rank (с нуля), либо NOT_FOUND, если единиц не больше rank
+    size_t Select(size_t rank) const noexcept {
+        size_t word = 0;
+        if (rank_index_valid_) {
+            if (rank >= block_ranks_[block_ranks_.Size() - 1]) {
+                return NOT_FOUND;
+            }
+            const size_t sample = rank / SELECT_SAMPLE;
+            const size_t low = select_samples_[sample];
+            const size_t high = sample + 1 < select_samples_.Size() ? select_samples_[sample + 1] + 1 : block_ranks_.Size() - 1;
+            const uint64_t* ranks = block_ranks_.begin();
+            const size_t block = static_cast<size_t>(std::upper_bound(ranks + low, ranks + high, uint64_t{ rank }) - ranks) - 1;
+            word = block * RANK_BLOCK_WORDS;
+            rank -= static_cast<size_t>(block_ranks_[block]);
+        }
+        for (const size_t words = WordCount(); word < words; ++word) {
+            const size_t count = static_cast<size_t>(PopCount64(words_[word]));
+            if (rank < count) {
+                return word * BITS_PER_WORD + SelectInWord(words_[word], rank);
+            }
+            rank -= count;
+        }
+        return NOT_FOUND;
+    }
+
+private:
+    RawMemory<uint64_t, CACHE_LINE_SIZE> words_;
+    size_t size_ = 0;
+    Vector<uint64_t> block_ranks_;
+    Vector<size_t> select_samples_;
+    bool rank_index_valid_ = false;
+
+    static size_t WordsFor(size_t bits) noexcept {
+        return (bits + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    }
+
+    static uint64_t Bit(size_t index) noexcept {
+        return uint64_t{ 1 } << (index % BITS_PER_WORD);
+    }
+
+    static void CopyWords(const uint64_t* src, size_t count, uint64_t* dst) noexcept {
+        if (count != 0) {
+            std::memcpy(dst, src, count * sizeof(uint64_t));
+        }
+    }
+
+    void FillWords(size_t first, size_t last, bool value) noexcept {
+        if (first < last) {
+            std::memset(words_ + first, value ? 0xFF : 0, (last - first) * sizeof(uint64_t));
+        }
+    }
+
+    //  Обнуляет биты последнего слова за пределами размера
+    void ClearTail() noexcept {
+        if (size_ % BITS_PER_WORD != 0) {
+            words_[size_ / BITS_PER_WORD] &= Bit(size_) - 1;
+        }
+    }
+
+    void Reallocate(size_t word_capacity) {
+        RawMemory<uint64_t, CACHE_LINE_SIZE> new_words(word_capacity);
+        CopyWords(words_.GetAddress(), WordCount(), new_words.GetAddress());
+        words_.Swap(new_words);
+    }
+
+    template <BitOp OP>
+    void Combine(const BitVector& other) noexcept {
+        assert(other.size_ == size_);
+        BitKernels::Active().combine[static_cast<size_t>(OP)](words_.GetAddress(), other.words_.GetAddress(), WordCount());
+        rank_index_valid_ = false;
+    }
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "span.h"
+#include "vector.h"
+
+// Порядок байт платформы. MSVC собирает только для платформ с младшим байтом вперёд
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+inline constexpr bool LITTLE_ENDIAN_HOST = false;
+#else
+inline constexpr bool LITTLE_ENDIAN_HOST = true;
+#endif
+
+/*
+*   Память, отданная ByteBuffer::Release: буфер и количество записанных в него байт.
+*   Её можно передать дальше без копирования или вернуть в ByteBuffer для повторного использования.
+*/
+struct ByteBlock {
+    RawMemory<std::byte> memory;
+    size_t size = 0;
+
+    Span<const std::byte> Bytes() const noexcept {
+        return Span<const std::byte>(memory.GetAddress(), size);
+    }
+};
+
+/*
+*   Растущий буфер для сериализации.
+*
+*   Кодировщик просит WritableSpan(min_bytes) — вид на всю запасную память, в которой не меньше
+*   min_bytes байт, — пишет в него сколько угодно байт и делает их частью буфера методом Commit(n).
+*   Вместимость проверяется один раз на такую запись, а не на каждый байт, как у Vector::EmplaceBack.
+*   При нехватке места вместимость удваивается, содержимое переносится memcpy.
+*
+*   Append<T> записывает арифметическое значение или перечисление в порядке байт от младшего
+*   к старшему независимо от платформы. Release отдаёт память вместе с размером без копирования
+*   и оставляет буфер пустым.
+*/
+class ByteBuffer {
+public:
+    ByteBuffer() = default;
+
+    explicit ByteBuffer(size_t capacity)
+        : memory_(capacity) {
+    }
+
+    //  Продолжает запись в память, отданную ранее Release
+    explicit ByteBuffer(ByteBlock&& block) noexcept
+        : memory_(std::move(block.memory))
+        , size_(std::exchange(block.size, 0)) {
+    }
+
+    ByteBuffer(const ByteBuffer&) = delete;
+    ByteBuffer& operator=(const ByteBuffer&) = delete;
+
+    ByteBuffer(ByteBuffer&& other) noexcept {
+        Swap(other);
+    }
+
+    ByteBuffer& operator=(ByteBuffer&& rhs) noexcept {
+        Swap(rhs);
+        return *this;
+    }
+
+    void Swap(ByteBuffer& other) noexcept {
+        memory_.Swap(other.memory_);
+        std::swap(size_, other.size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
+
+    size_t Capacity() const noexcept {
+        return memory_.Capacity();
+    }
+
+    const std::byte* Data() const noexcept {
+        return memory_.GetAddress();
+    }
+
+    std::byte* Data() noexcept {
+        return memory_.GetAddress();
+    }
+
+    Span<const std::byte> Bytes() const noexcept {
+        return Span<const std::byte>(memory_.GetAddress(), size_);
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity > memory_.Capacity()) {
+            Reallocate(new_capacity);
+        }
+    }
+
+    //  Удаляет записанные байты, сохраняя вместимость
+    void Clear() noexcept {
+        size_ = 0;
+    }
+
+    /*
+    *   Вид на всю запасную память за записанными байтами; в нём не меньше min_bytes байт.
+    *   Вид действителен до следующего изменения вместимости буфера.
+    */
+    Span<std::byte> WritableSpan(size_t min_bytes) {
+        if (min_bytes > memory_.Capacity() - size_) {
+            Reallocate(std::max(size_ + min_bytes, memory_.Capacity() * 2));
+        }
+        return Span<std::byte>(memory_ + size_, memory_.Capacity() - size_);
+    }
+
+    //  Делает частью буфера n байт, записанных в начало WritableSpan
+    void Commit(size_t n) noexcept {
+        assert(n <= memory_.Capacity() - size_);
+        size_ += n;
+    }
+
+    void Append(const void* data, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        std::memcpy(WritableSpan(size).Data(), data, size);
+        size_ += size;
+    }
+
+    template <typename T>
+    void Append(T value) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "ByteBuffer::Append<T> writes arithmetic and enum values");
+        std::byte* out = WritableSpan(sizeof(T)).Data();
+        std::memcpy(out, &value, sizeof(T));
+        if constexpr (!LITTLE_ENDIAN_HOST && sizeof(T) > 1) {
+            std::reverse(out, out + sizeof(T));
+        }
+        size_ += sizeof(T);
+    }
+
+    //  Отдаёт память с записанными байтами и оставляет буфер пустым, без памяти
+    ByteBlock Release() noexcept {
+        ByteBlock block;
+        block.memory.Swap(memory_);
+        block.size = std::exchange(size_, 0);
+        return block;
+    }
+
+private:
+    RawMemory<std::byte> memory_;
+    size_t size_ = 0;
+
+    void Reallocate(size_t new_capacity) {
+        RawMemory<std::byte> new_memory(new_capacity);
+        if (size_ != 0) {
+            std::memcpy(new_memory.GetAddress(), memory_.GetAddress(), size_);
+        }
+        memory_.Swap(new_memory);
+    }
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#if defined(_WIN32)
+// Та же раскладка, что у struct iovec из POSIX, чтобы код, собирающий массив для writev, не зависел от платформы
+struct iovec {
+    void* iov_base;
+    size_t iov_len;
+};
+#else
+#include <sys/uio.h>
+#endif
+
+#include "byte_buffer.h"
+#include "span.h"
+#include "vector.h"
+
+/*
+*   Буфер сообщения из цепочки блоков для вывода без копирования.
+*
+*   Байты лежат в блоках RawMemory, по умолчанию по ChunkSize() байт. Когда место в последнем блоке
+*   кончается, к цепочке добавляется новый блок, а записанные байты никогда не переносятся,
+*   в отличие от роста одного Vector<char>. Поэтому указатели на записанные байты действительны,
+*   пока эти байты не удалены Consume или Clear.
+*
+*   Каждый блок занимает диапазон [begin, end) своей памяти. Первый блок оставляет перед данными
+*   запас headroom, и Prepend пишет заголовок в него; если запаса не хватает, перед цепочкой
+*   встаёт новый блок, заполняемый с конца, так что данные сообщения тоже не двигаются.
+*
+*   IoVecs и FillIoVecs отдают непустые блоки массивом iovec для writev/sendmsg, а Consume(n)
+*   удаляет n отправленных байт с начала и освобождает целиком отправленные блоки.
+*/
+class ChainedBuffer {
+public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = size_t{ 64 } << 10;
+    static constexpr size_t DEFAULT_HEADROOM = 64;
+
+    explicit ChainedBuffer(size_t chunk_size = DEFAULT_CHUNK_SIZE, size_t headroom = DEFAULT_HEADROOM) noexcept
+        : chunk_size_(chunk_size)
+        , headroom_(headroom) {
+        assert(chunk_size > headroom);
+    }
+
+    ChainedBuffer(const ChainedBuffer&) = delete;
+    ChainedBuffer& operator=(const ChainedBuffer&) = delete;
+
+    ChainedBuffer(ChainedBuffer&& other) noexcept
+        : chunk_size_(other.chunk_size_)
+        , headroom_(other.headroom_) {
+        Swap(other);
+    }
+
+    ChainedBuffer& operator=(ChainedBuffer&& rhs) noexcept {
+        Swap(rhs);
+        return *this;
+    }
+
+    void Swap(ChainedBuffer& other) noexcept {
+        chunks_.Swap(other.chunks_);
+        std::swap(size_, other.size_);
+        std::swap(chunk_size_, other.chunk_size_);
+        std::swap(headroom_, other.headroom_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
+
+    size_t ChunkSize() const noexcept {
+        return chunk_size_;
+    }
+
+    //  Количество блоков в цепочке, включая пустые
+    size_t ChunkCount() const noexcept {
+        return chunks_.Size();
+    }
+
+    //  Удаляет все байты и освобождает блоки
+    void Clear() noexcept {
+        chunks_.Clear();
+        size_ = 0;
+    }
+
+    /*
+    *   Вид на запасную память последнего блока, в которой не меньше min_bytes байт (не больше ChunkSize()).
+    *   Если в последнем блоке места меньше, к цепочке добавляется новый блок. Первый блок
+    *   не оставляет запаса под Prepend, если иначе в нём не поместятся min_bytes байт.
+    */
+    Span<std::byte> WritableSpan(size_t min_bytes) {
+        assert(min_bytes <= chunk_size_);
+        if (chunks_.Size() == 0 || chunks_[chunks_.Size() - 1].Spare() < min_bytes) {
+            AddChunk(min_bytes);
+        }
+        Chunk& last = chunks_[chunks_.Size() - 1];
+        return Span<std::byte>(last.memory + last.end, last.Spare());
+    }
+
+    //  Делает частью буфера n байт, записанных в начало WritableSpan
+    void Commit(size_t n) noexcept {
+        assert(chunks_.Size() != 0 && n <= chunks_[chunks_.Size() - 1].Spare());
+        chunks_[chunks_.Size() - 1].end += n;
+        size_ += n;
+    }
+
+    //  Копирует size байт, заполняя последний блок и добавляя новые
+    void Append(const void* data, size_t size) {
+        const std::byte* bytes = static_cast<const std::byte*>(data);
+        while (size != 0) {
+            const Span<std::byte> spare = WritableSpan(1);
+            const size_t n = std::min(size, spare.Size());
+            std::memcpy(spare.Data(), bytes, n);
+            Commit(n);
+            bytes += n;
+            size -= n;
+        }
+    }
+
+    //  Значение целиком в одном блоке, младший байт первым
+    template <typename T>
+    void Append(T value) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "ChainedBuffer::Append<T> writes arithmetic and enum values");
+        std::byte* out = WritableSpan(sizeof(T)).Data();
+        std::memcpy(out, &value, sizeof(T));
+        if constexpr (!LITTLE_ENDIAN_HOST && sizeof(T) > 1) {
+            std::reverse(out, out + sizeof(T));
+        }
+        Commit(sizeof(T));
+    }
+
+    //  Присоединяет память ByteBuffer к концу цепочки отдельным блоком без копирования
+    void Append(ByteBlock&& block) {
+        if (block.size == 0) {
+            return;
+        }
+        const size_t size = block.size;
+        chunks_.PushBack(Chunk{ std::move(block.memory), 0, size });
+        block.size = 0;
+        size_ += size;
+    }
+
+    //  Записывает size байт перед началом буфера: в запас первого блока или в новые блоки перед ним
+    void Prepend(const void* data, size_t size) {
+        const std::byte* bytes = static_cast<const std::byte*>(data);
+        while (size != 0) {
+            if (chunks_.Size() == 0 || chunks_[0].begin == 0) {
+                RawMemory<std::byte> memory(chunk_size_);
+                chunks_.Insert(chunks_.begin(), Chunk{ std::move(memory), chunk_size_, chunk_size_ });
+            }
+            Chunk& first = chunks_[0];
+            // Заполняем запас с конца, чтобы байты шли в исходном порядке
+            const size_t n = std::min(size, first.begin);
+            first.begin -= n;
+            std::memcpy(first.memory + first.begin, bytes + size - n, n);
+            size -= n;
+            size_ += n;
+        }
+    }
+
+    template <typename T>
+    void Prepend(T value) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "ChainedBuffer::Prepend<T> writes arithmetic and enum values");
+        std::byte bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        if constexpr (!LITTLE_ENDIAN_HOST && sizeof(T) > 1) {
+            std::reverse(bytes, bytes + sizeof(T));
+        }
+        Prepend(bytes, sizeof(T));
+    }
+
+    //  Вызывает visit(Span<const std::byte>) для каждого непустого блока по порядку
+    template <typename Visit>
+    void ForEachChunk(Visit&& visit) const {
+        for (const Chunk& chunk : chunks_) {
+            if (chunk.end != chunk.begin) {
+                visit(Span<const std::byte>(chunk.memory + chunk.begin, chunk.end - chunk.begin));
+            }
+        }
+    }
+
+    /*
+    *   Записывает в out до max_count непустых блоков с начала буфера и возвращает их количество.
+    *   Для writev max_count обычно равен IOV_MAX; остаток отправляется после Consume.
+    */
+    size_t FillIoVecs(iovec* out, size_t max_count) const noexcept {
+        size_t count = 0;
+        for (size_t i = 0; i < chunks_.Size() && count < max_count; ++i) {
+            const Chunk& chunk = chunks_[i];
+            if (chunk.end != chunk.begin) {
+                // iovec описывает и чтение, и запись, поэтому его указатель неконстантный
+                out[count].iov_base = const_cast<std::byte*>(chunk.memory + chunk.begin);
+                out[count].iov_len = chunk.end - chunk.begin;
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    Vector<iovec> IoVecs() const {
+        Vector<iovec> iovecs;
+        iovecs.Reserve(chunks_.Size());
+        iovecs.CommitSpare(FillIoVecs(iovecs.SpareBegin(), chunks_.Size()));
+        return iovecs;
+    }
+
+    //  Удаляет n байт с начала буфера, например, после частичной записи writev
+    void Consume(size_t n) noexcept {
+        assert(n <= size_);
+        if (chunks_.Size() == 0) {
+            return;
+        }
+        size_ -= n;
+        // Целиком отправленные блоки в начале цепочки. Последний блок остаётся, чтобы запись продолжалась в его память
+        size_t consumed = 0;
+        for (; consumed < chunks_.Size(); ++consumed) {
+            Chunk& chunk = chunks_[consumed];
+            const size_t used = chunk.end - chunk.begin;
+            if (n < used || (n == used && consumed + 1 == chunks_.Size())) {
+                chunk.begin += n;
+                break;
+            }
+            n -= used;
+        }
+        if (consumed != 0) {
+            std::move(chunks_.begin() + consumed, chunks_.end(), chunks_.begin());
+            for (size_t i = 0; i < consumed; ++i) {
+                chunks_.PopBack();
+            }
+        }
+    }
+
+    //  Копирует все байты подряд в out, где должно быть место под Size() байт
+    void CopyTo(std::byte* out) const noexcept {
+        ForEachChunk([&out](Span<const std::byte> bytes) {
+            std::memcpy(out, bytes.Data(), bytes.Size());
+            out += bytes.Size();
+        });
+    }
+
+private:
+    struct Chunk {
+        RawMemory<std::byte> memory;
+        size_t begin = 0;
+        size_t end = 0;
+
+        size_t Spare() const noexcept {
+            return memory.Capacity() - end;
+        }
+    };
+
+    Vector<Chunk> chunks_;
+    size_t size_ = 0;
+    size_t chunk_size_;
+    size_t headroom_;
+
+    //  Новый пустой блок в конце цепочки с местом под min_bytes байт. Первый блок оставляет запас под Prepend
+    void AddChunk(size_t min_bytes) {
+        const size_t start = chunks_.Size() == 0 && headroom_ + min_bytes <= chunk_size_ ? headroom_ : 0;
+        RawMemory<std::byte> memory(chunk_size_);
+        chunks_.PushBack(Chunk{ std::move(memory), start, start });
+    }
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "soa_convert.h"
+#include "vector.h"
+
+/*
+*   Вектор с локальными частями для параллельных производителей.
+*
+*   Каждый поток добавляет элементы в свой собственный Vector без какой-либо синхронизации.
+*   Блокировка берётся только при первом обращении потока к вектору (или при переключении
+*   потока между несколькими CombinableVector одного типа), чтобы найти или создать его часть.
+*
+*   Merge вычисляет смещения частей, один раз резервирует память итогового вектора
+*   и перемещает части в его запасную вместимость параллельно: итоговый диапазон делится
+*   ForEachChunk на равные куски, по умолчанию не больше чем на hardware_concurrency потоков.
+*   Merge и Size читают чужие части, поэтому их нельзя вызывать одновременно с добавлением элементов.
+*/
+template <typename T>
+class CombinableVector {
+public:
+    CombinableVector()
+        : id_(NextId()) {
+    }
+
+    CombinableVector(const CombinableVector&) = delete;
+    CombinableVector& operator=(const CombinableVector&) = delete;
+
+    //  Возвращает вектор, принадлежащий текущему потоку
+    Vector<T>& Local() {
+        LocalCache& cache = Cache();
+        if (cache.id != id_) {
+            cache.values = &FindOrCreatePart();
+            cache.id = id_;
+        }
+        return *cache.values;
+    }
+
+    template <typename Type>
+    void PushBack(Type&& value) {
+        Local().PushBack(std::forward<Type>(value));
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        return Local().EmplaceBack(std::forward<Args>(args)...);
+    }
+
+    /*
+    *   Суммарное количество элементов во всех частях. Как и Merge, вызывается только после того,
+    *   как производители закончили добавление: блокировка не защищает части от их владельцев.
+    */
+    size_t Size() {
+        std::lock_guard lock(mutex_);
+        size_t total = 0;
+        for (const auto& part : parts_) {
+            total += part->values.Size();
+        }
+        return total;
+    }
+
+    /*
+    *   Перемещает элементы всех частей в один непрерывный вектор. Части остаются пустыми
+    *   и могут снова наполняться теми же потоками. Порядок частей соответствует порядку
+    *   первого обращения потоков к вектору. Перемещение выполняется не больше чем в max_threads потоках.
+    */
+    Vector<T> Merge(size_t max_threads = std::thread::hardware_concurrency()) {
+        std::lock_guard lock(mutex_);
+
+        Vector<size_t> offsets;
+        offsets.Reserve(parts_.Size());
+        size_t total = 0;
+        for (const auto& part : parts_) {
+            offsets.PushBack(total);
+            total += part->values.Size();
+        }
+
+        Vector<T> result;
+        result.Reserve(total);
+        T* destination = result.SpareBegin();
+
+        if constexpr (std::is_nothrow_move_constructible_v<T>) {
+            // Кусок [first, first + size) итогового вектора может начинаться в середине одной части и захватывать следующие
+            ForEachChunk(total, [this, destination, &offsets](size_t first, size_t size) {
+                if (size == 0) {
+                    return;
+                }
+                size_t part = static_cast<size_t>(std::upper_bound(offsets.begin(), offsets.end(), first) - offsets.begin()) - 1;
+                while (size != 0) {
+                    Vector<T>& values = parts_[part]->values;
+                    const size_t begin = first - offsets[part];
+                    const size_t n = std::min(size, values.Size() - begin);
+                    std::uninitialized_move_n(values.begin() + begin, n, destination + first);
+                    first += n;
+                    size -= n;
+                    ++part;
+                }
+            }, max_threads);
+        }
+        else {
+            // Перемещение может выбросить исключение, поэтому части переносятся последовательно
+            size_t constructed = 0;
+            try {
+                for (const auto& part : parts_) {
+                    std::uninitialized_move_n(part->values.begin(), part->values.Size(), destination + constructed);
+                    constructed += part->values.Size();
+                }
+            }
+            catch (...) {
+                std::destroy_n(destination, constructed);
+                throw;
+            }
+        }
+
+        result.CommitSpare(total);
+        for (auto& part : parts_) {
+            part->values.Clear();
+        }
+        return result;
+    }
+
+private:
+    struct Part {
+        std::thread::id owner;
+        Vector<T> values;
+    };
+
+    // Последняя часть, к которой обращался поток. id однозначно определяет CombinableVector
+    struct LocalCache {
+        uint64_t id = 0;
+        Vector<T>* values = nullptr;
+    };
+
+    const uint64_t id_;
+    std::mutex mutex_;
+    Vector<std::unique_ptr<Part>> parts_;
+
+    static uint64_t NextId() noexcept {
+        static std::atomic<uint64_t> next{ 1 };
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static LocalCache& Cache() noexcept {
+        thread_local LocalCache cache;
+        return cache;
+    }
+
+    Vector<T>& FindOrCreatePart() {
+        const std::thread::id self = std::this_thread::get_id();
+        std::lock_guard lock(mutex_);
+        for (auto& part : parts_) {
+            if (part->owner == self) {
+                return part->values;
+            }
+        }
+        auto& part = parts_.EmplaceBack(std::make_unique<Part>());
+        part->owner = self;
+        return part->values;
+    }
+};
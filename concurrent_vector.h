@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "vector.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+*   Вектор только для добавления, допускающий одновременный PushBack из многих потоков.
+*
+*   Элементы хранятся в сегментах геометрически растущего размера (32, 64, 128, ...),
+*   память каждого сегмента выделяется через RawMemory и никогда не перевыделяется,
+*   поэтому элементы не перемещаются, а ссылки на них остаются действительными.
+*
+*   Добавление элемента — атомарный fetch_add размера, конструирование элемента в своей ячейке
+*   и публикация флага готовности. Сегмент выделяется потоком, которому первым понадобилась
+*   ячейка в нём; если сегмент одновременно выделили несколько потоков, лишние копии освобождаются.
+*
+*   Ячейка занимается только тогда, когда элемент уже не может не появиться в ней: если конструктор T
+*   может выбросить исключение, элемент сначала конструируется вне вектора и затем перемещается
+*   в ячейку, поэтому такой T должен перемещаться без исключений. Сегмент для текущего размера
+*   выделяется до захвата ячейки, так что исключение из PushBack не оставляет в [0, Size()) дыр.
+*
+*   Читатели могут обращаться к опубликованным элементам одновременно с писателями.
+*   Size() учитывает и элементы, которые ещё конструируются, поэтому готовность ячейки
+*   проверяется IsReady или TryGet. Итерация и разрушение допускаются только после завершения писателей.
+*/
+template <typename T>
+class ConcurrentVector {
+private:
+    static constexpr size_t FIRST_SEGMENT_BITS = 5;
+    static constexpr size_t FIRST_SEGMENT_SIZE = size_t(1) << FIRST_SEGMENT_BITS;
+    static constexpr size_t MAX_SEGMENTS = sizeof(size_t) * 8 - FIRST_SEGMENT_BITS;
+
+    struct Segment {
+        explicit Segment(size_t capacity)
+            : values(capacity)
+            , ready(new std::atomic<bool>[capacity]()) {
+        }
+
+        RawMemory<T> values;
+        std::unique_ptr<std::atomic<bool>[]> ready;
+    };
+
+public:
+    class ConstIterator;
+
+    using const_iterator = ConstIterator;
+
+    ConcurrentVector() = default;
+
+    ConcurrentVector(const ConcurrentVector&) = delete;
+    ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+    ~ConcurrentVector() {
+        const size_t size = size_.load(std::memory_order_acquire);
+        for (size_t segment = 0; segment < MAX_SEGMENTS; ++segment) {
+            Segment* data = segments_[segment].load(std::memory_order_acquire);
+            if (data == nullptr) {
+                continue;
+            }
+            const size_t begin = SegmentBegin(segment);
+            const size_t count = begin < size ? std::min(data->values.Capacity(), size - begin) : 0;
+            for (size_t i = 0; i < count; ++i) {
+                // Писатели завершились, значит, каждая занятая ячейка опубликована
+                assert(data->ready[i].load(std::memory_order_acquire));
+                std::destroy_at(data->values + i);
+            }
+            delete data;
+        }
+    }
+
+    //  Добавляет элемент и возвращает его индекс. Безопасно вызывать из нескольких потоков
+    template <typename Type>
+    size_t PushBack(Type&& value) {
+        return EmplaceBack(std::forward<Type>(value));
+    }
+
+    template <typename... Args>
+    size_t EmplaceBack(Args&&... args) {
+        if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+            // Нехватка памяти под сегмент проявится здесь, пока ячейка ещё не занята
+            size_t offset = 0;
+            EnsureSegment(Locate(size_.load(std::memory_order_relaxed), offset));
+            return Publish(std::forward<Args>(args)...);
+        }
+        else {
+            static_assert(std::is_nothrow_move_constructible_v<T>,
+                "ConcurrentVector moves elements with a throwing constructor into claimed cells");
+            T value(std::forward<Args>(args)...);
+            return EmplaceBack(std::move(value));
+        }
+    }
+
+    //  Заранее выделяет сегменты, достаточные для хранения capacity элементов
+    void Reserve(size_t capacity) {
+        if (capacity == 0) {
+            return;
+        }
+        size_t offset = 0;
+        const size_t last = Locate(capacity - 1, offset);
+        for (size_t segment = 0; segment <= last; ++segment) {
+            EnsureSegment(segment);
+        }
+    }
+
+    //  Количество занятых ячеек, включая элементы, которые ещё конструируются
+    size_t Size() const noexcept {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    //  Проверяет, опубликован ли элемент с индексом index
+    bool IsReady(size_t index) const noexcept {
+        return TryGet(index) != nullptr;
+    }
+
+    //  Возвращает опубликованный элемент или nullptr, если элемент ещё не готов
+    const T* TryGet(size_t index) const noexcept {
+        size_t offset = 0;
+        const size_t segment = Locate(index, offset);
+        const Segment* data = segments_[segment].load(std::memory_order_acquire);
+        if (data == nullptr || !data->ready[offset].load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return data->values + offset;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<ConcurrentVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        size_t offset = 0;
+        Segment* data = segments_[Locate(index, offset)].load(std::memory_order_acquire);
+        assert(data != nullptr && data->ready[offset].load(std::memory_order_acquire));
+        return data->values[offset];
+    }
+
+    const_iterator begin() const noexcept {
+        return ConstIterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return ConstIterator(this, Size());
+    }
+
+    class ConstIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        ConstIterator() = default;
+
+        reference operator*() const noexcept {
+            return (*vector_)[index_];
+        }
+
+        pointer operator->() const noexcept {
+            return &(*vector_)[index_];
+        }
+
+        ConstIterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        ConstIterator operator++(int) noexcept {
+            ConstIterator tmp(*this);
+            ++index_;
+            return tmp;
+        }
+
+        bool operator==(const ConstIterator& rhs) const noexcept {
+            return index_ == rhs.index_;
+        }
+
+        bool operator!=(const ConstIterator& rhs) const noexcept {
+            return index_ != rhs.index_;
+        }
+
+    private:
+        friend class ConcurrentVector;
+
+        ConstIterator(const ConcurrentVector* vector, size_t index) noexcept
+            : vector_(vector)
+            , index_(index) {
+        }
+
+        const ConcurrentVector* vector_ = nullptr;
+        size_t index_ = 0;
+    };
+
+private:
+    std::atomic<size_t> size_{ 0 };
+    std::atomic<Segment*> segments_[MAX_SEGMENTS] = {};
+
+    static size_t FloorLog2(size_t value) noexcept {
+        assert(value != 0);
+#if defined(_MSC_VER)
+        unsigned long bit = 0;
+        _BitScanReverse64(&bit, value);
+        return bit;
+#else
+        return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(value);
+#endif
+    }
+
+    static size_t SegmentBegin(size_t segment) noexcept {
+        return (FIRST_SEGMENT_SIZE << segment) - FIRST_SEGMENT_SIZE;
+    }
+
+    // Возвращает номер сегмента, содержащего index, и смещение элемента в нём
+    static size_t Locate(size_t index, size_t& offset) noexcept {
+        const size_t biased = index + FIRST_SEGMENT_SIZE;
+        const size_t segment = FloorLog2(biased) - FIRST_SEGMENT_BITS;
+        offset = biased - (FIRST_SEGMENT_SIZE << segment);
+        return segment;
+    }
+
+    /*
+    *   Занимает ячейку и конструирует в ней элемент. Если другие писатели успели перейти в ещё
+    *   не выделенный сегмент, он выделяется после захвата ячейки; откатить захват нельзя,
+    *   поэтому нехватка памяти в этом случае завершает программу.
+    */
+    template <typename... Args>
+    size_t Publish(Args&&... args) noexcept {
+        const size_t index = size_.fetch_add(1, std::memory_order_relaxed);
+        size_t offset = 0;
+        Segment* segment = EnsureSegment(Locate(index, offset));
+        new (segment->values + offset) T(std::forward<Args>(args)...);
+        segment->ready[offset].store(true, std::memory_order_release);
+        return index;
+    }
+
+    Segment* EnsureSegment(size_t segment) {
+        Segment* data = segments_[segment].load(std::memory_order_acquire);
+        if (data != nullptr) {
+            return data;
+        }
+        auto allocated = std::make_unique<Segment>(FIRST_SEGMENT_SIZE << segment);
+        if (segments_[segment].compare_exchange_strong(data, allocated.get(), std::memory_order_acq_rel)) {
+            return allocated.release();
+        }
+        // Сегмент успел выделить другой поток
+        return data;
+    }
+};
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <utility>
+
+#include "vector.h"
+
+/*
+*   Вектор с копированием при записи.
+*   Копии CowVector разделяют один буфер со счётчиком ссылок, поэтому копирование выполняется за O(1).
+*   Перед первым изменяющим вызовом (неконстантный operator[], EmplaceBack, Erase, ...)
+*   разделяемый буфер клонируется, и дальше вектор владеет своей копией единолично.
+*
+*   Константные методы (константный operator[], Get, View, cbegin/cend) никогда не клонируют буфер.
+*   Неконстантные begin/end и operator[] клонируют, поэтому для чтения неконстантного вектора
+*   следует использовать Get, View и cbegin/cend.
+*
+*   Ссылки и итераторы, которые отдают неконстантные operator[], begin/end, Mutable, EmplaceBack,
+*   Emplace, Insert и Erase, позволяют менять буфер в обход CowVector. Поэтому такой буфер
+*   помечается неразделяемым: копия вектора клонирует его сразу за O(размер), и запись через старую
+*   ссылку не видна в копии. Пометка снимается, когда буфер заменяется новым или очищается.
+*   PushBack, PopBack, Reserve, Resize и ShrinkToFit ссылок не отдают и буфер не помечают.
+*
+*   Разные объекты CowVector, разделяющие буфер, можно использовать из разных потоков:
+*   счётчик ссылок атомарный. Один и тот же объект без синхронизации использовать нельзя.
+*/
+template <typename T>
+class CowVector {
+public:
+    using iterator = typename Vector<T>::iterator;
+    using const_iterator = typename Vector<T>::const_iterator;
+
+    CowVector() = default;
+
+    explicit CowVector(size_t size)
+        : shared_(new Shared(Vector<T>(size))) {
+    }
+
+    //  Забирает содержимое обычного вектора без копирования элементов
+    explicit CowVector(Vector<T>&& data)
+        : shared_(new Shared(std::move(data))) {
+    }
+
+    /*
+    *   Копирующий конструктор увеличивает счётчик ссылок и выполняется за O(1),
+    *   если только буфер other не помечен неразделяемым: тогда он клонируется.
+    */
+    CowVector(const CowVector& other) {
+        if (other.shared_ == nullptr) {
+            return;
+        }
+        if (other.shared_->shareable) {
+            shared_ = other.shared_;
+            shared_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            shared_ = new Shared(Vector<T>(other.shared_->data));
+        }
+    }
+
+    CowVector(CowVector&& other) noexcept {
+        Swap(other);
+    }
+
+    //  Неразделяемый буфер принадлежит одному объекту, поэтому совпадение буферов означает самоприсваивание
+    CowVector& operator=(const CowVector& rhs) {
+        if (shared_ != rhs.shared_) {
+            CowVector tmp(rhs);
+            Swap(tmp);
+        }
+        return *this;
+    }
+
+    CowVector& operator=(CowVector&& rhs) noexcept {
+        Swap(rhs);
+        return *this;
+    }
+
+    ~CowVector() {
+        Release(shared_);
+    }
+
+    void Swap(CowVector& other) noexcept {
+        std::swap(shared_, other.shared_);
+    }
+
+    /* МЕТОДЫ ЧТЕНИЯ. Никогда не клонируют буфер */
+
+    size_t Size() const noexcept {
+        return shared_ != nullptr ? shared_->data.Size() : 0;
+    }
+
+    size_t Capacity() const noexcept {
+        return shared_ != nullptr ? shared_->data.Capacity() : 0;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return View()[index];
+    }
+
+    //  Явный способ прочитать элемент неконстантного вектора без клонирования буфера
+    const T& Get(size_t index) const noexcept {
+        return View()[index];
+    }
+
+    //  Возвращает разделяемый вектор только для чтения
+    const Vector<T>& View() const noexcept {
+        return shared_ != nullptr ? shared_->data : Empty();
+    }
+
+    //  Количество объектов CowVector, разделяющих буфер
+    size_t UseCount() const noexcept {
+        return shared_ != nullptr ? shared_->refs.load(std::memory_order_acquire) : 0;
+    }
+
+    const_iterator begin() const noexcept {
+        return View().begin();
+    }
+
+    const_iterator end() const noexcept {
+        return View().end();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return View().cbegin();
+    }
+
+    const_iterator cend() const noexcept {
+        return View().cend();
+    }
+
+    /* ИЗМЕНЯЮЩИЕ МЕТОДЫ. Клонируют буфер, если он разделяется с другими векторами */
+
+    //  Возвращает вектор, которым этот объект владеет единолично. Буфер помечается неразделяемым
+    Vector<T>& Mutable() {
+        Detach();
+        shared_->shareable = false;
+        return shared_->data;
+    }
+
+    T& operator[](size_t index) {
+        return Mutable()[index];
+    }
+
+    iterator begin() {
+        return Mutable().begin();
+    }
+
+    iterator end() {
+        return Mutable().end();
+    }
+
+    void Reserve(size_t new_capacity) {
+        Unique().Reserve(new_capacity);
+    }
+
+    void Resize(size_t new_size) {
+        Unique().Resize(new_size);
+    }
+
+    void ShrinkToFit() {
+        Unique().ShrinkToFit();
+    }
+
+    //  Очистка разделяемого вектора не клонирует буфер, а просто отказывается от него
+    void Clear() {
+        if (UseCount() > 1) {
+            CowVector tmp;
+            Swap(tmp);
+        }
+        else if (shared_ != nullptr) {
+            // Ссылок на элементы очищенного буфера больше нет
+            shared_->data.Clear();
+            shared_->shareable = true;
+        }
+    }
+
+    template <typename Type>
+    void PushBack(Type&& value) {
+        Unique().EmplaceBack(std::forward<Type>(value));
+    }
+
+    void PopBack() {
+        Unique().PopBack();
+    }
+
+    /*
+    *   Аргументы могут ссылаться на элементы разделяемого буфера, поэтому они передаются
+    *   в EmplaceBack клона: старый буфер продолжает жить, пока его держат другие векторы.
+    */
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        return Mutable().EmplaceBack(std::forward<Args>(args)...);
+    }
+
+    /*
+    *   Позиция pos может указывать в разделяемый буфер, поэтому она пересчитывается
+    *   в смещение до клонирования.
+    */
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        const size_t offset = pos - cbegin();
+        Vector<T>& data = Mutable();
+        return data.Emplace(data.cbegin() + offset, std::forward<Args>(args)...);
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    iterator Erase(const_iterator pos) {
+        const size_t offset = pos - cbegin();
+        Vector<T>& data = Mutable();
+        return data.Erase(data.cbegin() + offset);
+    }
+
+    iterator EraseUnordered(const_iterator pos) {
+        const size_t offset = pos - cbegin();
+        Vector<T>& data = Mutable();
+        return data.EraseUnordered(data.cbegin() + offset);
+    }
+
+    template <typename RandomIt>
+    void EraseUnordered(RandomIt first, RandomIt last) {
+        Unique().EraseUnordered(first, last);
+    }
+
+private:
+    struct Shared {
+        explicit Shared(Vector<T>&& data)
+            : data(std::move(data)) {
+        }
+
+        std::atomic<size_t> refs{ 1 };
+        Vector<T> data;
+        // false, если наружу отданы изменяемые ссылки или итераторы. Такой буфер всегда единоличный
+        bool shareable = true;
+    };
+
+    Shared* shared_ = nullptr;
+
+    static const Vector<T>& Empty() noexcept {
+        static const Vector<T> empty;
+        return empty;
+    }
+
+    static void Release(Shared* shared) noexcept {
+        if (shared != nullptr && shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete shared;
+        }
+    }
+
+    //  Единоличный буфер для изменений, которые не отдают ссылок наружу
+    Vector<T>& Unique() {
+        Detach();
+        return shared_->data;
+    }
+
+    //  Делает буфер единоличным: клонирует его, если на него ссылаются другие векторы
+    void Detach() {
+        if (shared_ == nullptr) {
+            shared_ = new Shared(Vector<T>());
+        }
+        else if (shared_->refs.load(std::memory_order_acquire) != 1) {
+            Shared* clone = new Shared(Vector<T>(shared_->data));
+            Release(std::exchange(shared_, clone));
+        }
+    }
+};
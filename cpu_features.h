@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FV_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define FV_X86 0
+#endif
+
+/*
+*   FV_TARGET включает набор инструкций для одной функции, не меняя флагов сборки всего файла,
+*   поэтому векторные ядра разных уровней собираются рядом и выбираются во время выполнения.
+*   MSVC разрешает интринсики в любой функции, и атрибут ему не нужен.
+*
+*   FV_FORCE_INLINE помечает обобщённые ядра: они встраиваются в обёртку с нужным FV_TARGET
+*   и компилируются уже с её набором инструкций.
+*/
+#if defined(_MSC_VER) && !defined(__clang__)
+#define FV_TARGET(isa)
+#define FV_FORCE_INLINE __forceinline
+#else
+#define FV_TARGET(isa) __attribute__((target(isa)))
+#define FV_FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+// Расширения AVX-512, из которых состоит уровень IsaLevel::Avx512
+#define FV_AVX512 "avx512f,avx512dq,avx512bw,avx512vl"
+
+/*
+*   Уровни наборов инструкций, для которых собираются векторные ядра. Каждый уровень включает предыдущие.
+*   Sse42 — SSE4.2 и POPCNT, Avx2 — AVX2, FMA и POPCNT, Avx512 — AVX-512 F/BW/DQ/VL.
+*/
+enum class IsaLevel {
+    Scalar,
+    Sse42,
+    Avx2,
+    Avx512
+};
+
+inline const char* IsaName(IsaLevel level) noexcept {
+    switch (level) {
+    case IsaLevel::Sse42:
+        return "sse4.2";
+    case IsaLevel::Avx2:
+        return "avx2";
+    case IsaLevel::Avx512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+#if FV_X86
+//  Выполняет CPUID для листа leaf и подлиста subleaf, записывая EAX, EBX, ECX, EDX в regs
+inline void Cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) noexcept {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) {
+        regs[i] = static_cast<uint32_t>(info[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+#endif
+
+/*
+*   Определяет старший уровень, который поддерживают и процессор (CPUID), и операционная система:
+*   ОС должна сохранять расширенные регистры при переключении контекста (XGETBV).
+*/
+inline IsaLevel DetectIsaLevel() noexcept {
+#if FV_X86
+    auto xgetbv = []() -> uint64_t {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32_t eax = 0;
+        uint32_t edx = 0;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    };
+    auto has = [](uint32_t reg, int bit) {
+        return ((reg >> bit) & 1) != 0;
+    };
+
+    uint32_t regs[4] = {};
+    Cpuid(0, 0, regs);
+    const uint32_t max_leaf = regs[0];
+    Cpuid(1, 0, regs);
+    const uint32_t ecx1 = regs[2];
+    if (!has(ecx1, 20) || !has(ecx1, 23)) {
+        return IsaLevel::Scalar;
+    }
+    // AVX2 и FMA работают с регистрами YMM: нужны OSXSAVE и сохранение ОС регистров XMM и YMM
+    if (!has(ecx1, 27) || !has(ecx1, 28) || !has(ecx1, 12) || max_leaf < 7 || (xgetbv() & 0x6) != 0x6) {
+        return IsaLevel::Sse42;
+    }
+    Cpuid(7, 0, regs);
+    const uint32_t ebx7 = regs[1];
+    if (!has(ebx7, 5)) {
+        return IsaLevel::Sse42;
+    }
+    // AVX-512 F, DQ, BW, VL и сохранение ОС регистров масок и ZMM
+    if (has(ebx7, 16) && has(ebx7, 17) && has(ebx7, 30) && has(ebx7, 31) && (xgetbv() & 0xE6) == 0xE6) {
+        return IsaLevel::Avx512;
+    }
+    return IsaLevel::Avx2;
+#else
+    return IsaLevel::Scalar;
+#endif
+}
+
+//  Уровень текущего процессора. Определяется один раз при первом обращении
+inline IsaLevel CpuIsaLevel() noexcept {
+    static const IsaLevel level = DetectIsaLevel();
+    return level;
+}
+
+/*
+*   Размер кэша последнего уровня в байтах по описанию кэшей в CPUID: лист 4 у Intel,
+*   лист 0x8000001D у AMD. Возвращает 0, если процессор кэши не описывает.
+*/
+inline size_t DetectLastLevelCacheSize() noexcept {
+#if FV_X86
+    auto largest_cache = [](uint32_t leaf) {
+        size_t largest = 0;
+        uint32_t regs[4] = {};
+        for (uint32_t subleaf = 0; subleaf < 16; ++subleaf) {
+            Cpuid(leaf, subleaf, regs);
+            // Тип кэша 0 означает, что описания закончились
+            if ((regs[0] & 0x1F) == 0) {
+                break;
+            }
+            const size_t ways = ((regs[1] >> 22) & 0x3FF) + 1;
+            const size_t partitions = ((regs[1] >> 12) & 0x3FF) + 1;
+            const size_t line = (regs[1] & 0xFFF) + 1;
+            const size_t sets = static_cast<size_t>(regs[2]) + 1;
+            largest = std::max(largest, ways * partitions * line * sets);
+        }
+        return largest;
+    };
+
+    uint32_t regs[4] = {};
+    Cpuid(0, 0, regs);
+    if (regs[0] >= 4) {
+        if (const size_t size = largest_cache(4); size != 0) {
+            return size;
+        }
+    }
+    Cpuid(0x80000000, 0, regs);
+    if (regs[0] >= 0x8000001D) {
+        return largest_cache(0x8000001D);
+    }
+#endif
+    return 0;
+}
+
+//  Размер кэша последнего уровня текущего процессора. Определяется один раз при первом обращении
+inline size_t LastLevelCacheSize() noexcept {
+    static const size_t size = DetectLastLevelCacheSize();
+    return size;
+}
+
+inline int CountTrailingZeros(uint32_t mask) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long bit = 0;
+    _BitScanForward(&bit, mask);
+    return static_cast<int>(bit);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline int PopCount(uint32_t mask) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int count = 0;
+    for (; mask != 0; mask &= mask - 1) {
+        ++count;
+    }
+    return count;
+#else
+    return __builtin_popcount(mask);
+#endif
+}
+
+inline int CountTrailingZeros64(uint64_t word) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long bit = 0;
+    _BitScanForward64(&bit, word);
+    return static_cast<int>(bit);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+inline int PopCount64(uint64_t word) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return PopCount(static_cast<uint32_t>(word)) + PopCount(static_cast<uint32_t>(word >> 32));
+#else
+    return __builtin_popcountll(word);
+#endif
+}
@@ -0,0 +1,417 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "bit_vector.h"
+#include "span.h"
+#include "vector.h"
+#include "vector_search.h"
+
+/*
+*   Ширина кодов DictVector. Коды начинают с 8 бит и расширяются до 16 и 32 бит,
+*   когда словарь перестаёт помещаться в текущую ширину.
+*/
+enum class CodeWidth {
+    Bits8,
+    Bits16,
+    Bits32
+};
+
+/*
+*   Вектор со словарным кодированием для столбцов с небольшим числом различных значений.
+*
+*   Каждое различное значение хранится в словаре один раз, а строка вектора — это его номер (код)
+*   в словаре. Коды занимают 8 бит, пока в словаре не больше 256 значений, затем 16 и 32 бита;
+*   при расширении все коды переписываются один раз. Значения в словаре не удаляются.
+*
+*   Условия проверяются по словарю, а не по строкам: Where(pred) вызывает pred один раз на значение
+*   словаря и затем просматривает только целочисленные коды, возвращая маску строк в BitVector.
+*   Ссылки, которые возвращают Get и итераторы, указывают в словарь и действительны,
+*   пока в словарь не добавлено новое значение.
+*
+*   Индекс для поиска кода по значению — хеш-таблица с открытой адресацией, в ячейках которой
+*   лежат только коды: хеш и сравнение берут значение из словаря, поэтому каждое значение
+*   хранится один раз. Таблица заполнена не больше чем наполовину.
+*/
+template <typename T, typename Hash = std::hash<T>>
+class DictVector {
+public:
+    //  Код, которого нет в словаре
+    static constexpr uint32_t NO_CODE = static_cast<uint32_t>(-1);
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        reference operator*() const noexcept {
+            return owner_->Get(index_);
+        }
+
+        pointer operator->() const noexcept {
+            return &owner_->Get(index_);
+        }
+
+        const_iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept {
+            const_iterator copy(*this);
+            ++index_;
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const noexcept {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const const_iterator& other) const noexcept {
+            return index_ != other.index_;
+        }
+
+    private:
+        friend class DictVector;
+
+        const_iterator(const DictVector* owner, size_t index) noexcept
+            : owner_(owner)
+            , index_(index) {
+        }
+
+        const DictVector* owner_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    DictVector() = default;
+
+    DictVector(const DictVector&) = default;
+
+    DictVector(DictVector&& other) noexcept {
+        Swap(other);
+    }
+
+    DictVector& operator=(const DictVector& rhs) {
+        if (this != &rhs) {
+            DictVector copy(rhs);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    DictVector& operator=(DictVector&& rhs) noexcept {
+        Swap(rhs);
+        return *this;
+    }
+
+    void Swap(DictVector& other) noexcept {
+        codes8_.Swap(other.codes8_);
+        codes16_.Swap(other.codes16_);
+        codes32_.Swap(other.codes32_);
+        dictionary_.Swap(other.dictionary_);
+        slots_.Swap(other.slots_);
+        std::swap(slot_bits_, other.slot_bits_);
+        std::swap(hash_, other.hash_);
+        std::swap(width_, other.width_);
+        std::swap(size_, other.size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
+
+    CodeWidth GetCodeWidth() const noexcept {
+        return width_;
+    }
+
+    //  Различные значения в порядке первого появления: код значения — его индекс
+    Span<const T> Dictionary() const noexcept {
+        return Span<const T>(dictionary_.begin(), dictionary_.Size());
+    }
+
+    size_t DictionarySize() const noexcept {
+        return dictionary_.Size();
+    }
+
+    void Reserve(size_t new_capacity) {
+        VisitCodes([new_capacity](auto& codes) {
+            codes.Reserve(new_capacity);
+        });
+    }
+
+    //  Удаляет строки и словарь
+    void Clear() noexcept {
+        codes8_.Clear();
+        codes16_.Clear();
+        codes32_.Clear();
+        dictionary_.Clear();
+        std::fill(slots_.begin(), slots_.end(), NO_CODE);
+        width_ = CodeWidth::Bits8;
+        size_ = 0;
+    }
+
+    /*
+    *   Добавляет строку со значением, сконструированным из args. Значение ищется в словаре
+    *   и добавляется в него, если его там ещё нет. Возвращает ссылку на значение в словаре.
+    */
+    template <typename... Args>
+    const T& EmplaceBack(Args&&... args) {
+        T value(std::forward<Args>(args)...);
+        const uint32_t code = Encode(std::move(value));
+        VisitCodes([code](auto& codes) {
+            using Code = std::remove_reference_t<decltype(codes[0])>;
+            codes.PushBack(static_cast<Code>(code));
+        });
+        ++size_;
+        return dictionary_[code];
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        VisitCodes([](auto& codes) {
+            codes.PopBack();
+        });
+        --size_;
+    }
+
+    uint32_t CodeAt(size_t index) const noexcept {
+        assert(index < size_);
+        switch (width_) {
+        case CodeWidth::Bits8:
+            return codes8_[index];
+        case CodeWidth::Bits16:
+            return codes16_[index];
+        default:
+            return codes32_[index];
+        }
+    }
+
+    const T& Get(size_t index) const noexcept {
+        return dictionary_[CodeAt(index)];
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return Get(index);
+    }
+
+    //  Код значения value либо NO_CODE, если такого значения в векторе нет
+    uint32_t FindCode(const T& value) const {
+        if (slots_.Size() == 0) {
+            return NO_CODE;
+        }
+        return slots_[FindSlot(value, hash_(value))];
+    }
+
+    /*
+    *   Маска строк, значения которых удовлетворяют pred. pred вызывается один раз
+    *   для каждого значения словаря, а строки сравниваются по кодам.
+    */
+    template <typename Predicate>
+    BitVector Where(Predicate pred) const {
+        Vector<uint8_t> matches(dictionary_.Size());
+        bool any = false;
+        for (size_t code = 0; code < dictionary_.Size(); ++code) {
+            matches[code] = pred(dictionary_[code]) ? 1 : 0;
+            any = any || matches[code] != 0;
+        }
+        BitVector mask(size_);
+        if (any) {
+            VisitCodes([&mask, &matches](const auto& codes) {
+                FillMask(codes, [&matches](uint32_t code) {
+                    return matches[code] != 0;
+                }, mask);
+            });
+        }
+        return mask;
+    }
+
+    //  Маска строк, равных value: одно сравнение кода на строку
+    BitVector Equal(const T& value) const {
+        BitVector mask(size_);
+        const uint32_t code = FindCode(value);
+        if (code != NO_CODE) {
+            VisitCodes([&mask, code](const auto& codes) {
+                FillMask(codes, [code](uint32_t row_code) {
+                    return row_code == code;
+                }, mask);
+            });
+        }
+        return mask;
+    }
+
+    //  Количество строк, равных value
+    size_t Count(const T& value) const {
+        const uint32_t code = FindCode(value);
+        if (code == NO_CODE) {
+            return 0;
+        }
+        return VisitCodes([code](const auto& codes) {
+            size_t count = 0;
+            for (auto row_code : codes) {
+                count += row_code == code ? 1 : 0;
+            }
+            return count;
+        });
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+
+private:
+    // Наименьшая таблица индекса — 2^MIN_SLOT_BITS ячеек
+    static constexpr size_t MIN_SLOT_BITS = 4;
+
+    Vector<uint8_t> codes8_;
+    Vector<uint16_t> codes16_;
+    Vector<uint32_t> codes32_;
+    Vector<T> dictionary_;
+    // Ячейки индекса: код значения либо NO_CODE. Размер таблицы — 2^slot_bits_ или 0
+    Vector<uint32_t> slots_;
+    size_t slot_bits_ = 0;
+    Hash hash_;
+    CodeWidth width_ = CodeWidth::Bits8;
+    size_t size_ = 0;
+
+    //  Вызывает visit для вектора кодов текущей ширины
+    template <typename Visit>
+    decltype(auto) VisitCodes(Visit&& visit) {
+        switch (width_) {
+        case CodeWidth::Bits8:
+            return visit(codes8_);
+        case CodeWidth::Bits16:
+            return visit(codes16_);
+        default:
+            return visit(codes32_);
+        }
+    }
+
+    template <typename Visit>
+    decltype(auto) VisitCodes(Visit&& visit) const {
+        switch (width_) {
+        case CodeWidth::Bits8:
+            return visit(codes8_);
+        case CodeWidth::Bits16:
+            return visit(codes16_);
+        default:
+            return visit(codes32_);
+        }
+    }
+
+    //  Записывает в mask по 64 строки за раз: бит строки i равен matches(codes[i])
+    template <typename Codes, typename Matches>
+    static void FillMask(const Codes& codes, Matches matches, BitVector& mask) {
+        const size_t size = codes.Size();
+        for (size_t first = 0; first < size; first += BITS_PER_WORD) {
+            const size_t last = std::min(size, first + BITS_PER_WORD);
+            uint64_t word = 0;
+            for (size_t i = first; i < last; ++i) {
+                word |= uint64_t{ matches(codes[i]) } << (i - first);
+            }
+            if (word != 0) {
+                mask.SetWord(first / BITS_PER_WORD, word);
+            }
+        }
+    }
+
+    //  Первая ячейка пробирования: старшие биты произведения на 2^64 / φ перемешивают и слабые хеши
+    static size_t FirstSlot(size_t hash, size_t slot_bits) noexcept {
+        return static_cast<size_t>((uint64_t{ hash } * 0x9E3779B97F4A7C15ull) >> (64 - slot_bits));
+    }
+
+    //  Ячейка с кодом value либо пустая ячейка, в которую этот код следует записать
+    size_t FindSlot(const T& value, size_t hash) const {
+        const size_t mask = slots_.Size() - 1;
+        for (size_t slot = FirstSlot(hash, slot_bits_);; slot = (slot + 1) & mask) {
+            const uint32_t code = slots_[slot];
+            if (code == NO_CODE || dictionary_[code] == value) {
+                return slot;
+            }
+        }
+    }
+
+    //  Перестраивает индекс в таблицу из 2^slot_bits ячеек. Значения словаря различны, поэтому не сравниваются
+    void Rehash(size_t slot_bits) {
+        Vector<uint32_t> slots(size_t{ 1 } << slot_bits, NO_CODE);
+        const size_t mask = slots.Size() - 1;
+        for (size_t code = 0; code < dictionary_.Size(); ++code) {
+            size_t slot = FirstSlot(hash_(dictionary_[code]), slot_bits);
+            while (slots[slot] != NO_CODE) {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = static_cast<uint32_t>(code);
+        }
+        slots_.Swap(slots);
+        slot_bits_ = slot_bits;
+    }
+
+    //  Код значения, добавленного в словарь при необходимости. Расширяет коды, если новый код в них не помещается
+    uint32_t Encode(T&& value) {
+        const size_t hash = hash_(value);
+        size_t slot = 0;
+        if (slots_.Size() != 0) {
+            slot = FindSlot(value, hash);
+            if (slots_[slot] != NO_CODE) {
+                return slots_[slot];
+            }
+        }
+        const uint32_t code = static_cast<uint32_t>(dictionary_.Size());
+        assert(code != NO_CODE);
+        if ((dictionary_.Size() + 1) * 2 > slots_.Size()) {
+            Rehash(std::max<size_t>(MIN_SLOT_BITS, slot_bits_ + 1));
+            slot = FindSlot(value, hash);
+        }
+        if (width_ == CodeWidth::Bits8 && code > UINT8_MAX) {
+            Widen(codes8_, codes16_);
+            width_ = CodeWidth::Bits16;
+        }
+        else if (width_ == CodeWidth::Bits16 && code > UINT16_MAX) {
+            Widen(codes16_, codes32_);
+            width_ = CodeWidth::Bits32;
+        }
+        dictionary_.PushBack(std::move(value));
+        slots_[slot] = code;
+        return code;
+    }
+
+    //  Переписывает коды в более широкие, оставляя запас под рост
+    template <typename Narrow, typename Wide>
+    static void Widen(Vector<Narrow>& narrow, Vector<Wide>& wide) {
+        Vector<Wide> widened;
+        widened.Reserve(std::max(narrow.Capacity(), narrow.Size() + 1));
+        Wide* out = widened.SpareBegin();
+        for (size_t i = 0; i < narrow.Size(); ++i) {
+            out[i] = narrow[i];
+        }
+        widened.CommitSpare(narrow.Size());
+        wide.Swap(widened);
+        Vector<Narrow>().Swap(narrow);
+    }
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "vector.h"
+
+/*
+*   Освобождение памяти на основе эпох (epoch-based reclamation).
+*
+*   Читатель входит в критическую секцию (Enter), записывая в свой слот текущую глобальную эпоху,
+*   и выходит из неё, обнуляя слот. Писатель, заменивший разделяемый объект новым,
+*   передаёт старый объект в Retire. Объект, выведенный из оборота в эпоху R, освобождается,
+*   когда ни один активный читатель не вошёл в свою секцию в эпоху R или раньше:
+*   читатели, вошедшие позже, уже не могут увидеть старый объект.
+*
+*   Читатели не берут блокировок: вход и выход из секции — две атомарные записи в свой слот.
+*   Слоты выровнены по строке кэша, чтобы читатели разных потоков не мешали друг другу.
+*/
+class EpochDomain {
+public:
+    static constexpr size_t MAX_THREADS = 256;
+
+    // Критическая секция читателя. Секции одного потока могут быть вложенными
+    class Guard {
+    public:
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        Guard(Guard&& other) noexcept
+            : domain_(std::exchange(other.domain_, nullptr)) {
+        }
+
+        Guard& operator=(Guard&& rhs) noexcept {
+            std::swap(domain_, rhs.domain_);
+            return *this;
+        }
+
+        ~Guard() {
+            if (domain_ != nullptr) {
+                domain_->Leave();
+            }
+        }
+
+    private:
+        friend class EpochDomain;
+
+        explicit Guard(EpochDomain* domain) noexcept
+            : domain_(domain) {
+        }
+
+        EpochDomain* domain_;
+    };
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    static EpochDomain& Global() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    Guard Enter() {
+        ThreadState& state = LocalState();
+        if (state.depth++ == 0) {
+            state.slot->epoch.store(epoch_.load());
+        }
+        return Guard(this);
+    }
+
+    //  Передаёт объект на отложенное освобождение функцией deleter
+    void Retire(void* object, void (*deleter)(void*)) {
+        std::lock_guard lock(mutex_);
+        retired_.push_back({ object, deleter, epoch_.fetch_add(1) });
+        ReclaimLocked();
+    }
+
+    //  Освобождает объекты, которые больше не видит ни один читатель. Возвращает их количество
+    size_t Reclaim() {
+        std::lock_guard lock(mutex_);
+        return ReclaimLocked();
+    }
+
+    //  Дожидается освобождения всех переданных объектов. Нельзя вызывать внутри секции читателя
+    void Synchronize() {
+        while (true) {
+            {
+                std::lock_guard lock(mutex_);
+                ReclaimLocked();
+                if (retired_.empty()) {
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    size_t RetiredCount() {
+        std::lock_guard lock(mutex_);
+        return retired_.size();
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        // Эпоха входа читателя в секцию, 0 — читатель вне секции
+        std::atomic<uint64_t> epoch{ 0 };
+        std::atomic<bool> in_use{ false };
+    };
+
+    struct Retired {
+        void* object;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    // Слот закрепляется за потоком при первом входе в секцию и освобождается при завершении потока
+    struct ThreadState {
+        ~ThreadState() {
+            if (slot != nullptr) {
+                slot->in_use.store(false, std::memory_order_release);
+            }
+        }
+
+        Slot* slot = nullptr;
+        size_t depth = 0;
+    };
+
+    Slot slots_[MAX_THREADS];
+    std::atomic<uint64_t> epoch_{ 1 };
+    std::mutex mutex_;
+    std::vector<Retired> retired_;
+
+    EpochDomain() = default;
+
+    ~EpochDomain() {
+        for (const Retired& retired : retired_) {
+            retired.deleter(retired.object);
+        }
+    }
+
+    ThreadState& LocalState() {
+        thread_local ThreadState state;
+        if (state.slot == nullptr) {
+            state.slot = AcquireSlot();
+        }
+        return state;
+    }
+
+    // Занимает свободный слот. Если все слоты заняты, ждёт завершения других потоков-читателей
+    Slot* AcquireSlot() {
+        while (true) {
+            for (Slot& slot : slots_) {
+                bool expected = false;
+                if (!slot.in_use.load(std::memory_order_relaxed)
+                    && slot.in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return &slot;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void Leave() noexcept {
+        ThreadState& state = LocalState();
+        assert(state.depth > 0);
+        if (--state.depth == 0) {
+            state.slot->epoch.store(0);
+        }
+    }
+
+    size_t ReclaimLocked() {
+        uint64_t oldest = UINT64_MAX;
+        for (const Slot& slot : slots_) {
+            const uint64_t epoch = slot.epoch.load();
+            if (epoch != 0 && epoch < oldest) {
+                oldest = epoch;
+            }
+        }
+
+        size_t reclaimed = 0;
+        for (size_t i = 0; i < retired_.size();) {
+            if (retired_[i].epoch < oldest) {
+                retired_[i].deleter(retired_[i].object);
+                retired_[i] = retired_.back();
+                retired_.pop_back();
+                ++reclaimed;
+            }
+            else {
+                ++i;
+            }
+        }
+        return reclaimed;
+    }
+};
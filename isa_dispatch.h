@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#include "cpu_features.h"
+
+/*
+*   Выбор векторных ядер во время выполнения.
+*
+*   Семейство ядер (поиск, свёртки, заполнение, ...) описывает свою таблицу указателей на функции
+*   и собирает по таблице на каждый уровень, для которого у него есть ядра. IsaDispatch хранит
+*   эти таблицы и выдаёт таблицу старшего уровня, не превышающего запрошенный.
+*   Семейства кэшируют активную таблицу в статической переменной, поэтому выбор выполняется
+*   один раз, а вызов ядра — это один косвенный вызов.
+*
+*   Активный уровень — уровень процессора, который можно понизить переменной окружения FV_ISA
+*   (scalar, sse4.2, avx2, avx512), например, чтобы сравнить уровни в бенчмарке
+*   или воспроизвести результат на другой машине. Повысить уровень выше поддерживаемого нельзя.
+*/
+
+inline constexpr size_t ISA_LEVEL_COUNT = 4;
+inline constexpr const char* ISA_ENVIRONMENT_VARIABLE = "FV_ISA";
+
+//  Разбирает имя уровня, которое возвращает IsaName. Возвращает false для неизвестного имени
+inline bool ParseIsaLevel(const char* name, IsaLevel& level) noexcept {
+    for (size_t i = 0; i < ISA_LEVEL_COUNT; ++i) {
+        const auto candidate = static_cast<IsaLevel>(i);
+        if (std::strcmp(name, IsaName(candidate)) == 0) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+//  Уровень с учётом запроса requested (может быть nullptr): запрос может только понизить уровень процессора
+inline IsaLevel ResolveIsaLevel(IsaLevel cpu, const char* requested) noexcept {
+    IsaLevel level = cpu;
+    if (requested != nullptr && ParseIsaLevel(requested, level) && level < cpu) {
+        return level;
+    }
+    return cpu;
+}
+
+//  Уровень, по которому выбираются ядра. Определяется один раз при первом обращении
+inline IsaLevel ActiveIsaLevel() noexcept {
+    static const IsaLevel level = ResolveIsaLevel(CpuIsaLevel(), std::getenv(ISA_ENVIRONMENT_VARIABLE));
+    return level;
+}
+
+/*
+*   Таблицы ядер одного семейства по уровням. Таблица скалярного уровня обязательна,
+*   остальные могут отсутствовать — тогда используется ближайший младший уровень.
+*/
+template <typename Table>
+class IsaDispatch {
+public:
+    constexpr explicit IsaDispatch(const Table* scalar, const Table* sse42 = nullptr,
+        const Table* avx2 = nullptr, const Table* avx512 = nullptr) noexcept
+        : tables_{ scalar, sse42, avx2, avx512 } {
+    }
+
+    const Table& ForLevel(IsaLevel level) const noexcept {
+        for (size_t i = static_cast<size_t>(level); i > 0; --i) {
+            if (tables_[i] != nullptr) {
+                return *tables_[i];
+            }
+        }
+        return *tables_[0];
+    }
+
+    const Table& Active() const noexcept {
+        return ForLevel(ActiveIsaLevel());
+    }
+
+    //  Есть ли у семейства собственные ядра уровня level
+    bool HasLevel(IsaLevel level) const noexcept {
+        return tables_[static_cast<size_t>(level)] != nullptr;
+    }
+
+    /*
+    *   Вызывает visit(level, table) для каждого уровня с собственными ядрами,
+    *   который поддерживает процессор. Предназначен для тестов и бенчмарков, сравнивающих уровни.
+    */
+    template <typename Visitor>
+    void ForEachLevel(Visitor&& visit) const {
+        for (size_t i = 0; i <= static_cast<size_t>(CpuIsaLevel()); ++i) {
+            if (tables_[i] != nullptr) {
+                visit(static_cast<IsaLevel>(i), *tables_[i]);
+            }
+        }
+    }
+
+private:
+    const Table* tables_[ISA_LEVEL_COUNT];
+};
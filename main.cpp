@@ -3,8 +3,36 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <thread>
 
 #include "vector.h"
+#include "cow_vector.h"
+#include "persistent_vector.h"
+#include "concurrent_vector.h"
+#include "rcu_vector.h"
+#include "combinable_vector.h"
+#include "padded_vector.h"
+#include "ring_buffer.h"
+#include "isa_dispatch.h"
+#include "memory_kernels.h"
+#include "span.h"
+#include "soa_vector.h"
+#include "soa_convert.h"
+#include "bit_vector.h"
+#include "packed_int_vector.h"
+#include "dict_vector.h"
+#include "rle_vector.h"
+#include "sorted_int_vector.h"
+#include "varint.h"
+#include "byte_buffer.h"
+#include "chained_buffer.h"
+#include "vector_search.h"
+#include "vector_reduce.h"
 
 
 namespace {
@@ -565,6 +593,2266 @@ void Test6() {
     }
 }
 
+void Test7() {
+    const size_t SIZE = 10;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        auto* pos = v.EraseUnordered(v.cbegin() + 2);
+        assert(v.Size() == SIZE - 1);
+        assert(v.Capacity() == 16);
+        assert(&*pos == &v[2]);
+        assert(pos->id == static_cast<int>(SIZE - 1));
+        assert(Obj::num_move_assigned == 1);
+        assert(Obj::num_copied == 0);
+        assert(Obj::num_assigned == 0);
+        assert(Obj::GetAliveObjectCount() == SIZE - 1);
+
+        pos = v.EraseUnordered(v.cend() - 1);
+        assert(pos == v.end());
+        assert(v.Size() == SIZE - 2);
+        assert(Obj::num_move_assigned == 1);
+        assert(Obj::GetAliveObjectCount() == SIZE - 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        // Удаляем элементы как в середине, так и в самом конце вектора
+        const std::vector<size_t> indices = { 0, 3, 4, 8, 9 };
+        v.EraseUnordered(indices.begin(), indices.end());
+        assert(v.Size() == SIZE - indices.size());
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE - indices.size()));
+        assert(Obj::num_move_assigned == 3);
+
+        std::vector<int> ids;
+        for (const Obj& obj : v) {
+            ids.push_back(obj.id);
+        }
+        std::sort(ids.begin(), ids.end());
+        assert((ids == std::vector<int>{ 1, 2, 5, 6, 7 }));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Vector<int> v(SIZE);
+        const std::vector<size_t> all = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        v.EraseUnordered(all.begin(), all.end());
+        assert(v.Size() == 0);
+        assert(v.Capacity() == SIZE);
+    }
+}
+
+void Test8() {
+    const size_t SIZE = 100;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 4);
+        v.Resize(SIZE / 2);
+        assert(v.Capacity() == SIZE * 4);
+        v.ShrinkToFit();
+        assert(v.Size() == SIZE / 2);
+        assert(v.Capacity() == SIZE / 2);
+        assert(Obj::num_copied == 0);
+        assert(Obj::GetAliveObjectCount() == SIZE / 2);
+
+        v.Clear();
+        assert(v.Size() == 0);
+        assert(v.Capacity() == SIZE / 2);
+        assert(Obj::GetAliveObjectCount() == 0);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 0);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.SetShrinkPolicy(ShrinkPolicy::Hysteresis);
+        assert(v.Capacity() == SIZE);
+
+        // Пока размер не меньше четверти вместимости, буфер не перевыделяется
+        v.Resize(SIZE / 4);
+        assert(v.Capacity() == SIZE);
+        v.PopBack();
+        assert(v.Size() == SIZE / 4 - 1);
+        assert(v.Capacity() == (SIZE / 4 - 1) * 2);
+        assert(Obj::GetAliveObjectCount() == SIZE / 4 - 1);
+
+        // Чередование вставки и удаления на границе не приводит к перевыделениям
+        const size_t capacity = v.Capacity();
+        for (int i = 0; i < 10; ++i) {
+            v.EmplaceBack(i);
+            v.PopBack();
+        }
+        assert(v.Capacity() == capacity);
+
+        while (v.Size() > 8) {
+            v.Erase(v.cbegin());
+        }
+        assert(v.Capacity() < capacity);
+        auto* pos = v.Erase(v.cbegin() + 1);
+        assert(pos >= v.begin() && pos < v.end());
+
+        Vector<Obj> moved(std::move(v));
+        assert(moved.GetShrinkPolicy() == ShrinkPolicy::Hysteresis);
+        moved.Clear();
+        assert(moved.Capacity() == 0);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // Присваивание оставляет приёмнику его политику независимо от того, хватило ли ему вместимости
+        Vector<int> source(SIZE, 7);
+        source.SetShrinkPolicy(ShrinkPolicy::Hysteresis);
+        Vector<int> small(1, 1);
+        Vector<int> large(SIZE * 2, 1);
+        small = source;
+        large = source;
+        assert(small.GetShrinkPolicy() == ShrinkPolicy::Never && large.GetShrinkPolicy() == ShrinkPolicy::Never);
+        assert(small.Size() == SIZE && large.Size() == SIZE && large.Capacity() == SIZE * 2);
+        assert(small[SIZE - 1] == 7 && large[0] == 7 && large[SIZE - 1] == 7);
+
+        Vector<int> same(SIZE, 1);
+        same.SetShrinkPolicy(ShrinkPolicy::Hysteresis);
+        same = Vector<int>(SIZE, 3);
+        assert(same.GetShrinkPolicy() == ShrinkPolicy::Hysteresis && same[0] == 3);
+        Vector<int> equal_size(SIZE, 1);
+        equal_size = source;
+        assert(equal_size[0] == 7 && equal_size[SIZE - 1] == 7);
+    }
+}
+
+void Test9() {
+    const size_t SIZE = 100'000;
+    auto& reclaimer = BackgroundReclaimer::Instance();
+    reclaimer.Enable(SIZE * sizeof(int));
+    const size_t released = reclaimer.ReleasedBlocks();
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        Vector<int> small(SIZE / 2);
+    }
+    // Элементы разрушаются сразу, в фоновый поток уходит только сырая память
+    assert(Obj::GetAliveObjectCount() == 0);
+    reclaimer.Flush();
+    assert(reclaimer.ReleasedBlocks() == released + 1);
+    {
+        Vector<int> v(SIZE);
+        v[0] = 42;
+        // Старый буфер освобождается фоновым потоком и при перевыделении памяти
+        v.Reserve(SIZE * 2);
+        assert(v[0] == 42);
+        reclaimer.Flush();
+        assert(reclaimer.ReleasedBlocks() == released + 2);
+    }
+    reclaimer.Disable();
+    assert(reclaimer.ReleasedBlocks() == released + 3);
+    {
+        Vector<int> v(SIZE);
+    }
+    reclaimer.Flush();
+    assert(reclaimer.ReleasedBlocks() == released + 3);
+}
+
+void Test10() {
+    const size_t SIZE = 10;
+    const int ID = 42;
+    {
+        Obj::ResetCounters();
+        CowVector<Obj> v(SIZE);
+        const CowVector<Obj> copy(v);
+        CowVector<Obj> other;
+        other = v;
+        assert(v.UseCount() == 3);
+        assert(Obj::num_copied == 0);
+        assert(Obj::GetAliveObjectCount() == SIZE);
+
+        // Чтение через константные методы не клонирует буфер
+        assert(v.Get(0).id == 0);
+        assert(std::as_const(v)[1].id == 0);
+        assert(v.cend() - v.cbegin() == static_cast<std::ptrdiff_t>(SIZE));
+        assert(&v.View() == &copy.View());
+        assert(Obj::num_copied == 0);
+
+        v[0].id = ID;
+        assert(Obj::num_copied == SIZE);
+        assert(v.UseCount() == 1);
+        assert(copy.UseCount() == 2);
+        assert(v[0].id == ID);
+        assert(copy[0].id == 0);
+        assert(other.Get(0).id == 0);
+        assert(Obj::GetAliveObjectCount() == SIZE * 2);
+
+        // Единоличный владелец изменяет буфер на месте
+        v.EmplaceBack(ID);
+        v.Erase(v.cbegin());
+        assert(v.Size() == SIZE);
+        assert(v[SIZE - 1].id == ID);
+        assert(Obj::num_copied == SIZE);
+
+        other.Clear();
+        assert(other.Size() == 0);
+        assert(copy.UseCount() == 1);
+        assert(Obj::GetAliveObjectCount() == SIZE * 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Obj::ResetCounters();
+        CowVector<Obj> v;
+        assert(v.Size() == 0);
+        assert(v.UseCount() == 0);
+        v.PushBack(Obj{ ID });
+        CowVector<Obj> copy(v);
+        // Итератор на разделяемый буфер остаётся корректной позицией после клонирования
+        auto* pos = copy.Insert(copy.cbegin(), copy.Get(0));
+        assert(pos == copy.begin());
+        assert(copy.Size() == 2);
+        assert(v.Size() == 1);
+        assert(copy[0].id == ID && copy[1].id == ID);
+
+        CowVector<Obj> moved(std::move(copy));
+        assert(copy.Size() == 0);
+        assert(moved.Size() == 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // Буфер, на элемент которого отдана изменяемая ссылка, копия клонирует сразу
+        Obj::ResetCounters();
+        CowVector<Obj> v(SIZE);
+        Obj& first = v[0];
+        const CowVector<Obj> copy = v;
+        assert(v.UseCount() == 1 && copy.UseCount() == 1);
+        assert(Obj::num_copied == SIZE);
+        first.id = ID;
+        assert(copy[0].id == 0 && v.Get(0).id == ID);
+
+        CowVector<Obj> assigned;
+        assigned = v;
+        assert(assigned.UseCount() == 1 && assigned.Get(0).id == ID);
+
+        // PushBack ссылок не отдаёт, а после Clear старых ссылок не остаётся: буфер снова разделяется
+        CowVector<Obj> appended;
+        appended.PushBack(Obj{ ID });
+        const CowVector<Obj> appended_copy = appended;
+        assert(appended.UseCount() == 2);
+        v.Clear();
+        const CowVector<Obj> cleared_copy = v;
+        assert(v.UseCount() == 2 && cleared_copy.Size() == 0);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test11() {
+    const int SIZE = 1000;
+    {
+        Obj::ResetCounters();
+        PersistentVector<Obj> empty;
+        PersistentVector<Obj> v = empty;
+        std::vector<PersistentVector<Obj>> versions;
+        for (int i = 0; i < SIZE; ++i) {
+            versions.push_back(v);
+            v = v.EmplaceBack(i);
+        }
+        assert(empty.Size() == 0);
+        assert(v.Size() == SIZE);
+        // Старые версии не меняются и разделяют узлы с новыми
+        for (int i = 0; i < SIZE; i += 97) {
+            assert(versions[i].Size() == static_cast<size_t>(i));
+            if (i > 0) {
+                assert(versions[i][i - 1].id == i - 1);
+                assert(&versions[i][0] == &v[0]);
+            }
+        }
+
+        const PersistentVector<Obj> changed = v.Set(500, Obj{ -1 });
+        assert(changed[500].id == -1);
+        assert(v[500].id == 500);
+        assert(&changed[0] == &v[0]);
+
+        int expected = 0;
+        for (const Obj& obj : v) {
+            assert(obj.id == expected++);
+        }
+        assert(expected == SIZE);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        PersistentVector<int> v;
+        std::vector<int> model;
+        for (int i = 0; i < SIZE; ++i) {
+            v = v.PushBack(i);
+            model.push_back(i);
+        }
+
+        const auto slice = v.Slice(100, 900);
+        assert(slice.Size() == 800);
+        assert(slice[0] == 100 && slice[799] == 899);
+        assert(v.Take(10).Size() == 10 && v.Drop(10)[0] == 10);
+        assert(v.PopBack().Size() == SIZE - 1);
+
+        // Многократная конкатенация срезов произвольной длины
+        PersistentVector<int> concat;
+        std::vector<int> concat_model;
+        for (int i = 0; i < 200; ++i) {
+            const size_t first = (i * 37) % SIZE;
+            const size_t last = std::min<size_t>(SIZE, first + (i * 13) % 150);
+            if (i % 2 == 0) {
+                concat = concat.Concat(v.Slice(first, last));
+                concat_model.insert(concat_model.end(), model.begin() + first, model.begin() + last);
+            }
+            else {
+                concat = v.Slice(first, last).Concat(concat);
+                concat_model.insert(concat_model.begin(), model.begin() + first, model.begin() + last);
+            }
+        }
+        assert(concat.Size() == concat_model.size());
+        assert(std::equal(concat.begin(), concat.end(), concat_model.begin()));
+        for (size_t i = 0; i < concat_model.size(); i += 7) {
+            assert(concat[i] == concat_model[i]);
+        }
+        const auto reversed = v.Drop(SIZE / 2).Concat(v.Take(SIZE / 2));
+        assert(reversed[0] == SIZE / 2 && reversed[SIZE - 1] == SIZE / 2 - 1);
+    }
+    {
+        Obj::ResetCounters();
+        PersistentVector<Obj> base;
+        base = base.EmplaceBack(1);
+        auto builder = base.AsTransient();
+        for (int i = 0; i < SIZE; ++i) {
+            Obj& obj = builder.EmplaceBack(i);
+            assert(obj.id == i);
+        }
+        const int copies = Obj::num_copied;
+        // Узлы построителя изменяются на месте без копирования
+        builder.Set(SIZE / 2, Obj{ -1 });
+        builder.EmplaceBack(SIZE);
+        assert(Obj::num_copied == copies);
+
+        const PersistentVector<Obj> built = builder.Persistent();
+        builder.Set(0, Obj{ -2 });
+        assert(built.Size() == SIZE + 2);
+        assert(built[0].id == 1);
+        assert(builder[0].id == -2);
+        assert(built[SIZE / 2].id == -1);
+        assert(base.Size() == 1);
+
+        Vector<Obj> values = built.ToVector();
+        assert(values.Size() == built.Size());
+        assert(values[SIZE + 1].id == SIZE);
+        assert(PersistentVector<Obj>(values)[SIZE + 1].id == SIZE);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test12() {
+    const size_t THREADS = 4;
+    const size_t PER_THREAD = 10'000;
+    {
+        Obj::ResetCounters();
+        ConcurrentVector<Obj> v;
+        const size_t index = v.EmplaceBack(42);
+        Obj& first = v[index];
+        for (int i = 1; i < 1000; ++i) {
+            assert(v.PushBack(Obj{ i }) == static_cast<size_t>(i));
+        }
+        // Элементы никогда не перемещаются
+        assert(&first == &v[0]);
+        assert(v.Size() == 1000);
+        assert(v[999].id == 999);
+        assert(v.TryGet(999) != nullptr);
+
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            v.EmplaceBack();
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        // Исключение из конструктора не занимает ячейку, поэтому итерация по [0, Size()) корректна
+        assert(v.Size() == 1000);
+        assert(!v.IsReady(1000));
+        assert(Obj::GetAliveObjectCount() == 1000);
+        int index_seen = 0;
+        for (const Obj& obj : v) {
+            assert(obj.id == (index_seen == 0 ? 42 : index_seen));
+            ++index_seen;
+        }
+        assert(index_seen == 1000);
+        assert(v.EmplaceBack(7) == 1000);
+        assert(v[1000].id == 7);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        ConcurrentVector<size_t> v;
+        std::vector<std::thread> writers;
+        for (size_t t = 0; t < THREADS; ++t) {
+            writers.emplace_back([&v, t] {
+                for (size_t i = 0; i < PER_THREAD; ++i) {
+                    v.PushBack(t * PER_THREAD + i);
+                }
+            });
+        }
+        // Читатель обращается к опубликованным элементам одновременно с писателями
+        size_t observed = 0;
+        while (observed < THREADS * PER_THREAD) {
+            const size_t size = v.Size();
+            for (size_t i = observed; i < size; ++i) {
+                if (const size_t* value = v.TryGet(i)) {
+                    assert(*value < THREADS * PER_THREAD);
+                }
+            }
+            observed = size;
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+
+        assert(v.Size() == THREADS * PER_THREAD);
+        std::vector<size_t> values(v.begin(), v.end());
+        std::sort(values.begin(), values.end());
+        for (size_t i = 0; i < values.size(); ++i) {
+            assert(values[i] == i);
+        }
+    }
+}
+
+void Test13() {
+    const size_t SIZE = 50'000;
+    const size_t READERS = 3;
+    {
+        RcuVector<size_t> v;
+        std::atomic<bool> done = false;
+        std::vector<std::thread> readers;
+        for (size_t r = 0; r < READERS; ++r) {
+            readers.emplace_back([&v, &done] {
+                size_t last_size = 0;
+                while (!done.load()) {
+                    const auto view = v.Read();
+                    // Снимок остаётся корректным, даже если писатель уже перевыделил буфер
+                    assert(view.Size() >= last_size);
+                    for (size_t i = 0; i < view.Size(); i += 101) {
+                        assert(view[i] == i);
+                    }
+                    if (view.Size() != 0) {
+                        assert(*(view.end() - 1) == view.Size() - 1);
+                    }
+                    last_size = view.Size();
+                }
+            });
+        }
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(i);
+        }
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        assert(v.Size() == SIZE);
+        EpochDomain::Global().Synchronize();
+        assert(EpochDomain::Global().RetiredCount() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        RcuVector<Obj> v;
+        v.EmplaceBack(1);
+        {
+            const auto view = v.Read();
+            // Пока читатель держит снимок, старый буфер не освобождается
+            v.EmplaceBack(v.Read()[0]);
+            v.Reserve(16);
+            assert(v.Capacity() == 16);
+            EpochDomain::Global().Reclaim();
+            assert(view.Size() == 1);
+            assert(view[0].id == 1);
+            assert(EpochDomain::Global().RetiredCount() == 2);
+        }
+        EpochDomain::Global().Synchronize();
+        assert(Obj::GetAliveObjectCount() == 2);
+
+        const auto view = v.Read();
+        assert(view.Size() == 2);
+        assert(view[1].id == 1);
+        v.Clear();
+        assert(v.Size() == 0);
+        assert(view.Size() == 2);
+    }
+    EpochDomain::Global().Synchronize();
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test14() {
+    const size_t THREADS = 4;
+    {
+        const size_t PER_THREAD = 50'000;
+        CombinableVector<size_t> combinable;
+        for (int round = 0; round < 2; ++round) {
+            std::vector<std::thread> producers;
+            for (size_t t = 0; t < THREADS; ++t) {
+                producers.emplace_back([&combinable, t] {
+                    Vector<size_t>& local = combinable.Local();
+                    for (size_t i = 0; i < PER_THREAD; ++i) {
+                        local.PushBack(t * PER_THREAD + i);
+                    }
+                    assert(&combinable.Local() == &local);
+                });
+            }
+            for (auto& producer : producers) {
+                producer.join();
+            }
+            assert(combinable.Size() == THREADS * PER_THREAD);
+
+            // Во втором раунде куски перемещения начинаются в середине частей
+            Vector<size_t> merged = round == 0 ? combinable.Merge() : combinable.Merge(3);
+            assert(merged.Size() == THREADS * PER_THREAD);
+            assert(merged.Capacity() == merged.Size());
+            assert(combinable.Size() == 0);
+            for (size_t i = 1; i < merged.Size(); ++i) {
+                assert(i % PER_THREAD == 0 || merged[i] == merged[i - 1] + 1);
+            }
+            std::sort(merged.begin(), merged.end());
+            for (size_t i = 0; i < merged.Size(); ++i) {
+                assert(merged[i] == i);
+            }
+        }
+    }
+    {
+        Obj::ResetCounters();
+        CombinableVector<Obj> combinable;
+        combinable.EmplaceBack(1);
+        std::thread([&combinable] {
+            combinable.EmplaceBack(2);
+            combinable.PushBack(Obj{ 3 });
+        }).join();
+
+        const int moved = Obj::num_moved;
+        Vector<Obj> merged = combinable.Merge();
+        assert(merged.Size() == 3);
+        assert(merged[0].id == 1 && merged[1].id == 2 && merged[2].id == 3);
+        assert(Obj::num_moved == moved + 3);
+        assert(Obj::num_copied == 0);
+        assert(Obj::GetAliveObjectCount() == 3);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Vector<int> v;
+        v.Reserve(4);
+        int* spare = v.SpareBegin();
+        for (int i = 0; i < 3; ++i) {
+            new (spare + i) int(i + 1);
+        }
+        v.CommitSpare(3);
+        assert(v.Size() == 3);
+        assert(v[2] == 3);
+        assert(v.SpareBegin() == v.end());
+    }
+}
+
+void Test15() {
+    {
+        Obj::ResetCounters();
+        SpscRing<Obj> ring(3);
+        assert(ring.Capacity() == 4);
+        for (int i = 0; i < 4; ++i) {
+            assert(ring.TryEmplace(i));
+        }
+        assert(!ring.TryPush(Obj{ 4 }));
+        Obj out;
+        assert(ring.TryPop(out) && out.id == 0);
+        assert(ring.TryPush(Obj{ 4 }));
+
+        // Пакетные операции переходят через границу буфера
+        std::vector<Obj> popped(3);
+        assert(ring.TryPopBatch(popped.begin(), 3) == 3);
+        assert(popped[0].id == 1 && popped[2].id == 3);
+        const std::vector<Obj> batch = { Obj{ 5 }, Obj{ 6 }, Obj{ 7 }, Obj{ 8 } };
+        assert(ring.TryPushBatch(batch.begin(), batch.size()) == 3);
+        assert(ring.SizeApprox() == 4);
+    }
+    {
+        // Пакет заполняет всё место, освобождённое потребителем, а не только то, что видно по старой копии головы
+        SpscRing<int> ring(4);
+        const int values[4] = { 1, 2, 3, 4 };
+        int popped[4] = {};
+        assert(ring.TryPushBatch(values, 3) == 3);
+        assert(ring.TryPopBatch(popped, 3) == 3);
+        assert(ring.TryPushBatch(values, 4) == 4);
+        assert(ring.TryPopBatch(popped, 4) == 4);
+        assert(popped[0] == 1 && popped[3] == 4);
+        assert(RingCapacity(5) == 8);
+        assert(RingCapacity((std::numeric_limits<size_t>::max() >> 1) + 1) == (std::numeric_limits<size_t>::max() >> 1) + 1);
+    }
+    // Оставшиеся в очереди элементы разрушаются вместе с ней
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        const size_t COUNT = 200'000;
+        SpscRing<size_t> ring(64);
+        std::thread producer([&ring] {
+            size_t values[16];
+            for (size_t next = 0; next < COUNT;) {
+                const size_t n = std::min<size_t>(16, COUNT - next);
+                for (size_t i = 0; i < n; ++i) {
+                    values[i] = next + i;
+                }
+                const size_t pushed = ring.TryPushBatch(values, n);
+                if (pushed == 0) {
+                    // Отдаём процессор потребителю: на одном ядре ожидание вращением длится целый квант
+                    std::this_thread::yield();
+                }
+                next += pushed;
+            }
+        });
+        size_t expected = 0;
+        size_t values[16];
+        while (expected < COUNT) {
+            const size_t n = ring.TryPopBatch(values, 16);
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < n; ++i) {
+                assert(values[i] == expected++);
+            }
+        }
+        producer.join();
+    }
+    {
+        const size_t THREADS = 3;
+        const size_t PER_THREAD = 50'000;
+        MpmcRing<size_t> ring(128);
+        std::atomic<size_t> sum = 0;
+        std::atomic<size_t> consumed = 0;
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&ring, t] {
+                for (size_t i = 1; i <= PER_THREAD;) {
+                    if (ring.TryPush(t * PER_THREAD + i)) {
+                        ++i;
+                    }
+                    else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+            threads.emplace_back([&ring, &sum, &consumed] {
+                size_t values[8];
+                while (consumed.load() < THREADS * PER_THREAD) {
+                    const size_t n = ring.TryPopBatch(values, 8);
+                    if (n == 0) {
+                        std::this_thread::yield();
+                    }
+                    for (size_t i = 0; i < n; ++i) {
+                        sum += values[i];
+                    }
+                    consumed += n;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const size_t total = THREADS * PER_THREAD;
+        assert(consumed == total);
+        assert(sum == total * (total + 1) / 2);
+    }
+    {
+        Obj::ResetCounters();
+        MpmcRing<Obj> ring(2);
+        assert(ring.TryEmplace(1));
+        assert(ring.TryEmplace(2, "two"));
+        assert(!ring.TryEmplace(3));
+        Obj out;
+        assert(ring.TryPop(out) && out.id == 1);
+        assert(ring.TryPop(out) && out.id == 2);
+        assert(!ring.TryPop(out));
+        assert(ring.TryEmplace(4));
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test16() {
+    {
+        Obj::ResetCounters();
+        PaddedVector<Obj> v;
+        for (int i = 0; i < 10; ++i) {
+            v.EmplaceBack(i);
+        }
+        v.PushBack(Obj{ 10 });
+        assert(v.Size() == 11 && v.Capacity() >= 11);
+        // Перевыделение сохраняет выравнивание, каждый элемент лежит на своей строке кэша
+        for (size_t i = 0; i < v.Size(); ++i) {
+            assert(reinterpret_cast<uintptr_t>(&v[i]) % CACHE_LINE_SIZE == 0);
+            assert(v[i].id == static_cast<int>(i));
+        }
+        assert(reinterpret_cast<const char*>(&v[1]) - reinterpret_cast<const char*>(&v[0]) == CACHE_LINE_SIZE);
+
+        int expected = 0;
+        for (const Obj& obj : v) {
+            assert(obj.id == expected++);
+        }
+        assert(v.end() - v.begin() == 11);
+        auto it = v.begin() + 3;
+        it->id = 42;
+        PaddedVector<Obj>::const_iterator cit = it;
+        assert(cit[0].id == 42 && (cit - 1)->id == 2);
+
+        v.PopBack();
+        v.Resize(4);
+        assert(v.Size() == 4 && Obj::GetAliveObjectCount() == 4);
+        assert(v.Reduce(0, [](int sum, const Obj& obj) {
+            return sum + obj.id;
+        }) == 0 + 1 + 2 + 42);
+
+        // Вставка и удаление повторяют Vector и сохраняют выравнивание слотов
+        v.Insert(v.begin() + 1, Obj{ 7 });
+        v.Emplace(v.cend(), 8);
+        assert(v.Size() == 6 && v[1].id == 7 && v[5].id == 8);
+        assert(v.Erase(v.begin())->id == 7);
+        assert(v.EraseUnordered(v.begin())->id == 8);
+        assert(v.Size() == 4 && v[0].id == 8 && v[1].id == 1);
+        const size_t erased[] = { 0, 3 };
+        v.EraseUnordered(std::begin(erased), std::end(erased));
+        assert(v.Size() == 2 && v[0].id == 2 && v[1].id == 1);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 2);
+        v.Assign(3, Obj{ 5 });
+        assert(v.Size() == 3 && v[2].id == 5);
+        assert(reinterpret_cast<uintptr_t>(&v[2]) % CACHE_LINE_SIZE == 0);
+        assert(Obj::GetAliveObjectCount() == 3);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // Слоты заполняются значением по умолчанию, и каждый поток пишет только в свой
+        const size_t THREADS = 4;
+        PaddedVector<size_t> counters(THREADS);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&counters, t] {
+                for (size_t i = 0; i < 1000; ++i) {
+                    counters[t] += t + 1;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        assert(counters.Reduce(size_t(0)) == 1000 * (1 + 2 + 3 + 4));
+        assert(counters.Reduce(size_t(0), [](size_t lhs, size_t rhs) {
+            return std::max(lhs, rhs);
+        }) == 4000);
+    }
+    {
+        // Фоновый освободитель возвращает выровненные блоки выравнивающим operator delete
+        auto& reclaimer = BackgroundReclaimer::Instance();
+        const size_t released = reclaimer.ReleasedBlocks();
+        reclaimer.Enable(CACHE_LINE_SIZE);
+        {
+            PaddedVector<int> v(8);
+        }
+        reclaimer.Disable();
+        assert(reclaimer.ReleasedBlocks() == released + 1);
+    }
+}
+
+// Сравнивает ядра поиска всех доступных уровней со скалярными на векторах всех длин до 70
+template <typename T>
+void CheckSearchKernels(const Vector<T>& v, T value) {
+    const auto& scalar = SearchKernels<T>::ForLevel(IsaLevel::Scalar);
+    SearchKernels<T>::Dispatch().ForEachLevel([&](IsaLevel, const auto& kernels) {
+        for (size_t size = 0; size <= v.Size(); ++size) {
+            for (size_t op = 0; op < COMPARE_OP_COUNT; ++op) {
+                assert(kernels.find_if[op](v.begin(), size, value) == scalar.find_if[op](v.begin(), size, value));
+                assert(kernels.count_if[op](v.begin(), size, value) == scalar.count_if[op](v.begin(), size, value));
+            }
+            const T needles[] = { value, static_cast<T>(value / 2), static_cast<T>(-7) };
+            for (size_t count = 0; count <= 3; ++count) {
+                assert(kernels.find_any(v.begin(), size, needles, count) == scalar.find_any(v.begin(), size, needles, count));
+            }
+        }
+    });
+}
+
+void Test17() {
+    {
+        Vector<int32_t> v;
+        for (int32_t i = 0; i < 70; ++i) {
+            v.PushBack((i * 37) % 11 - 5);
+        }
+        for (int32_t value = -6; value <= 6; ++value) {
+            CheckSearchKernels(v, value);
+        }
+        CheckSearchKernels(v, std::numeric_limits<int32_t>::min());
+        CheckSearchKernels(v, std::numeric_limits<int32_t>::max());
+
+        assert(IndexOf(v, 5) == static_cast<size_t>(std::find(v.begin(), v.end(), 5) - v.begin()));
+        assert(Find(v, 100) == v.end() && IndexOf(v, 100) == NOT_FOUND && !Contains(v, 100));
+        assert(Count(v, 0) == static_cast<size_t>(std::count(v.begin(), v.end(), 0)));
+        assert(CountIf(v, CompareOp::Less, 0) == static_cast<size_t>(std::count_if(v.begin(), v.end(), [](int32_t x) {
+            return x < 0;
+        })));
+
+        Vector<int32_t> needles;
+        needles.PushBack(100);
+        assert(FindAny(v, needles) == v.end() && IndexOfAny(v, needles) == NOT_FOUND);
+        needles.PushBack(v[40]);
+        assert(IndexOfAny(v, needles) == IndexOf(v, v[40]));
+    }
+    {
+        Vector<float> v;
+        for (int i = 0; i < 70; ++i) {
+            v.PushBack(static_cast<float>((i * 37) % 11 - 5) * 0.5f);
+        }
+        v[13] = std::numeric_limits<float>::quiet_NaN();
+        v[50] = -0.0f;
+        for (int value = -6; value <= 6; ++value) {
+            CheckSearchKernels(v, value * 0.5f);
+        }
+        CheckSearchKernels(v, std::numeric_limits<float>::quiet_NaN());
+
+        // NaN не равен ничему, включая себя, а -0.0 равен 0.0
+        assert(!Contains(v, std::numeric_limits<float>::quiet_NaN()));
+        assert(Count(v, 0) == static_cast<size_t>(std::count(v.begin(), v.end(), 0.0f)));
+        assert(IndexOfIf(v, CompareOp::NotEqual, v[0]) == 1);
+    }
+    {
+        Vector<int32_t> same(100);
+        assert(FindFirstNotEqual(same, 0) == same.end());
+        same[77] = 1;
+        assert(FindFirstNotEqual(same, 0) == same.begin() + 77);
+    }
+    {
+        // Типы без векторных ядер используют скалярные функции
+        Vector<double> v(10);
+        v[3] = 2.5;
+        assert(IndexOf(v, 2.5) == 3 && Count(v, 0) == 9 && CountIf(v, CompareOp::GreaterEqual, 1) == 1);
+        Vector<int64_t> empty;
+        assert(Find(empty, 0) == empty.end() && Count(empty, 0) == 0);
+    }
+}
+
+// Сравнивает свёртки всех доступных уровней со скалярными на префиксах вектора
+template <typename T>
+void CheckReduceKernels(const Vector<T>& lhs, const Vector<T>& rhs) {
+    const auto& scalar = ReduceKernels<T>::ForLevel(IsaLevel::Scalar);
+    auto close = [](SumType<T> lhs, SumType<T> rhs, SumType<T> scale) {
+        if constexpr (std::is_floating_point_v<T>) {
+            return (std::isnan(lhs) && std::isnan(rhs))
+                || std::abs(lhs - rhs) <= std::numeric_limits<T>::epsilon() * 64 * (scale + 1);
+        }
+        else {
+            return lhs == rhs;
+        }
+    };
+    ReduceKernels<T>::Dispatch().ForEachLevel([&](IsaLevel, const auto& kernels) {
+        for (size_t size = 0; size <= lhs.Size(); ++size) {
+            const T* data = lhs.begin();
+            SumType<T> magnitude = 0;
+            for (size_t i = 0; i < size; ++i) {
+                magnitude += std::abs(static_cast<SumType<T>>(data[i])) * (std::abs(static_cast<SumType<T>>(rhs[i])) + 1);
+            }
+            assert(close(kernels.sum(data, size), scalar.sum(data, size), magnitude));
+            assert(close(kernels.dot(data, rhs.begin(), size), scalar.dot(data, rhs.begin(), size), magnitude));
+            assert(kernels.min(data, size) == scalar.min(data, size));
+            assert(kernels.max(data, size) == scalar.max(data, size));
+        }
+    });
+}
+
+void Test18() {
+    {
+        Vector<int32_t> v;
+        Vector<int32_t> w;
+        for (int32_t i = 0; i < 150; ++i) {
+            v.PushBack((i * 7919) % 1000 - 500);
+            w.PushBack(i % 13 - 6);
+        }
+        CheckReduceKernels(v, w);
+        assert(Min(v) == *std::min_element(v.begin(), v.end()));
+        assert(ArgMax(v) == static_cast<size_t>(std::max_element(v.begin(), v.end()) - v.begin()));
+        assert(ArgMin(v) == static_cast<size_t>(std::min_element(v.begin(), v.end()) - v.begin()));
+
+        // Сумма int32 накапливается в 64 битах
+        Vector<int32_t> big(100);
+        for (auto& x : big) {
+            x = std::numeric_limits<int32_t>::max();
+        }
+        assert(Sum(big) == int64_t(100) * std::numeric_limits<int32_t>::max());
+    }
+    {
+        Vector<double> v;
+        Vector<double> w;
+        for (int i = 0; i < 150; ++i) {
+            v.PushBack(std::sin(i) * 100);
+            w.PushBack(std::cos(i));
+        }
+        CheckReduceKernels(v, w);
+        v[77] = std::numeric_limits<double>::quiet_NaN();
+        CheckReduceKernels(v, w);
+        assert(ArgMin(v) == static_cast<size_t>(std::min_element(v.begin(), v.begin() + 77) - v.begin())
+            || v[ArgMin(v)] == Min(v));
+        assert(!std::isnan(Max(v)) && v[ArgMax(v)] == Max(v));
+    }
+    {
+        Vector<float> v;
+        Vector<float> w;
+        for (int i = 0; i < 150; ++i) {
+            v.PushBack(static_cast<float>(i % 17) - 8.5f);
+            w.PushBack(static_cast<float>(i % 5));
+        }
+        CheckReduceKernels(v, w);
+        assert(Dot(v, w) == ReduceKernels<float>::ForLevel(IsaLevel::Scalar).dot(v.begin(), w.begin(), v.Size()));
+    }
+    {
+        // Точные режимы суммирования: миллион слагаемых 0.1f
+        Vector<float> v(1'000'000);
+        for (auto& x : v) {
+            x = 0.1f;
+        }
+        const double exact = 1'000'000 * static_cast<double>(0.1f);
+        float naive = 0;
+        for (float x : v) {
+            naive += x;
+        }
+        const float kahan = Sum(v, SumMode::Kahan);
+        const float pairwise = Sum(v, SumMode::Pairwise);
+        assert(std::abs(kahan - exact) < 1);
+        assert(std::abs(pairwise - exact) < 1);
+        assert(std::abs(naive - exact) > 100 * std::abs(pairwise - exact));
+    }
+    {
+        // Пустые векторы и типы без векторных ядер
+        Vector<double> empty;
+        assert(Sum(empty) == 0 && Min(empty) == std::numeric_limits<double>::infinity());
+        assert(ArgMin(empty) == NOT_FOUND && ArgMax(empty) == NOT_FOUND);
+        Vector<uint8_t> bytes(300);
+        for (size_t i = 0; i < bytes.Size(); ++i) {
+            bytes[i] = static_cast<uint8_t>(i);
+        }
+        assert(Sum(bytes) == 300 * 299 / 2 - 256 * 44 && Max(bytes) == 255 && ArgMin(bytes) == 0);
+        Vector<int64_t> ints(3);
+        ints[1] = -5;
+        assert(Dot(ints, ints) == 25 && ArgMin(ints) == 1 && Max(ints) == 0);
+    }
+}
+
+void Test19() {
+    {
+        IsaLevel level = IsaLevel::Scalar;
+        assert(ParseIsaLevel("avx2", level) && level == IsaLevel::Avx2);
+        assert(ParseIsaLevel("scalar", level) && level == IsaLevel::Scalar);
+        assert(!ParseIsaLevel("neon", level) && level == IsaLevel::Scalar);
+
+        // Запрос может только понизить уровень процессора
+        assert(ResolveIsaLevel(IsaLevel::Avx2, "sse4.2") == IsaLevel::Sse42);
+        assert(ResolveIsaLevel(IsaLevel::Sse42, "avx512") == IsaLevel::Sse42);
+        assert(ResolveIsaLevel(IsaLevel::Avx2, "unknown") == IsaLevel::Avx2);
+        assert(ResolveIsaLevel(IsaLevel::Avx512, nullptr) == IsaLevel::Avx512);
+        assert(ActiveIsaLevel() <= CpuIsaLevel());
+    }
+    {
+        struct Table {
+            IsaLevel level;
+        };
+        static constexpr Table SCALAR{ IsaLevel::Scalar };
+        static constexpr Table AVX2{ IsaLevel::Avx2 };
+        constexpr IsaDispatch<Table> dispatch(&SCALAR, nullptr, &AVX2);
+
+        // Уровни без собственных ядер используют ближайший младший
+        assert(dispatch.ForLevel(IsaLevel::Scalar).level == IsaLevel::Scalar);
+        assert(dispatch.ForLevel(IsaLevel::Sse42).level == IsaLevel::Scalar);
+        assert(dispatch.ForLevel(IsaLevel::Avx2).level == IsaLevel::Avx2);
+        assert(dispatch.ForLevel(IsaLevel::Avx512).level == IsaLevel::Avx2);
+        assert(dispatch.HasLevel(IsaLevel::Avx2) && !dispatch.HasLevel(IsaLevel::Sse42));
+        assert(&dispatch.Active() == &dispatch.ForLevel(ActiveIsaLevel()));
+
+        Vector<IsaLevel> visited;
+        dispatch.ForEachLevel([&visited](IsaLevel level, const Table& table) {
+            assert(table.level == level);
+            visited.PushBack(level);
+        });
+        assert(visited.Size() == (CpuIsaLevel() >= IsaLevel::Avx2 ? 2u : 1u));
+        assert(visited[0] == IsaLevel::Scalar);
+    }
+    {
+        // Семейства ядер выбирают таблицу активного уровня
+        assert(&SearchKernels<int32_t>::Active() == &SearchKernels<int32_t>::ForLevel(ActiveIsaLevel()));
+        assert(&ReduceKernels<double>::Active() == &ReduceKernels<double>::ForLevel(ActiveIsaLevel()));
+        assert(&SearchKernels<int64_t>::Active() == &SearchKernels<int64_t>::ForLevel(IsaLevel::Scalar));
+    }
+}
+
+void Test20() {
+    using namespace std::literals;
+    {
+        // Ядра каждого уровня: все ширины шаблона, смещения и длины, включая хвосты и невыровненное начало
+        const uint64_t patterns[] = { FillPatternOf(uint8_t{ 0xA5 }), FillPatternOf(uint16_t{ 0x1234 }),
+            FillPatternOf(uint32_t{ 0xDEADBEEF }), FillPatternOf(uint64_t{ 0x0102030405060708 }), 0 };
+        MemoryKernels::Dispatch().ForEachLevel([&patterns](IsaLevel, const MemoryKernels::Table& kernels) {
+            for (const auto fill : { kernels.fill, kernels.stream_fill }) {
+                for (uint64_t pattern : patterns) {
+                    for (size_t offset = 0; offset < 8; offset += 4) {
+                        for (size_t bytes : { 0, 5, 8, 36, 64, 100, 257, 1000 }) {
+                            char buffer[1100];
+                            std::memset(buffer, 0x5A, sizeof(buffer));
+                            fill(buffer + offset, pattern, bytes);
+                            for (size_t i = 0; i < sizeof(buffer); ++i) {
+                                const bool inside = i >= offset && i < offset + bytes;
+                                const char expected = inside ? reinterpret_cast<const char*>(&pattern)[(i - offset) % 8] : 0x5A;
+                                assert(buffer[i] == expected);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+    }
+    {
+        Vector<int16_t> shorts(1001, -2);
+        assert(shorts.Size() == 1001 && shorts.Capacity() == 1001);
+        assert(std::all_of(shorts.begin(), shorts.end(), [](int16_t x) { return x == -2; }));
+
+        // Элемент выровнен меньше своего размера: шаблон не должен сдвигаться
+        struct Pair {
+            int32_t first;
+            int32_t second;
+        };
+        Vector<Pair> pairs(333, Pair{ 1, 2 });
+        assert(std::all_of(pairs.begin(), pairs.end(), [](const Pair& p) { return p.first == 1 && p.second == 2; }));
+
+        Vector<double> doubles(5, 0.5);
+        assert(doubles[0] == 0.5 && doubles[4] == 0.5);
+
+        // Тип без векторного заполнения конструируется копированием за один проход
+        Vector<std::string> strings(4, "sentinel"s);
+        assert(strings.Size() == 4 && strings[3] == "sentinel"s);
+    }
+    {
+        // Перезапись больше порога идёт потоковыми записями
+        const size_t size = NonTemporalThreshold() / sizeof(int64_t) + 3;
+        Vector<int64_t> table(size, 0);
+        table.Assign(size, -1);
+        assert(table[0] == -1 && table[size / 2] == -1 && table[size - 1] == -1);
+        assert(std::count(table.begin(), table.end(), -1) == static_cast<std::ptrdiff_t>(size));
+    }
+    {
+        Vector<int> v(10, 7);
+        v.Assign(4, v[9]);
+        assert(v.Size() == 4 && v.Capacity() == 10 && v[3] == 7);
+        v.Assign(8, 3);
+        assert(v.Size() == 8 && v.Capacity() == 10 && std::count(v.begin(), v.end(), 3) == 8);
+        v.SetShrinkPolicy(ShrinkPolicy::Hysteresis);
+        v.Assign(20, v[0]);
+        assert(v.Size() == 20 && v.Capacity() == 20 && v[19] == 3);
+        assert(v.GetShrinkPolicy() == ShrinkPolicy::Hysteresis);
+        v.Assign(2, 1);
+        assert(v.Size() == 2 && v.Capacity() == 4);
+
+        // Нетривиальный тип: присваивание существующим элементам, конструирование и разрушение хвоста
+        Vector<std::string> strings(3, "a"s);
+        strings.Assign(5, strings[1]);
+        assert(strings.Size() == 5 && strings.Capacity() == 5 && strings[4] == "a"s);
+        strings.Assign(2, "long enough to defeat small string optimization"s);
+        assert(strings.Size() == 2 && strings[1].size() > 40);
+        strings.Assign(4, strings[0]);
+        assert(strings.Size() == 4 && strings[3] == strings[0] && strings[3].size() > 40);
+    }
+}
+
+void Test21() {
+    using namespace std::literals;
+    {
+        // Потоковое копирование каждого уровня: невыровненные источник и приёмник, хвосты
+        char source[1100];
+        for (size_t i = 0; i < sizeof(source); ++i) {
+            source[i] = static_cast<char>(i * 7 + 1);
+        }
+        MemoryKernels::Dispatch().ForEachLevel([&source](IsaLevel, const MemoryKernels::Table& kernels) {
+            for (size_t dst_offset : { 0, 3, 8 }) {
+                for (size_t src_offset : { 0, 5 }) {
+                    for (size_t bytes : { 0, 7, 64, 100, 513, 1000 }) {
+                        char buffer[1100];
+                        std::memset(buffer, 0x5A, sizeof(buffer));
+                        kernels.stream_copy(buffer + dst_offset, source + src_offset, bytes);
+                        for (size_t i = 0; i < sizeof(buffer); ++i) {
+                            const bool inside = i >= dst_offset && i < dst_offset + bytes;
+                            assert(buffer[i] == (inside ? source[src_offset + i - dst_offset] : 0x5A));
+                        }
+                    }
+                }
+            }
+        });
+    }
+    {
+        Vector<int> v;
+        assert(v.GetRelocationPolicy() == RelocationPolicy::Cached);
+        v.SetRelocationPolicy(RelocationPolicy::Streaming);
+        Vector<int> copy(v);
+        Vector<int> other;
+        other.Swap(v);
+        assert(copy.GetRelocationPolicy() == RelocationPolicy::Streaming);
+        assert(other.GetRelocationPolicy() == RelocationPolicy::Streaming && v.GetRelocationPolicy() == RelocationPolicy::Cached);
+
+        // Присваивание не меняет политику приёмника ни при перевыделении, ни при копировании на месте
+        Vector<int> source(100, 7);
+        Vector<int> small;
+        Vector<int> large(200, 1);
+        small.SetRelocationPolicy(RelocationPolicy::Streaming);
+        large.SetRelocationPolicy(RelocationPolicy::Streaming);
+        small = source;
+        large = source;
+        assert(small.GetRelocationPolicy() == RelocationPolicy::Streaming && large.GetRelocationPolicy() == RelocationPolicy::Streaming);
+        assert(small.Size() == 100 && large.Size() == 100 && small[99] == 7 && large[99] == 7);
+        source = std::move(small);
+        assert(source.GetRelocationPolicy() == RelocationPolicy::Cached && small.GetRelocationPolicy() == RelocationPolicy::Streaming);
+    }
+    {
+        // Рост, Reserve, Emplace и ShrinkToFit больше порога переносят элементы потоковым копированием
+        const size_t size = NonTemporalThreshold() / sizeof(int64_t) + 5;
+        Vector<int64_t> v;
+        v.SetRelocationPolicy(RelocationPolicy::Streaming);
+        v.Reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            v.PushBack(static_cast<int64_t>(i));
+        }
+        v.PushBack(-1);
+        assert(v.Capacity() == 2 * size && v[size] == -1);
+        v.Reserve(3 * size);
+        v.ShrinkToFit();
+        assert(v.Capacity() == size + 1);
+        v.Emplace(v.begin() + 1, -2);
+        assert(v.Size() == size + 2 && v[0] == 0 && v[1] == -2 && v[2] == 1 && v[size + 1] == -1);
+        for (size_t i = 2; i <= size; ++i) {
+            assert(v[i] == static_cast<int64_t>(i - 1));
+        }
+    }
+    {
+        // Нетривиальные типы политика не затрагивает: они по-прежнему перемещаются
+        Vector<std::string> strings(3, "long enough to defeat small string optimization"s);
+        strings.SetRelocationPolicy(RelocationPolicy::Streaming);
+        strings.Reserve(100);
+        strings.PushBack("x"s);
+        assert(strings.Size() == 4 && strings[2].size() > 40 && strings[3] == "x"s);
+    }
+}
+
+// Поле, копирование которого выбрасывает исключение после заданного числа копий
+struct FragileField {
+    explicit FragileField(int value)
+        : value(value) {
+        ++live;
+    }
+    FragileField(const FragileField& other)
+        : value(other.value) {
+        if (--copies_left == 0) {
+            throw std::runtime_error("copy failed");
+        }
+        ++live;
+    }
+    ~FragileField() {
+        --live;
+    }
+
+    int value;
+    inline static int live = 0;
+    inline static int copies_left = 1000;
+};
+
+void Test22() {
+    using namespace std::literals;
+    using Records = SoAVector<int, double, std::string>;
+    {
+        Records v;
+        assert(v.Empty() && v.Capacity() == 0);
+        for (int i = 0; i < 5; ++i) {
+            v.EmplaceBack(i, i * 0.5, std::to_string(i));
+        }
+        assert(v.Size() == 5 && v.Capacity() == 8);
+        assert(v[3].Get<0>() == 3 && v[3].Get<1>() == 1.5 && v[3].Get<2>() == "3"s);
+
+        // Прокси-ссылка: запись поля, присваивание и копирование всей записи
+        v[1].Get<2>() = "one"s;
+        v[2] = std::make_tuple(20, 2.5, "two"s);
+        const Records::value_type record = v[2];
+        assert(std::get<0>(record) == 20 && std::get<2>(record) == "two"s);
+        v[0] = v[2];
+        assert(v[0].Get<0>() == 20 && v[0].Get<2>() == "two"s && v[2].Get<1>() == 2.5);
+
+        // Столбцы выровнены по строке кэша и видны как Span
+        assert(reinterpret_cast<uintptr_t>(v.Column<0>().Data()) % Records::COLUMN_ALIGNMENT == 0);
+        assert(reinterpret_cast<uintptr_t>(v.Column<1>().Data()) % Records::COLUMN_ALIGNMENT == 0);
+        const Span<int> ids = v.Column<0>();
+        assert(ids.Size() == 5 && ids[4] == 4);
+
+        // При росте аргументы могут ссылаться на записи самого вектора
+        while (v.Size() < v.Capacity()) {
+            v.PushBack(std::make_tuple(7, 7.0, "seven"s));
+        }
+        v.EmplaceBack(v[1].Get<0>(), v[1].Get<1>(), v[1].Get<2>());
+        assert(v.Size() == 9 && v.Capacity() == 16 && v[8].Get<0>() == 1 && v[8].Get<2>() == "one"s);
+
+        auto it = v.Erase(v.begin() + 1);
+        assert(it == v.begin() + 1 && v.Size() == 8 && v[1].Get<0>() == 20 && v[7].Get<2>() == "one"s);
+        it = v.EraseUnordered(v.cbegin());
+        assert(it == v.begin() && v.Size() == 7 && v[0].Get<2>() == "one"s);
+        v.PopBack();
+        assert(v.Size() == 6);
+
+        int total = 0;
+        for (auto r : v) {
+            r.Get<0>() += 1;
+        }
+        const Records& cv = v;
+        for (auto r : cv) {
+            total += r.Get<0>();
+        }
+        static_assert(std::is_same_v<decltype(cv[0].Get<0>()), const int&>);
+        assert(total == (1 + 20 + 3 + 4 + 7 + 7) + 6);
+    }
+    {
+        Records v(3);
+        assert(v.Size() == 3 && v[2].Get<0>() == 0 && v[2].Get<2>().empty());
+        v[1] = std::make_tuple(1, 1.0, "a"s);
+        Records copy(v);
+        Records moved(std::move(v));
+        assert(copy.Size() == 3 && copy.Capacity() == 3 && copy[1].Get<2>() == "a"s);
+        assert(moved.Size() == 3 && v.Size() == 0);
+        copy = moved;
+        copy.Resize(10);
+        copy.Reserve(40);
+        assert(copy.Size() == 10 && copy.Capacity() == 40 && copy[1].Get<0>() == 1 && copy[9].Get<1>() == 0.0);
+        copy.ShrinkToFit();
+        assert(copy.Capacity() == 10);
+
+        // Политика уменьшения вместимости работает так же, как у Vector
+        copy.SetShrinkPolicy(ShrinkPolicy::Hysteresis);
+        copy.Resize(2);
+        assert(copy.Capacity() == 10);
+        copy.PopBack();
+        assert(copy.Capacity() == 2 && copy[0].Get<2>().empty());
+        copy.Clear();
+        assert(copy.Empty());
+    }
+    {
+        // Исключение при копировании поля во время роста оставляет вектор нетронутым
+        {
+            SoAVector<std::string, FragileField> v;
+            for (int i = 0; i < 4; ++i) {
+                v.EmplaceBack(std::to_string(i), i);
+            }
+            FragileField::copies_left = 3;
+            bool thrown = false;
+            try {
+                v.EmplaceBack("4"s, 4);
+            }
+            catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown && v.Size() == 4 && v.Capacity() == 4);
+            assert(v[3].Get<0>() == "3"s && v[3].Get<1>().value == 3 && FragileField::live == 4);
+            FragileField::copies_left = 1000;
+        }
+        assert(FragileField::live == 0);
+    }
+}
+
+void Test23() {
+    using namespace std::literals;
+    {
+        // Ядра каждого уровня совпадают со скалярными для разных шагов и длин
+        const size_t STRIDES[] = { 4, 8, 12, 24, 100 };
+        for (size_t stride : STRIDES) {
+            std::vector<unsigned char> records(stride * 80 + 8);
+            for (size_t i = 0; i < records.size(); ++i) {
+                records[i] = static_cast<unsigned char>(i * 7 + 1);
+            }
+            StridedKernels::Dispatch().ForEachLevel([&](IsaLevel, const auto& kernels) {
+                for (size_t count = 0; count <= 70; ++count) {
+                    if (stride >= 8) {
+                        std::vector<uint64_t> expected(count), actual(count);
+                        ScalarStrided::Gather<uint64_t>(records.data(), stride, count, expected.data());
+                        kernels.gather64(records.data(), stride, count, actual.data());
+                        assert(expected == actual);
+
+                        std::vector<unsigned char> scattered(records.size());
+                        kernels.scatter64(actual.data(), count, scattered.data(), stride);
+                        for (size_t i = 0; i < count; ++i) {
+                            assert(std::memcmp(scattered.data() + i * stride, records.data() + i * stride, 8) == 0);
+                        }
+                    }
+                    std::vector<uint32_t> expected(count), actual(count);
+                    ScalarStrided::Gather<uint32_t>(records.data() + 4, stride, count, expected.data());
+                    kernels.gather32(records.data() + 4, stride, count, actual.data());
+                    assert(expected == actual);
+
+                    std::vector<unsigned char> scattered(records.size());
+                    kernels.scatter32(actual.data(), count, scattered.data() + 4, stride);
+                    for (size_t i = 0; i < count; ++i) {
+                        assert(std::memcmp(scattered.data() + 4 + i * stride, records.data() + 4 + i * stride, 4) == 0);
+                    }
+                }
+            });
+        }
+    }
+    {
+        // Поле, которого нет в списке, при обратном преобразовании обнуляется
+        struct Sample {
+            double x;
+            int32_t id;
+            char tag;
+            int64_t time;
+            float weight;
+        };
+        Vector<Sample> samples;
+        for (int i = 0; i < 1000; ++i) {
+            samples.PushBack(Sample{ i * 0.5, i, static_cast<char>('a' + i % 26), i * 1000LL, i * 0.25f });
+        }
+        const auto columns = ToSoA(samples, &Sample::time, &Sample::id, &Sample::x, &Sample::weight, &Sample::tag);
+        static_assert(std::is_same_v<std::remove_const_t<decltype(columns)>, SoAVector<int64_t, int32_t, double, float, char>>);
+        assert(columns.Size() == 1000 && columns.Capacity() == 1000);
+        for (size_t i = 0; i < samples.Size(); ++i) {
+            assert(columns[i].Get<0>() == samples[i].time && columns[i].Get<1>() == samples[i].id);
+            assert(columns[i].Get<2>() == samples[i].x && columns[i].Get<3>() == samples[i].weight);
+            assert(columns[i].Get<4>() == samples[i].tag);
+        }
+
+        const Vector<Sample> restored = ToAoS(columns, &Sample::time, &Sample::id, &Sample::x, &Sample::weight, &Sample::tag);
+        assert(restored.Size() == samples.Size());
+        for (size_t i = 0; i < samples.Size(); ++i) {
+            assert(std::memcmp(&restored[i].x, &samples[i].x, sizeof(double)) == 0 && restored[i].time == samples[i].time);
+            assert(restored[i].id == samples[i].id && restored[i].tag == samples[i].tag && restored[i].weight == samples[i].weight);
+        }
+        const Vector<Sample> partial = ToAoS(ToSoA(samples, &Sample::id), &Sample::id);
+        assert(partial[999].id == 999 && partial[999].x == 0.0 && partial[999].time == 0 && partial[999].tag == 0);
+
+        const auto empty = ToSoA(Vector<Sample>(), &Sample::x);
+        assert(empty.Empty() && ToAoS(empty, &Sample::x).Size() == 0);
+    }
+    {
+        struct Named {
+            std::string name;
+            int id = -1;
+            std::string note = "default";
+        };
+        Vector<Named> people;
+        for (int i = 0; i < 100; ++i) {
+            people.PushBack(Named{ "person "s + std::to_string(i), i, "" });
+        }
+        const auto columns = ToSoA(people, &Named::name, &Named::id);
+        assert(columns.Size() == 100 && columns[42].Get<0>() == "person 42"s && columns[42].Get<1>() == 42);
+        const Vector<Named> restored = ToAoS(columns, &Named::name, &Named::id);
+        assert(restored.Size() == 100 && restored[7].name == "person 7"s && restored[7].id == 7 && restored[7].note == "default"s);
+    }
+    {
+        // Исключение при копировании поля разрушает уже собранные столбцы
+        struct Fragile {
+            std::string name;
+            FragileField field;
+        };
+        {
+            Vector<Fragile> records;
+            for (int i = 0; i < 10; ++i) {
+                records.PushBack(Fragile{ std::to_string(i), FragileField(i) });
+            }
+            const int live = FragileField::live;
+            FragileField::copies_left = 5;
+            bool thrown = false;
+            try {
+                ToSoA(records, &Fragile::name, &Fragile::field);
+            }
+            catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown && FragileField::live == live);
+            FragileField::copies_left = 1000;
+        }
+        assert(FragileField::live == 0);
+    }
+    {
+        // Части покрывают диапазон ровно один раз при любом числе потоков
+        const size_t COUNT = 3 * PARALLEL_CONVERT_THRESHOLD + 5;
+        for (size_t threads : { 1, 2, 4 }) {
+            std::vector<char> visited(COUNT);
+            ForEachChunk(COUNT, [&visited](size_t first, size_t size) {
+                for (size_t i = first; i < first + size; ++i) {
+                    ++visited[i];
+                }
+            }, threads);
+            assert(std::all_of(visited.begin(), visited.end(), [](char v) { return v == 1; }));
+        }
+        size_t calls = 0;
+        ForEachChunk(0, [&calls](size_t, size_t size) {
+            calls += 1 + size;
+        }, 4);
+        assert(calls == 1);
+
+        struct Point {
+            int64_t x;
+            int32_t y;
+        };
+        Vector<Point> points;
+        for (size_t i = 0; i < COUNT; ++i) {
+            points.PushBack(Point{ static_cast<int64_t>(i), static_cast<int32_t>(i * 3) });
+        }
+        const auto columns = ToSoA(points, &Point::y, &Point::x);
+        const Vector<Point> restored = ToAoS(columns, &Point::y, &Point::x);
+        for (size_t i = 0; i < COUNT; ++i) {
+            assert(columns.Column<1>()[i] == static_cast<int64_t>(i) && restored[i].y == static_cast<int32_t>(i * 3));
+        }
+    }
+}
+
+void Test24() {
+    uint64_t seed = 7;
+    auto next_random = [&seed] {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed ^ (seed >> 29);
+    };
+    {
+        // Ядра каждого уровня совпадают со скалярными
+        std::vector<uint64_t> lhs(70), rhs(70);
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            lhs[i] = next_random();
+            rhs[i] = next_random();
+        }
+        BitKernels::Dispatch().ForEachLevel([&](IsaLevel, const auto& kernels) {
+            for (size_t count = 0; count <= lhs.size(); ++count) {
+                assert(kernels.pop_count(lhs.data(), count) == ScalarBits::PopCount(lhs.data(), count));
+                for (size_t op = 0; op < BIT_OP_COUNT; ++op) {
+                    std::vector<uint64_t> expected(lhs.begin(), lhs.begin() + count);
+                    std::vector<uint64_t> actual = expected;
+                    BitKernels::ForLevel(IsaLevel::Scalar).combine[op](expected.data(), rhs.data(), count);
+                    kernels.combine[op](actual.data(), rhs.data(), count);
+                    assert(expected == actual);
+                }
+                std::vector<uint64_t> sparse(count);
+                assert(kernels.find_non_zero(sparse.data(), count) == count);
+                for (size_t hit = 0; hit < count; ++hit) {
+                    sparse[hit] = uint64_t{ 1 } << (hit % 64);
+                    assert(kernels.find_non_zero(sparse.data(), count) == hit);
+                    sparse[hit] = 0;
+                }
+            }
+        });
+    }
+    {
+        // Операции над отдельными битами сверяются с std::vector<bool>
+        BitVector bits;
+        std::vector<bool> reference;
+        for (size_t i = 0; i < 1000; ++i) {
+            const bool value = next_random() % 3 == 0;
+            bits.PushBack(value);
+            reference.push_back(value);
+        }
+        assert(bits.Size() == 1000 && bits.Capacity() == 1024 && bits.WordCount() == 16);
+        for (size_t step = 0; step < 2000; ++step) {
+            const size_t index = next_random() % bits.Size();
+            switch (step % 4) {
+            case 0:
+                bits.Set(index);
+                reference[index] = true;
+                break;
+            case 1:
+                bits.Reset(index);
+                reference[index] = false;
+                break;
+            case 2:
+                bits.Flip(index);
+                reference[index] = !reference[index];
+                break;
+            default:
+                bits.Set(index, step % 8 == 3);
+                reference[index] = step % 8 == 3;
+            }
+        }
+        bits.PopBack();
+        reference.pop_back();
+        auto check = [&] {
+            assert(bits.Size() == reference.size());
+            size_t count = 0;
+            for (size_t i = 0; i < reference.size(); ++i) {
+                assert(bits[i] == reference[i]);
+                count += reference[i] ? 1 : 0;
+            }
+            assert(bits.Count() == count);
+            // Биты за пределами размера всегда нулевые
+            if (bits.Size() % 64 != 0) {
+                assert(bits.Words()[bits.WordCount() - 1] >> (bits.Size() % 64) == 0);
+            }
+        };
+        check();
+        bits.Resize(1500, true);
+        reference.resize(1500, true);
+        check();
+        bits.Resize(700);
+        reference.resize(700);
+        check();
+        bits.Resize(900);
+        reference.resize(900, false);
+        check();
+        bits.ShrinkToFit();
+        assert(bits.Capacity() == 960);
+        check();
+
+        BitVector copy(bits);
+        copy.Fill(true);
+        assert(copy.Count() == 900 && bits.Count() != 900);
+        copy.AndNot(bits);
+        assert(copy.Count() == 900 - bits.Count());
+        copy.Or(bits);
+        assert(copy.Count() == 900);
+        copy.Xor(bits);
+        copy.And(copy);
+        assert(copy.Count() == 900 - bits.Count());
+        copy = bits;
+        copy.Xor(copy);
+        assert(copy.Count() == 0 && copy.FindFirst() == NOT_FOUND);
+        copy.Clear();
+        assert(copy.Empty() && copy.Count() == 0);
+
+        const BitVector ones(130, true);
+        assert(ones.Count() == 130 && ones.Words()[2] == 3);
+        assert(BitVector(64, true).Words()[0] == ~uint64_t{ 0 });
+    }
+    {
+        // FindNext, Rank и Select без индекса и с индексом для разной плотности
+        for (size_t density : { 1, 2, 64, 5000 }) {
+            BitVector bits(20000);
+            std::vector<size_t> ones;
+            for (size_t i = 0; i < bits.Size(); ++i) {
+                if (next_random() % density == 0) {
+                    bits.Set(i);
+                    ones.push_back(i);
+                }
+            }
+            size_t found = 0;
+            for (size_t i = bits.FindFirst(); i != NOT_FOUND; i = bits.FindNext(i + 1)) {
+                assert(found < ones.size() && ones[found] == i);
+                ++found;
+            }
+            assert(found == ones.size());
+
+            for (int indexed = 0; indexed < 2; ++indexed) {
+                if (indexed == 1) {
+                    bits.BuildRankIndex();
+                    assert(bits.HasRankIndex());
+                }
+                size_t rank = 0;
+                for (size_t i = 0; i <= bits.Size(); ++i) {
+                    assert(bits.Rank(i) == rank);
+                    rank += i < bits.Size() && bits[i] ? 1 : 0;
+                }
+                for (size_t k = 0; k < ones.size(); ++k) {
+                    assert(bits.Select(k) == ones[k]);
+                }
+                assert(bits.Select(ones.size()) == NOT_FOUND);
+            }
+            bits.Flip(0);
+            assert(!bits.HasRankIndex());
+        }
+        BitVector empty;
+        empty.BuildRankIndex();
+        assert(empty.Rank(0) == 0 && empty.Select(0) == NOT_FOUND && empty.FindFirst() == NOT_FOUND);
+    }
+}
+
+void Test25() {
+    uint64_t seed = 11;
+    auto next_random = [&seed] {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<uint32_t>(seed >> 32);
+    };
+    {
+        static_assert(BitsFor(0) == 1 && BitsFor(1) == 1 && BitsFor(2) == 2 && BitsFor(2047) == 11 && BitsFor(2048) == 12);
+        static_assert(BitsFor(0xFFFFFFFF) == 32);
+
+        // Ядра каждого уровня совпадают со скалярным для всех ширин, начальных позиций и длин
+        for (unsigned bits = 1; bits <= MAX_PACKED_BIT_WIDTH; ++bits) {
+            RuntimePackedIntVector packed(bits);
+            for (size_t i = 0; i < 100; ++i) {
+                packed.PushBack(next_random() & packed.MaxValue());
+            }
+            const Span<const uint64_t> words = packed.Words();
+            PackedKernels::Dispatch().ForEachLevel([&](IsaLevel, const auto& kernels) {
+                for (size_t first = 0; first < 10; ++first) {
+                    for (size_t count = 0; first + count <= packed.Size(); count += 7) {
+                        std::vector<uint32_t> out(count);
+                        kernels.unpack(words.Data(), bits, first, count, out.data());
+                        for (size_t i = 0; i < count; ++i) {
+                            assert(out[i] == packed[first + i]);
+                        }
+                    }
+                }
+            });
+        }
+    }
+    {
+        // Значения сверяются с std::vector при записи через границы слов
+        PackedIntVector<17> packed;
+        std::vector<uint32_t> reference;
+        assert(packed.BitWidth() == 17 && packed.MaxValue() == (1u << 17) - 1 && packed.Capacity() == 0);
+        for (size_t i = 0; i < 1000; ++i) {
+            const uint32_t value = next_random() & packed.MaxValue();
+            packed.PushBack(value);
+            reference.push_back(value);
+        }
+        assert(packed.Size() == 1000 && packed.Capacity() >= 1000);
+        // 1000 значений по 17 бит занимают 266 слов и ещё одно слово за ними
+        assert(packed.Words().Size() == 267);
+        for (size_t step = 0; step < 3000; ++step) {
+            const size_t index = next_random() % packed.Size();
+            const uint32_t value = step % 5 == 0 ? packed.MaxValue() : next_random() & packed.MaxValue();
+            packed.Set(index, value);
+            reference[index] = value;
+        }
+        auto check = [&](const auto& values) {
+            assert(values.Size() == reference.size());
+            for (size_t i = 0; i < reference.size(); ++i) {
+                assert(values[i] == reference[i]);
+            }
+            const Vector<uint32_t> unpacked = values.Unpack();
+            assert(unpacked.Size() == reference.size() && std::equal(unpacked.begin(), unpacked.end(), reference.begin()));
+            // Биты за пределами размера нулевые
+            const Span<const uint64_t> words = values.Words();
+            const size_t used_bits = values.Size() * values.BitWidth();
+            if (!words.Empty()) {
+                assert(words[words.Size() - 1] == 0);
+                if (used_bits % 64 != 0) {
+                    assert(words[used_bits / 64] >> (used_bits % 64) == 0);
+                }
+            }
+        };
+        check(packed);
+        packed.PopBack();
+        reference.pop_back();
+        check(packed);
+        packed.Resize(1500, 12345);
+        reference.resize(1500, 12345);
+        check(packed);
+        packed.Resize(700);
+        reference.resize(700);
+        check(packed);
+        packed.Resize(800);
+        reference.resize(800, 0);
+        check(packed);
+
+        const std::vector<uint32_t> tail = { 1, 2, 3, packed.MaxValue() };
+        packed.Append(tail.data(), tail.size());
+        reference.insert(reference.end(), tail.begin(), tail.end());
+        check(packed);
+
+        PackedIntVector<17> copy(packed);
+        check(copy);
+        copy.ShrinkToFit();
+        assert(copy.Capacity() >= copy.Size() && copy.Capacity() < copy.Size() + 64 / 17 + 1);
+        check(copy);
+        PackedIntVector<17> moved(std::move(copy));
+        check(moved);
+        moved.Clear();
+        assert(moved.Empty() && moved.Unpack().Size() == 0);
+        moved.PushBack(5);
+        assert(moved[0] == 5 && moved.Words()[1] == 0);
+
+        // Вектор с шириной во время выполнения хранит те же биты
+        RuntimePackedIntVector runtime(BitsFor(packed.MaxValue()));
+        for (uint32_t value : reference) {
+            runtime.PushBack(value);
+        }
+        assert(runtime.BitWidth() == 17);
+        check(runtime);
+        assert(std::equal(runtime.Words().begin(), runtime.Words().end(), packed.Words().begin()));
+
+        // Распаковка блока из середины
+        std::vector<uint32_t> block(100);
+        packed.Unpack(333, block.size(), block.data());
+        assert(std::equal(block.begin(), block.end(), reference.begin() + 333));
+    }
+    {
+        PackedIntVector<32> full;
+        PackedIntVector<1> flags;
+        for (uint32_t i = 0; i < 100; ++i) {
+            full.PushBack(0xFFFFFFFF - i);
+            flags.PushBack(i % 3 == 0);
+        }
+        assert(full[99] == 0xFFFFFFFF - 99 && full.Words().Size() == 51);
+        assert(flags[99] == 1 && flags[98] == 0 && flags.Words().Size() == 3);
+    }
+}
+
+void Test26() {
+    using namespace std::literals;
+    {
+        DictVector<std::string> cities;
+        std::vector<std::string> reference;
+        assert(cities.Empty() && cities.GetCodeWidth() == CodeWidth::Bits8);
+        // 300 различных значений: на 257-м коды расширяются до 16 бит
+        for (size_t i = 0; i < 3000; ++i) {
+            const std::string city = "city number "s + std::to_string((i * 7) % 300);
+            const std::string& stored = cities.EmplaceBack(city);
+            assert(stored == city);
+            reference.push_back(city);
+            assert(cities.GetCodeWidth() == (cities.DictionarySize() <= 256 ? CodeWidth::Bits8 : CodeWidth::Bits16));
+        }
+        cities.PushBack("city number 5"s);
+        reference.push_back("city number 5"s);
+        assert(cities.Size() == 3001 && cities.DictionarySize() == 300 && cities.GetCodeWidth() == CodeWidth::Bits16);
+        for (size_t i = 0; i < reference.size(); ++i) {
+            assert(cities[i] == reference[i] && cities.Dictionary()[cities.CodeAt(i)] == reference[i]);
+        }
+        assert(std::equal(cities.begin(), cities.end(), reference.begin(), reference.end()));
+        assert(cities.begin()->size() == "city number 0"s.size());
+
+        // Условия проверяются по кодам
+        const BitVector fives = cities.Equal("city number 5"s);
+        assert(fives.Size() == cities.Size() && fives.Count() == cities.Count("city number 5"s) && fives.Count() == 11);
+        for (size_t i = fives.FindFirst(); i != NOT_FOUND; i = fives.FindNext(i + 1)) {
+            assert(reference[i] == "city number 5"s);
+        }
+        assert(cities.Count("nowhere"s) == 0 && cities.Equal("nowhere"s).Count() == 0);
+        assert(cities.FindCode("nowhere"s) == DictVector<std::string>::NO_CODE && cities.FindCode("city number 0"s) == 0);
+
+        size_t calls = 0;
+        const BitVector long_names = cities.Where([&calls](const std::string& city) {
+            ++calls;
+            return city.size() > "city number 99"s.size();
+        });
+        assert(calls == cities.DictionarySize());
+        size_t expected = 0;
+        for (size_t i = 0; i < reference.size(); ++i) {
+            const bool selected = reference[i].size() > 14;
+            assert(long_names[i] == selected);
+            expected += selected ? 1 : 0;
+        }
+        assert(long_names.Count() == expected && cities.Where([](const std::string&) { return false; }).Count() == 0);
+
+        DictVector<std::string> copy(cities);
+        cities.PopBack();
+        assert(copy.Size() == 3001 && cities.Size() == 3000 && copy[3000] == "city number 5"s);
+
+        // Перемещённый вектор остаётся пустым и пригодным для добавления
+        DictVector<std::string> moved(std::move(copy));
+        assert(moved.Size() == 3001 && moved.FindCode("city number 5"s) == cities.FindCode("city number 5"s));
+        assert(copy.Empty() && copy.DictionarySize() == 0 && copy.GetCodeWidth() == CodeWidth::Bits8);
+        copy.PushBack("x"s);
+        assert(copy.Size() == 1 && copy[copy.Size() - 1] == "x"s && copy.FindCode("x"s) == 0);
+        DictVector<std::string> assigned;
+        assigned = std::move(moved);
+        assert(assigned.Size() == 3001 && moved.Empty() && moved.GetCodeWidth() == CodeWidth::Bits8);
+        moved.PushBack("y"s);
+        assert(moved[0] == "y"s && moved.FindCode("city number 5"s) == DictVector<std::string>::NO_CODE);
+        assigned = copy;
+        assert(assigned.Size() == 1 && assigned[0] == "x"s && copy.Size() == 1);
+        cities.Clear();
+        assert(cities.Empty() && cities.DictionarySize() == 0 && cities.GetCodeWidth() == CodeWidth::Bits8);
+        cities.EmplaceBack(5, 'x');
+        assert(cities[0] == "xxxxx"s && cities.CodeAt(0) == 0);
+    }
+    {
+        // Больше 65536 различных значений: коды расширяются до 32 бит
+        DictVector<int> ids;
+        ids.Reserve(16);
+        for (int i = 0; i < 70000; ++i) {
+            ids.PushBack(i % 200);
+        }
+        assert(ids.GetCodeWidth() == CodeWidth::Bits8);
+        for (int i = 0; i < 70000; ++i) {
+            ids.PushBack(i);
+        }
+        assert(ids.GetCodeWidth() == CodeWidth::Bits32 && ids.DictionarySize() == 70000 && ids.Size() == 140000);
+        assert(ids[199] == 199 && ids[200] == 0 && ids[139999] == 69999 && ids.Count(150) == 351);
+        assert(ids.Where([](int id) { return id >= 69990; }).Count() == 10);
+    }
+    {
+        // Индекс хранит только коды и остаётся верным, даже если хеши всех значений совпадают
+        struct SameHash {
+            size_t operator()(const std::string&) const noexcept {
+                return 42;
+            }
+        };
+        using Names = DictVector<std::string, SameHash>;
+        Names names;
+        for (size_t i = 0; i < 100; ++i) {
+            names.PushBack(std::to_string(i % 40));
+        }
+        assert(names.DictionarySize() == 40 && names.Count("7"s) == 3 && names.FindCode("39"s) == 39);
+        assert(names.FindCode("40"s) == Names::NO_CODE);
+
+        Names copy(names);
+        names.Clear();
+        assert(names.FindCode("7"s) == Names::NO_CODE);
+        names.PushBack("new"s);
+        assert(names.FindCode("new"s) == 0 && copy.FindCode("new"s) == Names::NO_CODE);
+        copy.PushBack("new"s);
+        assert(copy.FindCode("new"s) == 40 && copy.FindCode("0"s) == 0 && copy.Count("0"s) == 3);
+    }
+}
+
+void Test27() {
+    using namespace std::literals;
+    {
+        RleVector<int32_t> series;
+        Vector<int32_t> reference;
+        assert(series.Empty() && series.Size() == 0 && series.begin() == series.end());
+        for (int32_t run = 0; run < 200; ++run) {
+            const int32_t value = run % 3 == 0 ? -run : run;
+            const size_t length = static_cast<size_t>(run % 7) + 1;
+            for (size_t i = 0; i < length; ++i) {
+                series.PushBack(value);
+                reference.PushBack(value);
+            }
+        }
+        series.AppendRun(reference[reference.Size() - 1], 5);
+        series.AppendRun(1000, 0);
+        for (int i = 0; i < 5; ++i) {
+            reference.PushBack(reference[reference.Size() - 1]);
+        }
+        assert(series.Size() == reference.Size() && series.RunCount() == 200 && series.RunLength(199) == 4 + 5);
+        for (size_t i = 0; i < reference.Size(); ++i) {
+            assert(series[i] == reference[i]);
+            assert(series.RunValues()[series.RunOf(i)] == reference[i]);
+        }
+        assert(std::equal(series.begin(), series.end(), reference.begin(), reference.end()));
+
+        // Сжатие Vector даёт те же серии, а развёртывание — исходный Vector
+        const RleVector<int32_t> encoded(reference);
+        assert(encoded.RunCount() == 200 && std::equal(encoded.RunEnds().begin(), encoded.RunEnds().end(), series.RunEnds().begin()));
+        const Vector<int32_t> decoded = encoded.ToVector();
+        assert(decoded.Size() == reference.Size() && std::equal(decoded.begin(), decoded.end(), reference.begin()));
+
+        // Свёртки по сериям совпадают со свёртками по элементам
+        assert(Sum(series) == Sum(reference) && Min(series) == Min(reference) && Max(series) == Max(reference));
+        size_t visited = 0;
+        series.ForEachRun([&visited](int32_t, size_t length) {
+            visited += length;
+        });
+        assert(visited == series.Size());
+
+        const size_t runs = series.RunCount();
+        series.PopBack();
+        assert(series.RunCount() == runs && series.Size() == reference.Size() - 1);
+        for (size_t i = 0; i < 8; ++i) {
+            series.PopBack();
+        }
+        assert(series.RunCount() == runs - 1 && series[series.Size() - 1] == reference[reference.Size() - 10]);
+        series.Clear();
+        assert(series.Empty() && Sum(series) == 0 && Min(series) == std::numeric_limits<int32_t>::max());
+    }
+    {
+        // NaN не равен себе, поэтому каждый NaN — отдельная серия
+        Vector<double> values;
+        for (double value : { 1.0, 1.0, std::nan(""), std::nan(""), 2.0, 2.0, 2.0 }) {
+            values.PushBack(value);
+        }
+        const RleVector<double> encoded(values);
+        assert(encoded.RunCount() == 4 && encoded.RunLength(3) == 3 && std::isnan(encoded[3]));
+        assert(encoded.ToVector().Size() == 7 && Max(encoded) == 2.0);
+
+        RleVector<std::string> labels;
+        for (const char* label : { "idle", "idle", "busy", "busy", "busy", "idle" }) {
+            labels.PushBack(label);
+        }
+        assert(labels.RunCount() == 3 && labels[4] == "busy"s && labels[5] == "idle"s);
+        const Vector<std::string> expanded = labels.ToVector();
+        const RleVector<std::string> again(expanded);
+        assert(expanded.Size() == 6 && expanded[2] == "busy"s && again.RunCount() == 3);
+        assert(RleVector<std::string>(Vector<std::string>()).Empty());
+    }
+}
+
+void Test28() {
+    uint64_t seed = 5;
+    auto next_random = [&seed] {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed >> 11;
+    };
+    // Плотные идентификаторы, повторы, редкие большие скачки и скачки больше 2^32
+    const uint64_t GAPS[] = { 16, 1, 1000000, uint64_t{ 1 } << 40 };
+    for (uint64_t gap : GAPS) {
+        SortedIntVector ids;
+        Vector<uint64_t> reference;
+        uint64_t value = gap == 1 ? 0 : next_random() % 1000;
+        for (size_t i = 0; i < 3 * SortedIntVector::BLOCK + 50; ++i) {
+            value += gap == 1 ? next_random() % 2 : next_random() % gap;
+            ids.PushBack(value);
+            reference.PushBack(value);
+        }
+        assert(ids.Size() == reference.Size() && ids.BlockCount() == 3 && ids.Back() == reference[reference.Size() - 1]);
+        for (size_t i = 0; i < reference.Size(); ++i) {
+            assert(ids[i] == reference[i]);
+        }
+        const Vector<uint64_t> decoded = ids.ToVector();
+        assert(decoded.Size() == reference.Size() && std::equal(decoded.begin(), decoded.end(), reference.begin()));
+        size_t visited = 0;
+        ids.ForEachBlock([&](const uint64_t* values, size_t count) {
+            assert(std::equal(values, values + count, reference.begin() + visited));
+            visited += count;
+        });
+        assert(visited == reference.Size());
+
+        // LowerBound сверяется с std::lower_bound на значениях вектора, между ними и за краями
+        auto check = [&](uint64_t needle) {
+            const size_t expected = static_cast<size_t>(std::lower_bound(reference.begin(), reference.end(), needle) - reference.begin());
+            assert(ids.LowerBound(needle) == expected);
+            assert(ids.Contains(needle) == (expected < reference.Size() && reference[expected] == needle));
+        };
+        check(0);
+        check(~uint64_t{ 0 });
+        for (size_t i = 0; i < reference.Size(); ++i) {
+            check(reference[i]);
+            check(reference[i] + 1);
+            check(reference[i] - 1);
+        }
+
+        const SortedIntVector copy(reference);
+        assert(copy.Size() == ids.Size() && copy.CompressedBytes() == ids.CompressedBytes() && copy[200] == reference[200]);
+        if (gap == 16) {
+            // Смещения в блоке из 128 значений с шагом меньше 16 помещаются в 11 бит
+            assert(ids.CompressedBytes() < reference.Size() * 2 + 64 * sizeof(uint64_t));
+        }
+    }
+    {
+        SortedIntVector empty;
+        assert(empty.Empty() && empty.LowerBound(5) == 0 && !empty.Contains(0) && empty.ToVector().Size() == 0);
+        SortedIntVector same;
+        for (size_t i = 0; i < 300; ++i) {
+            same.PushBack(7);
+        }
+        assert(same.LowerBound(7) == 0 && same.LowerBound(8) == 300 && same[299] == 7 && same.BlockCount() == 2);
+        same.Clear();
+        same.PushBack(1);
+        assert(same.Size() == 1 && same[0] == 1);
+    }
+}
+
+void Test29() {
+    {
+        // Zigzag и известные записи
+        assert(ZigZagEncode(int32_t{ 0 }) == 0 && ZigZagEncode(int32_t{ -1 }) == 1 && ZigZagEncode(int32_t{ 1 }) == 2);
+        assert(ZigZagEncode(INT32_MIN) == UINT32_MAX && ZigZagEncode(INT32_MAX) == UINT32_MAX - 1);
+        assert(ZigZagEncode(INT64_MIN) == UINT64_MAX && ZigZagDecode(UINT64_MAX) == INT64_MIN);
+        for (int64_t value : { int64_t{ 0 }, int64_t{ -1 }, int64_t{ 63 }, int64_t{ -64 }, INT64_MAX, INT64_MIN }) {
+            assert(ZigZagDecode(ZigZagEncode(value)) == value);
+        }
+        assert(ZigZagDecode(ZigZagEncode(INT32_MIN)) == INT32_MIN);
+
+        ByteVector bytes;
+        AppendVarint(bytes, 0);
+        AppendVarint(bytes, 300);
+        AppendVarint(bytes, UINT64_MAX);
+        AppendZigZag(bytes, -2);
+        const uint8_t expected[] = { 0x00, 0xAC, 0x02, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x03 };
+        assert(bytes.Size() == sizeof(expected) && std::equal(bytes.begin(), bytes.end(), expected));
+        assert(VarintSize(0) == 1 && VarintSize(127) == 1 && VarintSize(128) == 2 && VarintSize(UINT32_MAX) == MAX_VARINT32_BYTES
+            && VarintSize(UINT64_MAX) == MAX_VARINT64_BYTES);
+
+        size_t pos = 0;
+        uint64_t value = 0;
+        assert(DecodeVarint(bytes.begin(), bytes.Size(), pos, value) && value == 0 && pos == 1);
+        assert(DecodeVarint(bytes.begin(), bytes.Size(), pos, value) && value == 300 && pos == 3);
+        uint32_t narrow = 0;
+        // UINT64_MAX не помещается в uint32_t
+        assert(!DecodeVarint(bytes.begin(), bytes.Size(), pos, narrow) && pos == 3);
+        assert(DecodeVarint(bytes.begin(), bytes.Size(), pos, value) && value == UINT64_MAX && pos == 13);
+        assert(DecodeVarint(bytes.begin(), bytes.Size(), pos, value) && ZigZagDecode(value) == -2 && pos == bytes.Size());
+        assert(!DecodeVarint(bytes.begin(), bytes.Size(), pos, value));
+    }
+
+    uint64_t seed = 29;
+    auto next_random = [&seed] {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed >> 11;
+    };
+    // Значения всех длин записи: чаще однобайтовые, чтобы векторные ядра проходили обе ветви
+    auto random_value = [&next_random](unsigned max_bits) {
+        const unsigned bits = next_random() % 4 != 0 ? 7 : 1 + static_cast<unsigned>(next_random() % max_bits);
+        const uint64_t value = next_random() | (next_random() << 53);
+        return bits == 64 ? value : value & ((uint64_t{ 1 } << bits) - 1);
+    };
+    for (size_t size : { 0, 1, 15, 16, 17, 63, 64, 65, 200, 1000, 3000 }) {
+        Vector<uint32_t> values32;
+        Vector<uint64_t> values64;
+        for (size_t i = 0; i < size; ++i) {
+            values32.PushBack(static_cast<uint32_t>(random_value(32)));
+            values64.PushBack(random_value(64));
+        }
+        ByteVector bytes32;
+        ByteVector bytes64;
+        AppendVarints(bytes32, values32.begin(), size);
+        AppendVarints(bytes64, values64.begin(), size);
+
+        VarintKernels::Dispatch().ForEachLevel([&](IsaLevel, const VarintKernels::Table& kernels) {
+            assert(kernels.count(bytes32.begin(), bytes32.Size()) == size);
+            assert(kernels.count(bytes64.begin(), bytes64.Size()) == size);
+            Vector<uint32_t> out32(size);
+            Vector<uint64_t> out64(size);
+            assert(kernels.decode32(bytes32.begin(), bytes32.Size(), out32.begin()) == size);
+            assert(kernels.decode64(bytes64.begin(), bytes64.Size(), out64.begin()) == size);
+            assert(std::equal(out32.begin(), out32.end(), values32.begin()));
+            assert(std::equal(out64.begin(), out64.end(), values64.begin()));
+            // 64-битные записи значений больше 2^32 не декодируются в uint32_t
+            const bool wide = std::any_of(values64.begin(), values64.end(), [](uint64_t value) {
+                return value > UINT32_MAX;
+            });
+            Vector<uint32_t> narrow(size);
+            assert((kernels.decode32(bytes64.begin(), bytes64.Size(), narrow.begin()) == VARINT_ERROR) == wide);
+            if (bytes64.Size() != 0) {
+                // Оборванная последняя запись
+                bytes64[bytes64.Size() - 1] |= 0x80;
+                assert(kernels.decode64(bytes64.begin(), bytes64.Size(), out64.begin()) == VARINT_ERROR);
+                bytes64[bytes64.Size() - 1] &= 0x7F;
+            }
+        });
+
+        // Добавление в конец непустых векторов
+        Vector<uint32_t> decoded32;
+        decoded32.PushBack(7);
+        assert(DecodeVarints(bytes32, decoded32) && decoded32.Size() == size + 1 && decoded32[0] == 7);
+        assert(std::equal(decoded32.begin() + 1, decoded32.end(), values32.begin()));
+        Vector<uint64_t> decoded64;
+        assert(DecodeVarints(bytes64, decoded64) && decoded64.Size() == size);
+        assert(std::equal(decoded64.begin(), decoded64.end(), values64.begin()));
+    }
+    {
+        // Слишком длинные записи посреди векторного блока и в хвосте
+        for (size_t offset : { 0, 3, 40, 90 }) {
+            ByteVector bytes;
+            for (size_t i = 0; i < offset; ++i) {
+                AppendVarint(bytes, i % 100);
+            }
+            for (size_t i = 0; i < MAX_VARINT64_BYTES; ++i) {
+                bytes.PushBack(0x80);
+            }
+            bytes.PushBack(0x01);
+            for (size_t i = 0; i < 100; ++i) {
+                AppendVarint(bytes, 5);
+            }
+            VarintKernels::Dispatch().ForEachLevel([&](IsaLevel, const VarintKernels::Table& kernels) {
+                Vector<uint64_t> out(kernels.count(bytes.begin(), bytes.Size()));
+                assert(kernels.decode64(bytes.begin(), bytes.Size(), out.begin()) == VARINT_ERROR);
+            });
+            Vector<uint64_t> out;
+            out.PushBack(1);
+            assert(!DecodeVarints(bytes, out) && out.Size() == 1 && out[0] == 1);
+        }
+        // Пятый байт uint32_t с битами за пределами слова
+        const uint8_t overflow[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x1F };
+        const uint8_t largest[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x0F };
+        Vector<uint32_t> out;
+        assert(!DecodeVarints(overflow, sizeof(overflow), out) && out.Size() == 0);
+        assert(DecodeVarints(largest, sizeof(largest), out) && out.Size() == 1 && out[0] == UINT32_MAX);
+
+        // Оборванное значение без единого законченного: пустой вектор не получает памяти, и ядра в неё не пишут
+        const uint8_t truncated[] = { 0x80, 0x81 };
+        Vector<uint32_t> empty32;
+        Vector<int64_t> empty64;
+        assert(!DecodeVarints(truncated, sizeof(truncated), empty32) && empty32.Size() == 0);
+        assert(!DecodeZigZags(truncated, sizeof(truncated), empty64) && empty64.Size() == 0);
+        VarintKernels::Dispatch().ForEachLevel([&](IsaLevel, const VarintKernels::Table& kernels) {
+            assert(kernels.decode32(truncated, sizeof(truncated), nullptr) == VARINT_ERROR);
+        });
+    }
+    {
+        Vector<int32_t> values32;
+        Vector<int64_t> values64;
+        for (size_t i = 0; i < 500; ++i) {
+            const int64_t value = static_cast<int64_t>(random_value(64));
+            values32.PushBack(static_cast<int32_t>(value % 1000 - 500));
+            values64.PushBack(i % 2 == 0 ? value : -value);
+        }
+        values32.PushBack(INT32_MIN);
+        values64.PushBack(INT64_MIN);
+        ByteVector bytes32;
+        ByteVector bytes64;
+        AppendZigZags(bytes32, values32.begin(), values32.Size());
+        AppendZigZags(bytes64, values64.begin(), values64.Size());
+        // Малые по модулю числа со знаком занимают один-два байта
+        assert(bytes32.Size() < values32.Size() * 2 + MAX_VARINT32_BYTES);
+        Vector<int32_t> decoded32;
+        Vector<int64_t> decoded64;
+        assert(DecodeZigZags(bytes32, decoded32) && decoded32.Size() == values32.Size());
+        assert(DecodeZigZags(bytes64, decoded64) && decoded64.Size() == values64.Size());
+        assert(std::equal(decoded32.begin(), decoded32.end(), values32.begin()));
+        assert(std::equal(decoded64.begin(), decoded64.end(), values64.begin()));
+    }
+}
+
+void Test30() {
+    {
+        // Append<T> пишет младший байт первым на любой платформе
+        ByteBuffer buffer;
+        buffer.Append(uint8_t{ 0x01 });
+        buffer.Append(uint16_t{ 0x0302 });
+        buffer.Append(uint32_t{ 0x07060504 });
+        buffer.Append(uint64_t{ 0x0F0E0D0C0B0A0908 });
+        buffer.Append(int16_t{ -2 });
+        const uint8_t expected[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0xFE, 0xFF };
+        assert(buffer.Size() == sizeof(expected));
+        assert(std::memcmp(buffer.Data(), expected, sizeof(expected)) == 0);
+
+        buffer.Clear();
+        const double pi = 3.14159;
+        buffer.Append(pi);
+        double read = 0;
+        std::memcpy(&read, buffer.Data(), sizeof(read));
+        assert(buffer.Size() == sizeof(double) && read == pi);
+    }
+    {
+        ByteBuffer buffer;
+        assert(buffer.Empty() && buffer.Capacity() == 0 && buffer.WritableSpan(0).Size() == 0);
+
+        // Запись через запасную память: место гарантируется один раз на всю запись
+        Span<std::byte> spare = buffer.WritableSpan(100);
+        assert(spare.Size() >= 100 && buffer.Size() == 0);
+        for (size_t i = 0; i < 100; ++i) {
+            spare[i] = static_cast<std::byte>(i);
+        }
+        buffer.Commit(60);
+        assert(buffer.Size() == 60);
+
+        // Рост переносит записанные байты и удваивает вместимость
+        const size_t capacity = buffer.Capacity();
+        spare = buffer.WritableSpan(capacity);
+        assert(buffer.Capacity() >= 2 * capacity && spare.Size() >= capacity && buffer.Size() == 60);
+        for (size_t i = 0; i < 60; ++i) {
+            assert(buffer.Bytes()[i] == static_cast<std::byte>(i));
+        }
+        const char text[] = "header";
+        buffer.Append(text, sizeof(text) - 1);
+        assert(buffer.Size() == 66 && std::memcmp(buffer.Data() + 60, text, 6) == 0);
+
+        // Release отдаёт ту же память без копирования
+        const std::byte* data = buffer.Data();
+        ByteBlock block = buffer.Release();
+        assert(block.memory.GetAddress() == data && block.size == 66 && block.Bytes().Size() == 66);
+        assert(buffer.Empty() && buffer.Capacity() == 0);
+
+        ByteBuffer reused(std::move(block));
+        assert(reused.Data() == data && reused.Size() == 66 && block.size == 0);
+        reused.Append(uint32_t{ 7 });
+        assert(reused.Size() == 70 && reused.Data() == data);
+
+        ByteBuffer moved(std::move(reused));
+        assert(moved.Size() == 70 && reused.Empty());
+        moved.Clear();
+        assert(moved.Empty() && moved.Capacity() >= 70);
+        moved.Reserve(10000);
+        assert(moved.Capacity() == 10000);
+    }
+}
+
+void Test31() {
+    // Содержимое буфера, собранное по его iovec
+    auto gather = [](const ChainedBuffer& buffer) {
+        std::vector<uint8_t> bytes;
+        for (const iovec& part : buffer.IoVecs()) {
+            assert(part.iov_len != 0);
+            const uint8_t* data = static_cast<const uint8_t*>(part.iov_base);
+            bytes.insert(bytes.end(), data, data + part.iov_len);
+        }
+        return bytes;
+    };
+    {
+        ChainedBuffer buffer(64, 16);
+        assert(buffer.Empty() && buffer.ChunkSize() == 64 && buffer.IoVecs().Size() == 0);
+        std::vector<uint8_t> reference;
+        uint8_t piece[150];
+        for (size_t i = 0; i < sizeof(piece); ++i) {
+            piece[i] = static_cast<uint8_t>(i * 7);
+        }
+        // Куски разной длины, в том числе длиннее блока
+        const uint8_t* first_byte = nullptr;
+        for (size_t length : { 1, 5, 40, 150, 0, 63, 64, 100 }) {
+            buffer.Append(piece, length);
+            reference.insert(reference.end(), piece, piece + length);
+            if (first_byte == nullptr) {
+                first_byte = static_cast<const uint8_t*>(buffer.IoVecs()[0].iov_base);
+            }
+            assert(buffer.Size() == reference.size() && gather(buffer) == reference);
+        }
+        // Записанные байты не переносятся при росте
+        assert(buffer.IoVecs()[0].iov_base == first_byte && buffer.ChunkCount() > 1);
+
+        // Заголовок в запасе первого блока, затем заголовок длиннее оставшегося запаса
+        const size_t chunks = buffer.ChunkCount();
+        const uint8_t header[] = { 0xAA, 0xBB, 0xCC };
+        buffer.Prepend(header, sizeof(header));
+        reference.insert(reference.begin(), header, header + sizeof(header));
+        assert(buffer.ChunkCount() == chunks && gather(buffer) == reference);
+        buffer.Prepend(piece, 100);
+        reference.insert(reference.begin(), piece, piece + 100);
+        assert(buffer.ChunkCount() > chunks && gather(buffer) == reference);
+        buffer.Prepend(uint16_t{ 0x0201 });
+        reference.insert(reference.begin(), { 0x01, 0x02 });
+        assert(gather(buffer) == reference);
+
+        // Частичная отправка: Consume посередине блока, ровно по границе блока и до конца
+        const size_t before_consume = buffer.ChunkCount();
+        for (size_t n : { 3, 10, 61, 200 }) {
+            buffer.Consume(n);
+            reference.erase(reference.begin(), reference.begin() + static_cast<std::ptrdiff_t>(n));
+            assert(buffer.Size() == reference.size() && gather(buffer) == reference);
+        }
+        // Отправленные блоки освобождаются
+        assert(buffer.ChunkCount() < before_consume);
+        buffer.Consume(buffer.Size());
+        assert(buffer.Empty() && buffer.ChunkCount() == 1 && buffer.IoVecs().Size() == 0);
+        // Запись продолжается в оставшийся блок
+        buffer.Append(uint32_t{ 0x04030201 });
+        const std::vector<uint8_t> bytes = gather(buffer);
+        assert(bytes.size() == 4 && bytes[0] == 1 && bytes[3] == 4);
+    }
+    {
+        // WritableSpan + Commit и блок ByteBuffer, присоединённый без копирования
+        ChainedBuffer buffer(32, 0);
+        Span<std::byte> spare = buffer.WritableSpan(20);
+        assert(spare.Size() == 32);
+        std::memset(spare.Data(), 1, 20);
+        buffer.Commit(20);
+        spare = buffer.WritableSpan(20);
+        assert(spare.Size() == 32 && buffer.ChunkCount() == 2);
+        buffer.Commit(0);
+
+        ByteBuffer body;
+        for (uint32_t i = 0; i < 100; ++i) {
+            body.Append(i);
+        }
+        const std::byte* body_data = body.Data();
+        buffer.Append(body.Release());
+        assert(buffer.Size() == 420 && buffer.IoVecs().Size() == 2 && buffer.IoVecs()[1].iov_base == body_data);
+
+        iovec parts[1];
+        assert(buffer.FillIoVecs(parts, 1) == 1 && parts[0].iov_len == 20);
+        Vector<std::byte> copy(buffer.Size());
+        buffer.CopyTo(copy.begin());
+        uint32_t last = 0;
+        std::memcpy(&last, copy.begin() + copy.Size() - sizeof(last), sizeof(last));
+        assert(copy[0] == std::byte{ 1 } && last == 99);
+
+        ChainedBuffer moved(std::move(buffer));
+        assert(moved.Size() == 420 && buffer.Empty());
+        moved.Clear();
+        assert(moved.Empty() && moved.ChunkCount() == 0);
+    }
+    {
+        // Просьба о целом блоке в пустом буфере выполняется без запаса под Prepend
+        ChainedBuffer buffer(4096, 64);
+        Span<std::byte> spare = buffer.WritableSpan(4096);
+        assert(spare.Size() == 4096 && buffer.ChunkCount() == 1);
+        std::memset(spare.Data(), 2, 4096);
+        buffer.Commit(4096);
+        const uint32_t header = 4096;
+        buffer.Prepend(header);
+        assert(buffer.Size() == 4100 && buffer.ChunkCount() == 2);
+        const std::vector<uint8_t> bytes = gather(buffer);
+        assert(bytes[1] == 0x10 && bytes[4] == 2 && bytes[4099] == 2);
+
+        ChainedBuffer small(4096, 64);
+        assert(small.WritableSpan(100).Size() == 4096 - 64);
+    }
+}
+
 struct C {
     C() noexcept {
         ++def_ctor;
@@ -648,7 +2936,924 @@ void Benchmark() {
     }
 }
 
-int main() {
+/*
+*   Масштабирование одновременного добавления элементов: ConcurrentVector
+*   против Vector, защищённого мьютексом, на 1..N потоках.
+*/
+void BenchmarkConcurrentPushBack() {
+    using namespace std;
+    const size_t TOTAL = 1 << 20;
+    const size_t max_threads = max<size_t>(thread::hardware_concurrency(), 4);
+
+    auto measure = [](size_t threads, auto push) {
+        const auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&push, threads] {
+                for (size_t i = 0; i < TOTAL / threads; ++i) {
+                    push(i);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    };
+
+    cerr << "Concurrent PushBack of "sv << TOTAL << " elements:"sv << endl;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        ConcurrentVector<size_t> concurrent;
+        const auto concurrent_us = measure(threads, [&concurrent](size_t value) {
+            concurrent.PushBack(value);
+        });
+
+        Vector<size_t> locked;
+        mutex m;
+        const auto locked_us = measure(threads, [&locked, &m](size_t value) {
+            lock_guard lock(m);
+            locked.PushBack(value);
+        });
+
+        cerr << "  threads: "sv << threads
+            << ", ConcurrentVector: "sv << concurrent_us << " us"sv
+            << ", mutex + Vector: "sv << locked_us << " us"sv << endl;
+    }
+}
+
+/*
+*   Ложное разделение строк кэша: потоки увеличивают каждый свой счётчик
+*   в обычном Vector (соседние счётчики на одной строке) и в PaddedVector.
+*/
+void BenchmarkFalseSharing() {
+    using namespace std;
+    const size_t ITERATIONS = 1 << 22;
+    const size_t threads = max<size_t>(thread::hardware_concurrency(), 4);
+
+    auto measure = [threads](auto& counters) {
+        const auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&counters, t] {
+                for (size_t i = 0; i < ITERATIONS; ++i) {
+                    counters[t].fetch_add(1, memory_order_relaxed);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    };
+
+    Vector<atomic<size_t>> packed(threads);
+    PaddedVector<atomic<size_t>> padded(threads);
+    const auto packed_us = measure(packed);
+    const auto padded_us = measure(padded);
+    assert(padded.Reduce(size_t(0)) == threads * ITERATIONS);
+
+    cerr << "Per-thread counters, "sv << threads << " threads x "sv << ITERATIONS << " increments:"sv << endl
+        << "  Vector: "sv << packed_us << " us"sv
+        << ", PaddedVector: "sv << padded_us << " us"sv << endl;
+}
+
+/*
+*   Замеряет REPEATS вызовов run и возвращает время в микросекундах и сумму результатов,
+*   которая не даёт компилятору выбросить вызовы.
+*/
+template <typename Run>
+auto MeasureRepeats(size_t repeats, Run run) {
+    using namespace std;
+    decltype(run()) checksum{};
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < repeats; ++i) {
+        checksum += run();
+    }
+    const auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    return make_pair(us, checksum);
+}
+
+/*
+*   Поиск по Vector<int32_t>: std::find и std::count против ядер Find и Count каждого уровня.
+*/
+void BenchmarkSearch() {
+    using namespace std;
+    const size_t SIZE = 1 << 20;
+    const size_t REPEATS = 50;
+    Vector<int32_t> ids(SIZE);
+    for (size_t i = 0; i < SIZE; ++i) {
+        ids[i] = static_cast<int32_t>(i % 1000);
+    }
+    ids[SIZE - 1] = -1;
+    const auto equal = static_cast<size_t>(CompareOp::Equal);
+
+    const auto std_find = MeasureRepeats(REPEATS, [&ids] {
+        return static_cast<size_t>(find(ids.begin(), ids.end(), -1) - ids.begin());
+    });
+    const auto std_count = MeasureRepeats(REPEATS, [&ids] {
+        return static_cast<size_t>(count(ids.begin(), ids.end(), 7));
+    });
+    cerr << "Search in "sv << SIZE << " int32 ids x "sv << REPEATS << " (active: "sv << IsaName(ActiveIsaLevel()) << "):"sv << endl
+        << "  std: find "sv << std_find.first << " us"sv << ", count "sv << std_count.first << " us"sv << endl;
+
+    SearchKernels<int32_t>::Dispatch().ForEachLevel([&](IsaLevel level, const auto& kernels) {
+        const auto find = MeasureRepeats(REPEATS, [&] {
+            return kernels.find_if[equal](ids.begin(), ids.Size(), -1);
+        });
+        const auto count = MeasureRepeats(REPEATS, [&] {
+            return kernels.count_if[equal](ids.begin(), ids.Size(), 7);
+        });
+        assert(find.second == std_find.second && count.second == std_count.second);
+        cerr << "  "sv << IsaName(level) << ": find "sv << find.first << " us"sv << ", count "sv << count.first << " us"sv << endl;
+    });
+}
+
+/*
+*   Свёртки Vector<double>: простой цикл и точные режимы суммирования против ядер каждого уровня.
+*/
+void BenchmarkReduce() {
+    using namespace std;
+    const size_t SIZE = 1 << 20;
+    const size_t REPEATS = 50;
+    Vector<double> values(SIZE);
+    for (size_t i = 0; i < SIZE; ++i) {
+        values[i] = static_cast<double>(i % 1000) * 0.25;
+    }
+    // Чтение через volatile не даёт компилятору вынести одинаковые свёртки из цикла повторов
+    Vector<double>* volatile source = &values;
+
+    const auto loop = MeasureRepeats(REPEATS, [&source] {
+        double sum = 0;
+        for (double x : *source) {
+            sum += x;
+        }
+        return sum;
+    });
+    const auto pairwise = MeasureRepeats(REPEATS, [&source] {
+        return Sum(*source, SumMode::Pairwise);
+    });
+    const auto kahan = MeasureRepeats(REPEATS, [&source] {
+        return Sum(*source, SumMode::Kahan);
+    });
+    // Слагаемые кратны 0.25, поэтому все режимы и уровни суммируют точно
+    assert(pairwise.second == loop.second && kahan.second == loop.second);
+    cerr << "Reduce "sv << SIZE << " doubles x "sv << REPEATS << " (active: "sv << IsaName(ActiveIsaLevel()) << "):"sv << endl
+        << "  loop: "sv << loop.first << " us"sv << ", Pairwise: "sv << pairwise.first << " us"sv
+        << ", Kahan: "sv << kahan.first << " us"sv << endl;
+
+    ReduceKernels<double>::Dispatch().ForEachLevel([&](IsaLevel level, const auto& kernels) {
+        const auto sum = MeasureRepeats(REPEATS, [&] {
+            return kernels.sum(source->begin(), source->Size());
+        });
+        const auto min = MeasureRepeats(REPEATS, [&] {
+            return kernels.min(source->begin(), source->Size());
+        });
+        const auto dot = MeasureRepeats(REPEATS, [&] {
+            return kernels.dot(source->begin(), source->begin(), source->Size());
+        });
+        assert(sum.second == loop.second);
+        cerr << "  "sv << IsaName(level) << ": Sum "sv << sum.first << " us"sv << ", Min "sv << min.first << " us"sv
+            << ", Dot "sv << dot.first << " us"sv << endl;
+    });
+}
+
+/*
+*   Заполнение таблицы сигнальным значением. Новая таблица: Vector(n) с циклом против Vector(n, value).
+*   Перезапись существующей: std::fill против Assign и ядер заполнения каждого уровня,
+*   обычными и потоковыми записями. Таблица больше порога потоковой записи.
+*/
+void BenchmarkFill() {
+    using namespace std;
+    const size_t SIZE = max(size_t{ 1 } << 23, 2 * NonTemporalThreshold() / sizeof(int64_t));
+    const size_t REPEATS = 3;
+    // Сигнальное значение из разных байтов, которое нельзя записать через memset
+    const int64_t SENTINEL = -2;
+
+    const auto two_pass = MeasureRepeats(REPEATS, [&] {
+        Vector<int64_t> table(SIZE);
+        for (auto& x : table) {
+            x = SENTINEL;
+        }
+        return table[SIZE - 1];
+    });
+    const auto one_pass = MeasureRepeats(REPEATS, [&] {
+        Vector<int64_t> table(SIZE, SENTINEL);
+        return table[SIZE - 1];
+    });
+    assert(two_pass.second == one_pass.second);
+    cerr << "Fill "sv << SIZE * sizeof(int64_t) / (1 << 20) << " MB x "sv << REPEATS
+        << " (active: "sv << IsaName(ActiveIsaLevel()) << ", non-temporal from "sv
+        << NonTemporalThreshold() / (1 << 20) << " MB):"sv << endl
+        << "  new table: Vector(n) + loop "sv << two_pass.first << " us"sv
+        << ", Vector(n, value) "sv << one_pass.first << " us"sv << endl;
+
+    Vector<int64_t> table(SIZE, 0);
+    const auto std_fill = MeasureRepeats(REPEATS, [&] {
+        fill(table.begin(), table.end(), SENTINEL);
+        return table[SIZE - 1];
+    });
+    const auto assign = MeasureRepeats(REPEATS, [&] {
+        table.Assign(SIZE, SENTINEL);
+        return table[SIZE - 1];
+    });
+    assert(std_fill.second == one_pass.second && assign.second == one_pass.second);
+    cerr << "  refill: std::fill "sv << std_fill.first << " us"sv << ", Assign "sv << assign.first << " us"sv << endl;
+
+    MemoryKernels::Dispatch().ForEachLevel([&](IsaLevel level, const MemoryKernels::Table& kernels) {
+        const auto fill = MeasureRepeats(REPEATS, [&] {
+            kernels.fill(table.begin(), FillPatternOf(SENTINEL), SIZE * sizeof(int64_t));
+            return table[SIZE - 1];
+        });
+        const auto stream = MeasureRepeats(REPEATS, [&] {
+            kernels.stream_fill(table.begin(), FillPatternOf(SENTINEL), SIZE * sizeof(int64_t));
+            return table[SIZE - 1];
+        });
+        assert(fill.second == one_pass.second && stream.second == one_pass.second);
+        cerr << "  "sv << IsaName(level) << ": fill "sv << fill.first << " us"sv << ", stream "sv << stream.first << " us"sv << endl;
+    });
+}
+
+/*
+*   Вытеснение рабочего набора переносом большого Vector при перевыделении.
+*   Рабочий набор — случайный обход массива в 1 МБ, который помещается в кэш. Его время измеряется
+*   до и после Reserve вектора вдвое больше порога потоковой записи при каждой политике переноса;
+*   рост времени обхода после переноса — это промахи кэша, которые перенос причинил остальной программе.
+*/
+void BenchmarkRelocation() {
+    using namespace std;
+    const size_t WORKING_SET = (size_t{ 1 } << 20) / sizeof(uint32_t);
+    const size_t STEPS = size_t{ 1 } << 21;
+    const size_t SIZE = max(size_t{ 1 } << 23, 2 * NonTemporalThreshold() / sizeof(int64_t));
+    const size_t ROUNDS = 3;
+
+    // Один цикл через все элементы (алгоритм Саттоло), чтобы предвыборка не угадывала адреса
+    Vector<uint32_t> next(WORKING_SET);
+    for (size_t i = 0; i < WORKING_SET; ++i) {
+        next[i] = static_cast<uint32_t>(i);
+    }
+    uint64_t seed = 42;
+    for (size_t i = WORKING_SET - 1; i > 0; --i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        swap(next[i], next[(seed >> 33) % i]);
+    }
+    auto chase = [&next, STEPS] {
+        uint32_t position = 0;
+        for (size_t i = 0; i < STEPS; ++i) {
+            position = next[position];
+        }
+        return static_cast<size_t>(position);
+    };
+
+    cerr << "Relocation of "sv << SIZE * sizeof(int64_t) / (1 << 20) << " MB with a "sv
+        << WORKING_SET * sizeof(uint32_t) / (1 << 10) << " KB working set, "sv << STEPS << " steps x "sv << ROUNDS << ":"sv << endl;
+    for (RelocationPolicy policy : { RelocationPolicy::Cached, RelocationPolicy::Streaming }) {
+        long long relocation = 0;
+        long long warm = 0;
+        long long polluted = 0;
+        for (size_t round = 0; round < ROUNDS; ++round) {
+            Vector<int64_t> table(SIZE, 1);
+            table.SetRelocationPolicy(policy);
+            MeasureRepeats(2, chase);
+            warm += MeasureRepeats(1, chase).first;
+            relocation += MeasureRepeats(1, [&table, SIZE] {
+                table.Reserve(SIZE + 1);
+                return table[SIZE - 1];
+            }).first;
+            polluted += MeasureRepeats(1, chase).first;
+        }
+        cerr << "  "sv << (policy == RelocationPolicy::Cached ? "Cached"sv : "Streaming"sv) << ": relocation "sv
+            << relocation << " us"sv << ", working set warm "sv << warm << " us"sv << ", after relocation "sv << polluted << " us"sv << endl;
+    }
+}
+
+/*
+*   Цикл, которому нужны два поля из девяти: Vector<Particle> против SoAVector с теми же полями.
+*   Сумма одного поля по столбцу идёт векторным ядром свёртки.
+*/
+void BenchmarkSoA() {
+    using namespace std;
+    struct Particle {
+        double x, y, z;
+        double vx, vy, vz;
+        double mass, charge, age;
+    };
+    using Particles = SoAVector<double, double, double, double, double, double, double, double, double>;
+    const size_t SIZE = size_t{ 1 } << 20;
+    const size_t REPEATS = 20;
+    const double DT = 0.5;
+
+    Vector<Particle> aos(SIZE);
+    Particles soa;
+    soa.Reserve(SIZE);
+    for (size_t i = 0; i < SIZE; ++i) {
+        const double position = static_cast<double>(i % 1000);
+        aos[i] = Particle{ position, 0, 0, 1, 0, 0, 2, 0, 0 };
+        soa.EmplaceBack(position, 0.0, 0.0, 1.0, 0.0, 0.0, 2.0, 0.0, 0.0);
+    }
+
+    const auto aos_step = MeasureRepeats(REPEATS, [&aos, DT] {
+        for (auto& p : aos) {
+            p.x += p.vx * DT;
+        }
+        return aos[SIZE - 1].x;
+    });
+    const auto soa_step = MeasureRepeats(REPEATS, [&soa, DT] {
+        const Span<double> x = soa.Column<0>();
+        const Span<const double> vx = soa.Column<3>();
+        for (size_t i = 0; i < x.Size(); ++i) {
+            x[i] += vx[i] * DT;
+        }
+        return x[SIZE - 1];
+    });
+    const auto aos_mass = MeasureRepeats(REPEATS, [&aos] {
+        double mass = 0;
+        for (const auto& p : aos) {
+            mass += p.mass;
+        }
+        return mass;
+    });
+    const auto soa_mass = MeasureRepeats(REPEATS, [&soa] {
+        const Span<const double> mass = soa.Column<6>();
+        return ReduceKernels<double>::Active().sum(mass.Data(), mass.Size());
+    });
+    assert(aos_step.second == soa_step.second && aos_mass.second == soa_mass.second);
+    cerr << "Particles "sv << SIZE << " x 9 fields x "sv << REPEATS << ":"sv << endl
+        << "  x += vx * dt: Vector<Particle> "sv << aos_step.first << " us"sv << ", SoAVector "sv << soa_step.first << " us"sv << endl
+        << "  sum of mass: Vector<Particle> "sv << aos_mass.first << " us"sv << ", SoAVector "sv << soa_mass.first << " us"sv << endl;
+}
+
+/*
+*   Перенос двух полей из девяти в столбцы и обратно: цикл EmplaceBack и поэлементная запись
+*   против ToSoA и ToAoS. Отдельно — ядра чтения с шагом на каждом уровне.
+*/
+void BenchmarkConvert() {
+    using namespace std;
+    struct Particle {
+        double x, y, z;
+        double vx, vy, vz;
+        double mass, charge, age;
+    };
+    const size_t SIZE = size_t{ 1 } << 20;
+    const size_t REPEATS = 10;
+
+    Vector<Particle> particles(SIZE);
+    for (size_t i = 0; i < SIZE; ++i) {
+        particles[i].x = static_cast<double>(i);
+        particles[i].vx = static_cast<double>(i % 100);
+    }
+
+    const auto loop_soa = MeasureRepeats(REPEATS, [&particles] {
+        SoAVector<double, double> columns;
+        columns.Reserve(particles.Size());
+        for (const auto& p : particles) {
+            columns.EmplaceBack(p.x, p.vx);
+        }
+        return columns[SIZE - 1].Get<1>();
+    });
+    const auto convert_soa = MeasureRepeats(REPEATS, [&particles] {
+        const auto columns = ToSoA(particles, &Particle::x, &Particle::vx);
+        return columns[SIZE - 1].Get<1>();
+    });
+    const auto columns = ToSoA(particles, &Particle::x, &Particle::vx);
+    const auto loop_aos = MeasureRepeats(REPEATS, [&columns] {
+        Vector<Particle> records(columns.Size());
+        const Span<const double> x = columns.Column<0>();
+        const Span<const double> vx = columns.Column<1>();
+        for (size_t i = 0; i < records.Size(); ++i) {
+            records[i].x = x[i];
+            records[i].vx = vx[i];
+        }
+        return records[SIZE - 1].vx;
+    });
+    const auto convert_aos = MeasureRepeats(REPEATS, [&columns] {
+        const Vector<Particle> records = ToAoS(columns, &Particle::x, &Particle::vx);
+        return records[SIZE - 1].vx;
+    });
+    assert(loop_soa.second == convert_soa.second && loop_aos.second == convert_aos.second);
+    cerr << "AoS <-> SoA, "sv << SIZE << " particles, 2 of 9 fields x "sv << REPEATS << ":"sv << endl
+        << "  to columns: EmplaceBack loop "sv << loop_soa.first << " us"sv << ", ToSoA "sv << convert_soa.first << " us"sv << endl
+        << "  to records: assignment loop "sv << loop_aos.first << " us"sv << ", ToAoS "sv << convert_aos.first << " us"sv << endl;
+
+    vector<double> out(SIZE);
+    StridedKernels::Dispatch().ForEachLevel([&](IsaLevel level, const auto& kernels) {
+        const auto gather = MeasureRepeats(REPEATS, [&] {
+            kernels.gather64(&particles[0].vx, sizeof(Particle), SIZE, out.data());
+            return out[SIZE - 1];
+        });
+        const auto scatter = MeasureRepeats(REPEATS, [&] {
+            kernels.scatter64(out.data(), SIZE, &particles[0].vx, sizeof(Particle));
+            return particles[SIZE - 1].vx;
+        });
+        cerr << "  "sv << IsaName(level) << ": gather "sv << gather.first << " us"sv
+            << ", scatter "sv << scatter.first << " us"sv << endl;
+    });
+}
+
+/*
+*   Маска фильтра по строкам: Vector<bool> (байт на флаг) против BitVector.
+*   Подсчёт отобранных строк, пересечение двух масок, ядра подсчёта единиц по уровням и Rank/Select.
+*/
+void BenchmarkBits() {
+    using namespace std;
+    const size_t SIZE = size_t{ 1 } << 26;
+    const size_t REPEATS = 10;
+    const size_t QUERIES = 1 << 20;
+
+    Vector<bool> byte_mask(SIZE), byte_filter(SIZE);
+    BitVector bit_mask(SIZE), bit_filter(SIZE);
+    uint64_t seed = 42;
+    for (size_t i = 0; i < SIZE; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        const bool selected = (seed >> 40) % 3 == 0;
+        const bool passed = (seed >> 50) % 2 == 0;
+        byte_mask[i] = selected;
+        byte_filter[i] = passed;
+        bit_mask.Set(i, selected);
+        bit_filter.Set(i, passed);
+    }
+
+    const auto byte_count = MeasureRepeats(REPEATS, [&byte_mask] {
+        size_t count = 0;
+        for (bool selected : byte_mask) {
+            count += selected ? 1 : 0;
+        }
+        return count;
+    });
+    const auto bit_count = MeasureRepeats(REPEATS, [&bit_mask] {
+        return bit_mask.Count();
+    });
+    const auto byte_and = MeasureRepeats(REPEATS, [&byte_mask, &byte_filter] {
+        Vector<bool> result(byte_mask);
+        for (size_t i = 0; i < result.Size(); ++i) {
+            result[i] = result[i] && byte_filter[i];
+        }
+        return result[SIZE - 1];
+    });
+    const auto bit_and = MeasureRepeats(REPEATS, [&bit_mask, &bit_filter] {
+        BitVector result(bit_mask);
+        result.And(bit_filter);
+        return result[SIZE - 1];
+    });
+    assert(byte_count.second == bit_count.second && byte_and.second == bit_and.second);
+    cerr << "Filter mask of "sv << SIZE << " rows x "sv << REPEATS << ": Vector<bool> "sv << SIZE / (1 << 20) << " MB, BitVector "sv
+        << SIZE / 8 / (1 << 20) << " MB"sv << endl
+        << "  count: Vector<bool> "sv << byte_count.first << " us"sv << ", BitVector "sv << bit_count.first << " us"sv << endl
+        << "  copy and AND: Vector<bool> "sv << byte_and.first << " us"sv << ", BitVector "sv << bit_and.first << " us"sv << endl;
+
+    const Span<const uint64_t> words = bit_mask.Words();
+    BitKernels::Dispatch().ForEachLevel([&](IsaLevel level, const auto& kernels) {
+        const auto count = MeasureRepeats(REPEATS, [&] {
+            return kernels.pop_count(words.Data(), words.Size());
+        });
+        cerr << "  "sv << IsaName(level) << ": popcount "sv << count.first << " us"sv << endl;
+    });
+
+    const size_t total = bit_mask.Count();
+    const auto linear = MeasureRepeats(1, [&bit_mask, total] {
+        size_t sum = 0;
+        for (size_t q = 0; q < 64; ++q) {
+            sum += bit_mask.Select(total - 1 - q * (total / 64));
+        }
+        return sum;
+    });
+    bit_mask.BuildRankIndex();
+    const auto indexed = MeasureRepeats(1, [&bit_mask, total, QUERIES] {
+        size_t sum = 0;
+        for (size_t q = 0; q < QUERIES; ++q) {
+            const size_t k = (q * 2654435761u) % total;
+            sum += bit_mask.Rank(bit_mask.Select(k)) - k;
+        }
+        return sum;
+    });
+    assert(indexed.second == 0);
+    cerr << "  Select without index: "sv << linear.first * 1000 / 64 << " ns/query"sv
+        << ", Select + Rank with index: "sv << indexed.first * 1000 / QUERIES << " ns/query"sv << endl;
+}
+
+/*
+*   Столбец значений, которым хватает 17 бит: Vector<uint32_t> против PackedIntVector<17>.
+*   Сумма при последовательном чтении блоками и при случайном доступе, распаковка по уровням.
+*/
+void BenchmarkPacked() {
+    using namespace std;
+    const size_t SIZE = size_t{ 1 } << 24;
+    const size_t REPEATS = 10;
+    const size_t BLOCK = 1024;
+    const size_t LOOKUPS = size_t{ 1 } << 22;
+
+    Vector<uint32_t> plain;
+    PackedIntVector<17> packed;
+    plain.Reserve(SIZE);
+    packed.Reserve(SIZE);
+    uint64_t seed = 42;
+    for (size_t i = 0; i < SIZE; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        const uint32_t value = static_cast<uint32_t>(seed >> 47);
+        plain.PushBack(value);
+        packed.PushBack(value);
+    }
+
+    const auto plain_scan = MeasureRepeats(REPEATS, [&plain] {
+        uint64_t sum = 0;
+        for (uint32_t value : plain) {
+            sum += value;
+        }
+        return sum;
+    });
+    const auto packed_scan = MeasureRepeats(REPEATS, [&packed, BLOCK] {
+        uint32_t block[BLOCK];
+        uint64_t sum = 0;
+        for (size_t first = 0; first < packed.Size(); first += BLOCK) {
+            const size_t count = std::min(BLOCK, packed.Size() - first);
+            packed.Unpack(first, count, block);
+            for (size_t i = 0; i < count; ++i) {
+                sum += block[i];
+            }
+        }
+        return sum;
+    });
+    const auto plain_lookup = MeasureRepeats(REPEATS, [&plain, LOOKUPS] {
+        uint64_t sum = 0;
+        for (size_t q = 0; q < LOOKUPS; ++q) {
+            sum += plain[(q * 2654435761u) % SIZE];
+        }
+        return sum;
+    });
+    const auto packed_lookup = MeasureRepeats(REPEATS, [&packed, LOOKUPS] {
+        uint64_t sum = 0;
+        for (size_t q = 0; q < LOOKUPS; ++q) {
+            sum += packed[(q * 2654435761u) % SIZE];
+        }
+        return sum;
+    });
+    assert(plain_scan.second == packed_scan.second && plain_lookup.second == packed_lookup.second);
+    cerr << "Column of "sv << SIZE << " 17-bit values x "sv << REPEATS << ": Vector<uint32_t> "sv
+        << plain.Size() * sizeof(uint32_t) / (1 << 20) << " MB, PackedIntVector<17> "sv
+        << packed.Words().Size() * sizeof(uint64_t) / (1 << 20) << " MB"sv << endl
+        << "  sequential sum: Vector "sv << plain_scan.first << " us"sv << ", packed in blocks of "sv << BLOCK << " "sv
+        << packed_scan.first << " us"sv << endl
+        << "  "sv << LOOKUPS << " random lookups: Vector "sv << plain_lookup.first << " us"sv << ", packed "sv << packed_lookup.first << " us"sv << endl;
+
+    const Span<const uint64_t> words = packed.Words();
+    vector<uint32_t> out(SIZE);
+    PackedKernels::Dispatch().ForEachLevel([&](IsaLevel level, const auto& kernels) {
+        const auto unpack = MeasureRepeats(REPEATS, [&] {
+            kernels.unpack(words.Data(), 17, 0, SIZE, out.data());
+            return out[SIZE - 1];
+        });
+        cerr << "  "sv << IsaName(level) << ": unpack "sv << unpack.first << " us"sv << endl;
+    });
+}
+
+/*
+*   Столбец строк с 300 различными значениями: Vector<std::string> против DictVector<std::string>.
+*   Подсчёт строк, равных значению, и маска строк по условию на значение.
+*/
+void BenchmarkDict() {
+    using namespace std;
+    const size_t SIZE = size_t{ 1 } << 22;
+    const size_t DISTINCT = 300;
+    const size_t REPEATS = 5;
+
+    Vector<string> plain;
+    DictVector<string> dict;
+    plain.Reserve(SIZE);
+    dict.Reserve(SIZE);
+    uint64_t seed = 42;
+    for (size_t i = 0; i < SIZE; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        string city = "city number "s + to_string((seed >> 33) % DISTINCT);
+        plain.PushBack(city);
+        dict.PushBack(move(city));
+    }
+    const string needle = "city number 123"s;
+
+    const auto plain_count = MeasureRepeats(REPEATS, [&plain, &needle] {
+        size_t count = 0;
+        for (const string& city : plain) {
+            count += city == needle ? 1 : 0;
+        }
+        return count;
+    });
+    const auto dict_count = MeasureRepeats(REPEATS, [&dict, &needle] {
+        return dict.Count(needle);
+    });
+    const auto plain_where = MeasureRepeats(REPEATS, [&plain] {
+        BitVector mask(plain.Size());
+        for (size_t i = 0; i < plain.Size(); ++i) {
+            if (plain[i].back() == '7') {
+                mask.Set(i);
+            }
+        }
+        return mask.Count();
+    });
+    const auto dict_where = MeasureRepeats(REPEATS, [&dict] {
+        return dict.Where([](const string& city) {
+            return city.back() == '7';
+        }).Count();
+    });
+    assert(plain_count.second == dict_count.second && plain_where.second == dict_where.second);
+
+    // Короткие строки хранятся внутри объекта string, поэтому куча в оценке не учитывается
+    const size_t plain_bytes = plain.Size() * sizeof(string);
+    const size_t dict_bytes = dict.Size() * (dict.GetCodeWidth() == CodeWidth::Bits8 ? 1 : 2) + dict.DictionarySize() * (sizeof(string) + 2 * sizeof(uint32_t));
+    cerr << "String column of "sv << SIZE << " rows, "sv << DISTINCT << " distinct x "sv << REPEATS << ": Vector<string> ~"sv
+        << plain_bytes / (1 << 20) << " MB, DictVector ~"sv << dict_bytes / (1 << 20) << " MB"sv << endl
+        << "  count equal: Vector<string> "sv << plain_count.first << " us"sv << ", DictVector "sv << dict_count.first << " us"sv << endl
+        << "  mask by predicate: Vector<string> "sv << plain_where.first << " us"sv << ", DictVector "sv << dict_where.first << " us"sv << endl;
+}
+
+/*
+*   Временной ряд с сериями одинаковых значений средней длины 1000:
+*   свёртки Vector против свёрток по сериям, сжатие, развёртывание и доступ по индексу.
+*/
+void BenchmarkRle() {
+    using namespace std;
+    const size_t SIZE = size_t{ 1 } << 24;
+    const size_t REPEATS = 10;
+    const size_t LOOKUPS = size_t{ 1 } << 20;
+
+    Vector<int32_t> plain;
+    plain.Reserve(SIZE);
+    uint64_t seed = 42;
+    int32_t value = 0;
+    while (plain.Size() < SIZE) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        value += static_cast<int32_t>((seed >> 40) % 21) - 10;
+        const size_t length = std::min<size_t>(SIZE - plain.Size(), 1 + (seed >> 33) % 2000);
+        for (size_t i = 0; i < length; ++i) {
+            plain.PushBack(value);
+        }
+    }
+
+    RleVector<int32_t> runs;
+    const auto encode = MeasureRepeats(1, [&plain, &runs] {
+        runs = RleVector<int32_t>(plain);
+        return runs.RunCount();
+    });
+    const auto plain_sum = MeasureRepeats(REPEATS, [&plain] {
+        return Sum(plain) + Max(plain) - Min(plain);
+    });
+    const auto rle_sum = MeasureRepeats(REPEATS, [&runs] {
+        return Sum(runs) + Max(runs) - Min(runs);
+    });
+    const auto decode = MeasureRepeats(1, [&runs] {
+        return runs.ToVector().Size();
+    });
+    const auto lookup = MeasureRepeats(1, [&runs, LOOKUPS] {
+        int64_t sum = 0;
+        for (size_t q = 0; q < LOOKUPS; ++q) {
+            sum += runs[(q * 2654435761u) % SIZE];
+        }
+        return sum;
+    });
+    assert(plain_sum.second == rle_sum.second && decode.second == SIZE);
+    cerr << "Time series of "sv << SIZE << " values in "sv << runs.RunCount() << " runs:"sv << endl
+        << "  Sum + Max - Min x "sv << REPEATS << ": Vector "sv << plain_sum.first << " us"sv << ", RleVector "sv << rle_sum.first << " us"sv << endl
+        << "  encode "sv << encode.first << " us"sv << ", decode "sv << decode.first << " us"sv << ", "sv
+        << LOOKUPS << " random lookups "sv << lookup.first << " us"sv << endl;
+}
+
+/*
+*   Отсортированный список идентификаторов со средним шагом 8: Vector<uint64_t> против SortedIntVector.
+*   Объём, LowerBound и полный проход со свёрткой.
+*/
+void BenchmarkSortedInts() {
+    using namespace std;
+    const size_t SIZE = size_t{ 1 } << 24;
+    const size_t REPEATS = 5;
+    const size_t LOOKUPS = size_t{ 1 } << 20;
+
+    Vector<uint64_t> plain;
+    plain.Reserve(SIZE);
+    uint64_t seed = 42;
+    uint64_t id = 1000000;
+    for (size_t i = 0; i < SIZE; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        id += 1 + (seed >> 33) % 15;
+        plain.PushBack(id);
+    }
+    SortedIntVector packed;
+    const auto encode = MeasureRepeats(1, [&plain, &packed] {
+        packed = SortedIntVector(plain);
+        return packed.Size();
+    });
+
+    const uint64_t first = plain[0];
+    const uint64_t span = plain[SIZE - 1] - first;
+    const auto plain_lookup = MeasureRepeats(REPEATS, [&plain, first, span, LOOKUPS] {
+        size_t sum = 0;
+        for (size_t q = 0; q < LOOKUPS; ++q) {
+            const uint64_t needle = first + (q * 2654435761u) % span;
+            sum += static_cast<size_t>(std::lower_bound(plain.begin(), plain.end(), needle) - plain.begin());
+        }
+        return sum;
+    });
+    const auto packed_lookup = MeasureRepeats(REPEATS, [&packed, first, span, LOOKUPS] {
+        size_t sum = 0;
+        for (size_t q = 0; q < LOOKUPS; ++q) {
+            sum += packed.LowerBound(first + (q * 2654435761u) % span);
+        }
+        return sum;
+    });
+    const auto plain_scan = MeasureRepeats(REPEATS, [&plain] {
+        uint64_t sum = 0;
+        for (uint64_t value : plain) {
+            sum += value;
+        }
+        return sum;
+    });
+    const auto packed_scan = MeasureRepeats(REPEATS, [&packed] {
+        uint64_t sum = 0;
+        packed.ForEachBlock([&sum](const uint64_t* values, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                sum += values[i];
+            }
+        });
+        return sum;
+    });
+    assert(plain_lookup.second == packed_lookup.second && plain_scan.second == packed_scan.second);
+    cerr << "Sorted IDs, "sv << SIZE << " values: Vector "sv << plain.Size() * sizeof(uint64_t) / (1 << 20) << " MB, SortedIntVector "sv
+        << packed.CompressedBytes() / (1 << 20) << " MB ("sv << static_cast<double>(packed.CompressedBytes()) / SIZE
+        << " bytes/value), encode "sv << encode.first << " us"sv << endl
+        << "  "sv << LOOKUPS << " LowerBound x "sv << REPEATS << ": Vector "sv << plain_lookup.first << " us"sv << ", SortedIntVector "sv
+        << packed_lookup.first << " us"sv << endl
+        << "  full scan x "sv << REPEATS << ": Vector "sv << plain_scan.first << " us"sv << ", SortedIntVector "sv << packed_scan.first << " us"sv << endl;
+}
+
+/*
+*   Поток из 2^24 малых чисел (в основном меньше 128): запись побайтовым PushBack против
+*   AppendVarints, декодирование по одному значению против DecodeVarints и ядер каждого уровня.
+*/
+void BenchmarkVarint() {
+    using namespace std;
+    const size_t SIZE = size_t{ 1 } << 24;
+    const size_t REPEATS = 5;
+
+    Vector<uint32_t> values;
+    values.Reserve(SIZE);
+    uint64_t seed = 42;
+    for (size_t i = 0; i < SIZE; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        // Каждое восьмое значение занимает два-три байта
+        values.PushBack(static_cast<uint32_t>(seed >> 57) + ((seed >> 33) % 8 == 0 ? static_cast<uint32_t>(seed >> 50) : 0));
+    }
+
+    const auto push_back = MeasureRepeats(REPEATS, [&values] {
+        ByteVector bytes;
+        for (uint32_t value : values) {
+            for (; value >= 0x80; value >>= 7) {
+                bytes.PushBack(static_cast<uint8_t>(value | 0x80));
+            }
+            bytes.PushBack(static_cast<uint8_t>(value));
+        }
+        return bytes.Size();
+    });
+    ByteVector encoded;
+    const auto append = MeasureRepeats(REPEATS, [&values, &encoded] {
+        ByteVector bytes;
+        AppendVarints(bytes, values.begin(), values.Size());
+        encoded.Swap(bytes);
+        return encoded.Size();
+    });
+    assert(push_back.second == append.second);
+
+    const auto one_by_one = MeasureRepeats(REPEATS, [&encoded] {
+        Vector<uint32_t> out;
+        size_t pos = 0;
+        uint32_t value = 0;
+        while (DecodeVarint(encoded.begin(), encoded.Size(), pos, value)) {
+            out.PushBack(value);
+        }
+        return out.Size();
+    });
+    const auto bulk = MeasureRepeats(REPEATS, [&encoded] {
+        Vector<uint32_t> out;
+        DecodeVarints(encoded, out);
+        return out.Size();
+    });
+    assert(one_by_one.second == SIZE * REPEATS && bulk.second == SIZE * REPEATS);
+    cerr << "Varint stream of "sv << SIZE << " values ("sv << encoded.Size() / (1 << 20) << " MB) x "sv << REPEATS << endl
+        << "  encode: PushBack per byte "sv << push_back.first << " us"sv << ", AppendVarints "sv << append.first << " us"sv << endl
+        << "  decode: DecodeVarint + PushBack "sv << one_by_one.first << " us"sv << ", DecodeVarints "sv << bulk.first << " us"sv << endl;
+
+    Vector<uint32_t> out(SIZE);
+    VarintKernels::Dispatch().ForEachLevel([&](IsaLevel level, const VarintKernels::Table& kernels) {
+        const auto decode = MeasureRepeats(REPEATS, [&] {
+            return kernels.decode32(encoded.begin(), encoded.Size(), out.begin());
+        });
+        assert(decode.second == SIZE * REPEATS && std::equal(out.begin(), out.end(), values.begin()));
+        cerr << "  "sv << IsaName(level) << ": decode "sv << decode.first << " us"sv << endl;
+    });
+}
+
+/*
+*   Сериализация 2^22 записей из полей uint32_t, uint16_t и uint64_t: побайтовый PushBack
+*   в Vector<uint8_t> против ByteBuffer::Append<T> и записи всей записи в WritableSpan.
+*/
+void BenchmarkByteBuffer() {
+    using namespace std;
+    const size_t RECORDS = size_t{ 1 } << 22;
+    const size_t REPEATS = 5;
+    const size_t RECORD_BYTES = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint64_t);
+
+    auto push_bytes = [](Vector<uint8_t>& bytes, uint64_t value, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            bytes.PushBack(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    };
+    const auto push_back = MeasureRepeats(REPEATS, [&push_bytes, RECORDS] {
+        Vector<uint8_t> bytes;
+        for (size_t i = 0; i < RECORDS; ++i) {
+            push_bytes(bytes, i, sizeof(uint32_t));
+            push_bytes(bytes, i & 0xFFFF, sizeof(uint16_t));
+            push_bytes(bytes, i * 2654435761u, sizeof(uint64_t));
+        }
+        return static_cast<size_t>(bytes[bytes.Size() - 1]) + bytes.Size();
+    });
+    const auto append = MeasureRepeats(REPEATS, [RECORDS] {
+        ByteBuffer buffer;
+        for (size_t i = 0; i < RECORDS; ++i) {
+            buffer.Append(static_cast<uint32_t>(i));
+            buffer.Append(static_cast<uint16_t>(i & 0xFFFF));
+            buffer.Append(static_cast<uint64_t>(i * 2654435761u));
+        }
+        return static_cast<size_t>(buffer.Bytes()[buffer.Size() - 1]) + buffer.Size();
+    });
+    const auto spans = MeasureRepeats(REPEATS, [RECORDS, RECORD_BYTES] {
+        ByteBuffer buffer;
+        for (size_t i = 0; i < RECORDS; ++i) {
+            std::byte* out = buffer.WritableSpan(RECORD_BYTES).Data();
+            const uint32_t id = static_cast<uint32_t>(i);
+            const uint16_t tag = static_cast<uint16_t>(i & 0xFFFF);
+            const uint64_t hash = i * 2654435761u;
+            std::memcpy(out, &id, sizeof(id));
+            std::memcpy(out + sizeof(id), &tag, sizeof(tag));
+            std::memcpy(out + sizeof(id) + sizeof(tag), &hash, sizeof(hash));
+            buffer.Commit(RECORD_BYTES);
+        }
+        return static_cast<size_t>(buffer.Bytes()[buffer.Size() - 1]) + buffer.Size();
+    });
+    assert(push_back.second == append.second && append.second == spans.second);
+    cerr << RECORDS << " records of "sv << RECORD_BYTES << " bytes x "sv << REPEATS << ": Vector<uint8_t>::PushBack "sv
+        << push_back.first << " us"sv << ", ByteBuffer::Append<T> "sv << append.first << " us"sv
+        << ", WritableSpan + Commit "sv << spans.first << " us"sv << endl;
+}
+
+/*
+*   Сообщение из 16 МБ кусками по 4 КБ с 16-байтовым заголовком, дописанным в начало после тела:
+*   один растущий Vector<char> против ChainedBuffer, который отдаёт блоки массивом iovec.
+*/
+void BenchmarkChainedBuffer() {
+    using namespace std;
+    const size_t MESSAGE = size_t{ 16 } << 20;
+    const size_t PIECE = size_t{ 4 } << 10;
+    const size_t HEADER = 16;
+    const size_t REPEATS = 10;
+
+    vector<char> piece(PIECE);
+    for (size_t i = 0; i < PIECE; ++i) {
+        piece[i] = static_cast<char>(i * 31);
+    }
+    char header[HEADER] = { 'H', 'D', 'R' };
+    const auto contiguous = MeasureRepeats(REPEATS, [&] {
+        Vector<char> message;
+        for (size_t written = 0; written < MESSAGE; written += PIECE) {
+            // Удвоение вместимости, как у роста при PushBack, с переносом всего записанного
+            if (message.Capacity() - message.Size() < PIECE) {
+                message.Reserve(std::max(message.Size() + PIECE, message.Capacity() * 2));
+            }
+            std::memcpy(message.SpareBegin(), piece.data(), PIECE);
+            message.CommitSpare(PIECE);
+        }
+        // Заголовок в начало сдвигает всё тело
+        message.Reserve(message.Size() + HEADER);
+        std::memmove(message.begin() + HEADER, message.begin(), message.Size());
+        std::memcpy(message.begin(), header, HEADER);
+        message.CommitSpare(HEADER);
+        return message.Size() + static_cast<size_t>(message[message.Size() - 1]);
+    });
+    size_t iovecs = 0;
+    const auto chained = MeasureRepeats(REPEATS, [&] {
+        ChainedBuffer message;
+        for (size_t written = 0; written < MESSAGE; written += PIECE) {
+            message.Append(piece.data(), PIECE);
+        }
+        message.Prepend(header, HEADER);
+        const Vector<iovec> parts = message.IoVecs();
+        iovecs = parts.Size();
+        const iovec& last = parts[parts.Size() - 1];
+        return message.Size() + static_cast<size_t>(static_cast<const char*>(last.iov_base)[last.iov_len - 1]);
+    });
+    assert(contiguous.second == chained.second);
+    cerr << "Message of "sv << (MESSAGE >> 20) << " MB in "sv << PIECE << "-byte pieces + header x "sv << REPEATS
+        << ": Vector<char> "sv << contiguous.first << " us"sv << ", ChainedBuffer "sv << chained.first << " us ("sv
+        << iovecs << " iovecs)"sv << endl;
+}
+
+// Тесты и исходный Benchmark запускаются всегда, остальные замеры производительности — только с флагом --benchmark
+int main(int argc, char* argv[]) {
+    const bool run_benchmarks = argc > 1 && std::strcmp(argv[1], "--benchmark") == 0;
     try {
         Test1();
         Test2();
@@ -656,7 +3861,50 @@ int main() {
         Test4();
         Test5();
         Test6();
+        Test7();
+        Test8();
+        Test9();
+        Test10();
+        Test11();
+        Test12();
+        Test13();
+        Test14();
+        Test15();
+        Test16();
+        Test17();
+        Test18();
+        Test19();
+        Test20();
+        Test21();
+        Test22();
+        Test23();
+        Test24();
+        Test25();
+        Test26();
+        Test27();
+        Test28();
+        Test29();
+        Test30();
+        Test31();
         Benchmark();
+        if (run_benchmarks) {
+            BenchmarkConcurrentPushBack();
+            BenchmarkFalseSharing();
+            BenchmarkSearch();
+            BenchmarkReduce();
+            BenchmarkFill();
+            BenchmarkRelocation();
+            BenchmarkSoA();
+            BenchmarkConvert();
+            BenchmarkBits();
+            BenchmarkPacked();
+            BenchmarkDict();
+            BenchmarkRle();
+            BenchmarkSortedInts();
+            BenchmarkVarint();
+            BenchmarkByteBuffer();
+            BenchmarkChainedBuffer();
+        }
     }
     catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
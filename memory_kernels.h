@@ -0,0 +1,396 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+#include "cpu_features.h"
+#include "isa_dispatch.h"
+
+/*
+*   Ядра заполнения и копирования памяти, на которых Vector строит конструктор Vector(n, value),
+*   Assign и перенос элементов при перевыделении.
+*
+*   Значение тривиально копируемого типа размером 1, 2, 4 или 8 байт раскладывается
+*   в 8-байтовый шаблон (FillPatternOf), и память заполняется его повторением векторными записями.
+*   Остальные типы заполняются за один проход копирующим конструктором.
+*
+*   Перезапись уже использованной памяти объёмом больше NonTemporalThreshold() идёт потоковыми
+*   (non-temporal) записями: они не читают строки кэша перед записью и не вытесняют из кэша
+*   рабочие данные, а такой объём всё равно не поместился бы в кэш последнего уровня.
+*   Свежевыделенную память потоковыми записями не заполняем: ядро ОС обнуляет страницу
+*   при первом обращении, и её строки уже лежат в кэше, так что обычная запись дешевле.
+*
+*   Потоковое копирование (StreamCopy) пишет так же мимо кэша, а источник читает с подсказкой
+*   NTA, чтобы и прочитанные строки не вытесняли рабочий набор из кэша последнего уровня.
+*   Его выбирает политика RelocationPolicy::Streaming при переносе больших буферов Vector.
+*/
+
+//  Порог потоковой записи, если процессор не сообщает размер кэша последнего уровня
+inline constexpr size_t DEFAULT_NON_TEMPORAL_THRESHOLD = size_t{ 8 } << 20;
+
+//  Объём в байтах, начиная с которого перезапись памяти идёт потоковыми записями: 3/4 кэша последнего уровня
+inline size_t NonTemporalThreshold() noexcept {
+    const size_t cache = LastLevelCacheSize();
+    return cache == 0 ? DEFAULT_NON_TEMPORAL_THRESHOLD : cache / 4 * 3;
+}
+
+//  Состоит ли шаблон из одинаковых байтов (ноль, 0xFF), которые заполняет memset
+inline bool IsBytePattern(uint64_t pattern) noexcept {
+    return pattern == (pattern & 0xFF) * 0x0101010101010101ULL;
+}
+
+/*
+*   Скалярные ядра. Шаблон записывается в память побайтово в том порядке, в котором лежит в памяти,
+*   поэтому заполнение с любой позиции, кратной 8 байтам от начала, продолжает его без сдвига.
+*/
+struct ScalarMemory {
+    static void Fill(void* dst, uint64_t pattern, size_t bytes) noexcept {
+        if (bytes == 0) {
+            return;
+        }
+        char* out = static_cast<char*>(dst);
+        if (IsBytePattern(pattern)) {
+            std::memset(out, static_cast<int>(pattern & 0xFF), bytes);
+            return;
+        }
+        size_t i = 0;
+        for (; i + sizeof(pattern) <= bytes; i += sizeof(pattern)) {
+            std::memcpy(out + i, &pattern, sizeof(pattern));
+        }
+        std::memcpy(out + i, &pattern, bytes - i);
+    }
+
+    // Без векторных регистров потоковых записей нет, заполнение и копирование идут обычным способом
+    static void StreamFill(void* dst, uint64_t pattern, size_t bytes) noexcept {
+        Fill(dst, pattern, bytes);
+    }
+
+    static void StreamCopy(void* dst, const void* src, size_t bytes) noexcept {
+        if (bytes != 0) {
+            std::memcpy(dst, src, bytes);
+        }
+    }
+};
+
+#if FV_X86
+
+/*
+*   Векторные операции одного уровня: Broadcast размножает шаблон на весь регистр,
+*   Load и Store читают и пишут регистр по произвольному адресу, Stream — потоковой записью по адресу,
+*   выровненному на WIDTH, Fence упорядочивает потоковые записи с последующими обычными.
+*/
+struct Sse42MemoryLanes {
+    using Register = __m128i;
+    static constexpr size_t WIDTH = 16;
+
+    FV_TARGET("sse4.2") static Register Broadcast(uint64_t pattern) noexcept {
+        return _mm_set1_epi64x(static_cast<long long>(pattern));
+    }
+
+    FV_TARGET("sse4.2") static Register Load(const char* src) noexcept {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    }
+
+    FV_TARGET("sse4.2") static void Store(char* dst, Register value) noexcept {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+    }
+
+    FV_TARGET("sse4.2") static void Stream(char* dst, Register value) noexcept {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst), value);
+    }
+
+    FV_TARGET("sse4.2") static void Fence() noexcept {
+        _mm_sfence();
+    }
+};
+
+struct Avx2MemoryLanes {
+    using Register = __m256i;
+    static constexpr size_t WIDTH = 32;
+
+    FV_TARGET("avx2") static Register Broadcast(uint64_t pattern) noexcept {
+        return _mm256_set1_epi64x(static_cast<long long>(pattern));
+    }
+
+    FV_TARGET("avx2") static Register Load(const char* src) noexcept {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    }
+
+    FV_TARGET("avx2") static void Store(char* dst, Register value) noexcept {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), value);
+    }
+
+    FV_TARGET("avx2") static void Stream(char* dst, Register value) noexcept {
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst), value);
+    }
+
+    FV_TARGET("avx2") static void Fence() noexcept {
+        _mm_sfence();
+    }
+};
+
+struct Avx512MemoryLanes {
+    using Register = __m512i;
+    static constexpr size_t WIDTH = 64;
+
+    FV_TARGET(FV_AVX512) static Register Broadcast(uint64_t pattern) noexcept {
+        return _mm512_set1_epi64(static_cast<long long>(pattern));
+    }
+
+    FV_TARGET(FV_AVX512) static Register Load(const char* src) noexcept {
+        return _mm512_loadu_si512(src);
+    }
+
+    FV_TARGET(FV_AVX512) static void Store(char* dst, Register value) noexcept {
+        _mm512_storeu_si512(dst, value);
+    }
+
+    FV_TARGET(FV_AVX512) static void Stream(char* dst, Register value) noexcept {
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(dst), value);
+    }
+
+    FV_TARGET(FV_AVX512) static void Fence() noexcept {
+        _mm_sfence();
+    }
+};
+
+/*
+*   ОБОБЩЁННЫЕ ЯДРА. Как и ядра поиска и свёрток, встраиваются в обёртки с FV_TARGET,
+*   поэтому предупреждение GCC о смене ABI для регистров здесь отключено.
+*/
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+template <typename Lanes>
+FV_FORCE_INLINE void FillKernel(char* dst, uint64_t pattern, size_t bytes) noexcept {
+    constexpr size_t WIDTH = Lanes::WIDTH;
+    // Одинаковые байты быстрее пишет memset: на больших объёмах он не читает строки перед записью
+    if (IsBytePattern(pattern)) {
+        ScalarMemory::Fill(dst, pattern, bytes);
+        return;
+    }
+    const auto value = Lanes::Broadcast(pattern);
+    size_t i = 0;
+    for (; i + 4 * WIDTH <= bytes; i += 4 * WIDTH) {
+        Lanes::Store(dst + i, value);
+        Lanes::Store(dst + i + WIDTH, value);
+        Lanes::Store(dst + i + 2 * WIDTH, value);
+        Lanes::Store(dst + i + 3 * WIDTH, value);
+    }
+    for (; i + WIDTH <= bytes; i += WIDTH) {
+        Lanes::Store(dst + i, value);
+    }
+    // i кратно 8, поэтому хвост продолжает шаблон без сдвига
+    ScalarMemory::Fill(dst + i, pattern, bytes - i);
+}
+
+/*
+*   Потоковым записям нужен адрес, выровненный на ширину регистра. Начало до выравнивания
+*   заполняется обычными записями, а шаблон для остальной части сдвигается на длину этого начала:
+*   элемент может быть выровнен меньше своего размера, и выровненная часть начнётся посреди шаблона.
+*/
+template <typename Lanes>
+FV_FORCE_INLINE void StreamFillKernel(char* dst, uint64_t pattern, size_t bytes) noexcept {
+    constexpr size_t WIDTH = Lanes::WIDTH;
+    const size_t head = (WIDTH - reinterpret_cast<uintptr_t>(dst) % WIDTH) % WIDTH;
+    if (bytes < head + 4 * WIDTH) {
+        FillKernel<Lanes>(dst, pattern, bytes);
+        return;
+    }
+    ScalarMemory::Fill(dst, pattern, head);
+
+    const unsigned shift = static_cast<unsigned>(head % sizeof(pattern)) * 8;
+    const uint64_t body_pattern = shift == 0 ? pattern : (pattern >> shift) | (pattern << (64 - shift));
+    const auto value = Lanes::Broadcast(body_pattern);
+    char* body = dst + head;
+    const size_t body_bytes = bytes - head;
+    size_t i = 0;
+    for (; i + 4 * WIDTH <= body_bytes; i += 4 * WIDTH) {
+        Lanes::Stream(body + i, value);
+        Lanes::Stream(body + i + WIDTH, value);
+        Lanes::Stream(body + i + 2 * WIDTH, value);
+        Lanes::Stream(body + i + 3 * WIDTH, value);
+    }
+    for (; i + WIDTH <= body_bytes; i += WIDTH) {
+        Lanes::Stream(body + i, value);
+    }
+    Lanes::Fence();
+    ScalarMemory::Fill(body + i, body_pattern, body_bytes - i);
+}
+
+/*
+*   Потоковое копирование: выровненные потоковые записи и чтение источника с опережающей
+*   подсказкой NTA на PREFETCH_DISTANCE байт вперёд. Предвыборка за концом источника безопасна:
+*   она не вызывает исключений доступа к памяти.
+*/
+inline constexpr size_t PREFETCH_DISTANCE = 512;
+
+template <typename Lanes>
+FV_FORCE_INLINE void StreamCopyKernel(char* dst, const char* src, size_t bytes) noexcept {
+    constexpr size_t WIDTH = Lanes::WIDTH;
+    constexpr size_t LINE = 64;
+    const size_t head = (WIDTH - reinterpret_cast<uintptr_t>(dst) % WIDTH) % WIDTH;
+    if (bytes < head + 4 * WIDTH) {
+        ScalarMemory::StreamCopy(dst, src, bytes);
+        return;
+    }
+    std::memcpy(dst, src, head);
+    size_t i = head;
+    for (; i + 4 * WIDTH <= bytes; i += 4 * WIDTH) {
+        for (size_t line = 0; line < 4 * WIDTH; line += LINE) {
+            _mm_prefetch(src + i + PREFETCH_DISTANCE + line, _MM_HINT_NTA);
+        }
+        const auto v0 = Lanes::Load(src + i);
+        const auto v1 = Lanes::Load(src + i + WIDTH);
+        const auto v2 = Lanes::Load(src + i + 2 * WIDTH);
+        const auto v3 = Lanes::Load(src + i + 3 * WIDTH);
+        Lanes::Stream(dst + i, v0);
+        Lanes::Stream(dst + i + WIDTH, v1);
+        Lanes::Stream(dst + i + 2 * WIDTH, v2);
+        Lanes::Stream(dst + i + 3 * WIDTH, v3);
+    }
+    for (; i + WIDTH <= bytes; i += WIDTH) {
+        Lanes::Stream(dst + i, Lanes::Load(src + i));
+    }
+    Lanes::Fence();
+    std::memcpy(dst + i, src + i, bytes - i);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+struct Sse42Memory {
+    FV_TARGET("sse4.2") static void Fill(void* dst, uint64_t pattern, size_t bytes) noexcept {
+        FillKernel<Sse42MemoryLanes>(static_cast<char*>(dst), pattern, bytes);
+    }
+
+    FV_TARGET("sse4.2") static void StreamFill(void* dst, uint64_t pattern, size_t bytes) noexcept {
+        StreamFillKernel<Sse42MemoryLanes>(static_cast<char*>(dst), pattern, bytes);
+    }
+
+    FV_TARGET("sse4.2") static void StreamCopy(void* dst, const void* src, size_t bytes) noexcept {
+        StreamCopyKernel<Sse42MemoryLanes>(static_cast<char*>(dst), static_cast<const char*>(src), bytes);
+    }
+};
+
+struct Avx2Memory {
+    FV_TARGET("avx2") static void Fill(void* dst, uint64_t pattern, size_t bytes) noexcept {
+        FillKernel<Avx2MemoryLanes>(static_cast<char*>(dst), pattern, bytes);
+    }
+
+    FV_TARGET("avx2") static void StreamFill(void* dst, uint64_t pattern, size_t bytes) noexcept {
+        StreamFillKernel<Avx2MemoryLanes>(static_cast<char*>(dst), pattern, bytes);
+    }
+
+    FV_TARGET("avx2") static void StreamCopy(void* dst, const void* src, size_t bytes) noexcept {
+        StreamCopyKernel<Avx2MemoryLanes>(static_cast<char*>(dst), static_cast<const char*>(src), bytes);
+    }
+};
+
+struct Avx512Memory {
+    FV_TARGET(FV_AVX512) static void Fill(void* dst, uint64_t pattern, size_t bytes) noexcept {
+        FillKernel<Avx512MemoryLanes>(static_cast<char*>(dst), pattern, bytes);
+    }
+
+    FV_TARGET(FV_AVX512) static void StreamFill(void* dst, uint64_t pattern, size_t bytes) noexcept {
+        StreamFillKernel<Avx512MemoryLanes>(static_cast<char*>(dst), pattern, bytes);
+    }
+
+    FV_TARGET(FV_AVX512) static void StreamCopy(void* dst, const void* src, size_t bytes) noexcept {
+        StreamCopyKernel<Avx512MemoryLanes>(static_cast<char*>(dst), static_cast<const char*>(src), bytes);
+    }
+};
+
+#endif
+
+//  Таблица ядер заполнения и копирования, устроенная так же, как SearchKernels и ReduceKernels
+class MemoryKernels {
+public:
+    using FillFn = void (*)(void*, uint64_t, size_t);
+    using CopyFn = void (*)(void*, const void*, size_t);
+
+    struct Table {
+        FillFn fill;
+        FillFn stream_fill;
+        CopyFn stream_copy;
+    };
+
+    static const IsaDispatch<Table>& Dispatch() noexcept {
+        static constexpr Table SCALAR{ &ScalarMemory::Fill, &ScalarMemory::StreamFill, &ScalarMemory::StreamCopy };
+#if FV_X86
+        static constexpr Table SSE42{ &Sse42Memory::Fill, &Sse42Memory::StreamFill, &Sse42Memory::StreamCopy };
+        static constexpr Table AVX2{ &Avx2Memory::Fill, &Avx2Memory::StreamFill, &Avx2Memory::StreamCopy };
+        static constexpr Table AVX512{ &Avx512Memory::Fill, &Avx512Memory::StreamFill, &Avx512Memory::StreamCopy };
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR, &SSE42, &AVX2, &AVX512);
+#else
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR);
+#endif
+        return DISPATCH;
+    }
+
+    static const Table& Active() noexcept {
+        static const Table& table = Dispatch().Active();
+        return table;
+    }
+
+    static const Table& ForLevel(IsaLevel level) noexcept {
+        return Dispatch().ForLevel(level);
+    }
+};
+
+//  Типы, которые заполняются повторением байтового шаблона
+template <typename T>
+inline constexpr bool IS_PATTERN_FILLABLE = std::is_trivially_copyable_v<T>
+    && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+//  8-байтовый шаблон из байтов value, повторённых до заполнения
+template <typename T>
+uint64_t FillPatternOf(const T& value) noexcept {
+    static_assert(IS_PATTERN_FILLABLE<T>, "FillPatternOf requires a trivially copyable type of 1, 2, 4 or 8 bytes");
+    uint64_t pattern = 0;
+    for (size_t offset = 0; offset < sizeof(pattern); offset += sizeof(T)) {
+        std::memcpy(reinterpret_cast<char*>(&pattern) + offset, &value, sizeof(T));
+    }
+    return pattern;
+}
+
+/*
+*   Конструирует count копий value в свежевыделенной сырой памяти по адресу dst.
+*   Шаблон вычисляется до первой записи, поэтому value может лежать в заполняемой памяти.
+*/
+template <typename T>
+void UninitializedFill(T* dst, size_t count, const T& value) {
+    if constexpr (IS_PATTERN_FILLABLE<T>) {
+        MemoryKernels::Active().fill(dst, FillPatternOf(value), count * sizeof(T));
+    }
+    else {
+        std::uninitialized_fill_n(dst, count, value);
+    }
+}
+
+/*
+*   Перезаписывает count элементов по адресу dst копиями value. Память уже использовалась,
+*   поэтому большие объёмы записываются потоковыми записями мимо кэша.
+*/
+template <typename T>
+void OverwriteFill(T* dst, size_t count, const T& value) noexcept {
+    static_assert(IS_PATTERN_FILLABLE<T>, "OverwriteFill requires a trivially copyable type of 1, 2, 4 or 8 bytes");
+    const size_t bytes = count * sizeof(T);
+    if (bytes >= NonTemporalThreshold()) {
+        MemoryKernels::Active().stream_fill(dst, FillPatternOf(value), bytes);
+    }
+    else {
+        MemoryKernels::Active().fill(dst, FillPatternOf(value), bytes);
+    }
+}
+
+//  Копирует bytes байт из src в dst потоковыми записями мимо кэша. Области не должны пересекаться
+inline void StreamCopy(void* dst, const void* src, size_t bytes) noexcept {
+    MemoryKernels::Active().stream_copy(dst, src, bytes);
+}
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "cpu_features.h"
+#include "isa_dispatch.h"
+#include "span.h"
+#include "vector.h"
+
+/*
+*   Вектор целых без знака фиксированной ширины от 1 до 32 бит, упакованных подряд в слова uint64_t.
+*   Значение i занимает биты [i * Bits, (i + 1) * Bits) и может переходить через границу слова.
+*
+*   За последним занятым словом всегда есть ещё одно слово, а все биты за пределами размера равны нулю.
+*   Поэтому Get читает два соседних слова без ветвления, PushBack только добавляет биты,
+*   а векторные ядра распаковки могут читать несколько байт за концом значений.
+*
+*   PackedIntVector<Bits> знает ширину при компиляции, PackedIntVector<RUNTIME_BIT_WIDTH>
+*   (RuntimePackedIntVector) получает её в конструкторе, например, из BitsFor(максимальное значение).
+*/
+
+inline constexpr unsigned RUNTIME_BIT_WIDTH = 0;
+inline constexpr unsigned MAX_PACKED_BIT_WIDTH = 32;
+
+//  Наименьшая ширина в битах, в которой помещается max_value (не меньше одного бита)
+constexpr unsigned BitsFor(uint32_t max_value) noexcept {
+    unsigned bits = 1;
+    while (bits < MAX_PACKED_BIT_WIDTH && (max_value >> bits) != 0) {
+        ++bits;
+    }
+    return bits;
+}
+
+//  Значение ширины bits, начинающееся с бита bit массива words. За словом значения должно быть ещё одно
+inline uint32_t ReadPacked(const uint64_t* words, uint64_t bit, unsigned bits) noexcept {
+    const size_t word = static_cast<size_t>(bit / 64);
+    const unsigned offset = static_cast<unsigned>(bit % 64);
+    // Сдвиг в два шага не даёт сдвига на 64, когда значение целиком лежит в первом слове
+    const uint64_t value = (words[word] >> offset) | ((words[word + 1] << 1) << (63 - offset));
+    return static_cast<uint32_t>(value & ((uint64_t{ 1 } << bits) - 1));
+}
+
+/* СКАЛЯРНОЕ ЯДРО. Распаковывает count значений, начиная со значения first, в out */
+
+struct ScalarPacked {
+    static void Unpack(const uint64_t* words, unsigned bits, size_t first, size_t count, uint32_t* out) noexcept {
+        uint64_t bit = uint64_t{ first } * bits;
+        for (size_t i = 0; i < count; ++i, bit += bits) {
+            out[i] = ReadPacked(words, bit, bits);
+        }
+    }
+};
+
+#if FV_X86
+
+/*
+*   Восемь подряд идущих значений ширины bits занимают ровно bits байт, поэтому внутри группы
+*   из восьми значений, начинающейся на границе байта, смещения (j * bits / 8 байт и j * bits % 8 бит)
+*   не зависят от группы. Ядра собирают 32-битные слова по этим смещениям (gather), сдвигают
+*   каждую дорожку на свой сдвиг и накладывают маску. Значение вместе со сдвигом должно помещаться
+*   в 32 бита, поэтому векторно распаковываются ширины до MAX_GATHER_UNPACK_BITS, остальные — скалярно.
+*/
+inline constexpr unsigned MAX_GATHER_UNPACK_BITS = 25;
+
+struct Avx2Packed {
+    FV_TARGET("avx2") static void Unpack(const uint64_t* words, unsigned bits, size_t first, size_t count, uint32_t* out) noexcept {
+        // Голова до начала группы из восьми значений
+        const size_t head = bits > MAX_GATHER_UNPACK_BITS ? count : std::min(count, (8 - first % 8) % 8);
+        ScalarPacked::Unpack(words, bits, first, head, out);
+        size_t i = head;
+        if (i + 8 <= count) {
+            const int b = static_cast<int>(bits);
+            const __m256i offsets = _mm256_setr_epi32(0, b / 8, 2 * b / 8, 3 * b / 8, 4 * b / 8, 5 * b / 8, 6 * b / 8, 7 * b / 8);
+            const __m256i shifts = _mm256_setr_epi32(0, b % 8, 2 * b % 8, 3 * b % 8, 4 * b % 8, 5 * b % 8, 6 * b % 8, 7 * b % 8);
+            const __m256i mask = _mm256_set1_epi32(static_cast<int>((uint64_t{ 1 } << bits) - 1));
+            const char* group = reinterpret_cast<const char*>(words) + (first + i) / 8 * bits;
+            for (; i + 8 <= count; i += 8, group += bits) {
+                const __m256i gathered = _mm256_i32gather_epi32(reinterpret_cast<const int*>(group), offsets, 1);
+                const __m256i values = _mm256_and_si256(_mm256_srlv_epi32(gathered, shifts), mask);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), values);
+            }
+        }
+        ScalarPacked::Unpack(words, bits, first + i, count - i, out + i);
+    }
+};
+
+struct Avx512Packed {
+    FV_TARGET(FV_AVX512) static void Unpack(const uint64_t* words, unsigned bits, size_t first, size_t count, uint32_t* out) noexcept {
+        const size_t head = bits > MAX_GATHER_UNPACK_BITS ? count : std::min(count, (8 - first % 8) % 8);
+        ScalarPacked::Unpack(words, bits, first, head, out);
+        size_t i = head;
+        if (i + 16 <= count) {
+            alignas(64) int32_t offset_lanes[16];
+            alignas(64) int32_t shift_lanes[16];
+            for (int j = 0; j < 16; ++j) {
+                offset_lanes[j] = j * static_cast<int>(bits) / 8;
+                shift_lanes[j] = j * static_cast<int>(bits) % 8;
+            }
+            const __m512i offsets = _mm512_load_si512(offset_lanes);
+            const __m512i shifts = _mm512_load_si512(shift_lanes);
+            const __m512i mask = _mm512_set1_epi32(static_cast<int>((uint64_t{ 1 } << bits) - 1));
+            const char* group = reinterpret_cast<const char*>(words) + (first + i) / 8 * bits;
+            for (; i + 16 <= count; i += 16, group += 2 * bits) {
+                const __m512i gathered = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, offsets, group, 1);
+                _mm512_storeu_si512(out + i, _mm512_and_si512(_mm512_maskz_srlv_epi32(0xFFFF, gathered, shifts), mask));
+            }
+        }
+        ScalarPacked::Unpack(words, bits, first + i, count - i, out + i);
+    }
+};
+
+#endif
+
+/*
+*   Таблица ядер распаковки. У SSE4.2 нет инструкций gather, поэтому этот уровень использует скалярное ядро.
+*/
+class PackedKernels {
+public:
+    using UnpackFn = void (*)(const uint64_t*, unsigned, size_t, size_t, uint32_t*);
+
+    struct Table {
+        UnpackFn unpack;
+    };
+
+    static const IsaDispatch<Table>& Dispatch() noexcept {
+        static constexpr Table SCALAR{ &ScalarPacked::Unpack };
+#if FV_X86
+        static constexpr Table AVX2{ &Avx2Packed::Unpack };
+        static constexpr Table AVX512{ &Avx512Packed::Unpack };
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR, nullptr, &AVX2, &AVX512);
+#else
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR);
+#endif
+        return DISPATCH;
+    }
+
+    static const Table& Active() noexcept {
+        static const Table& table = Dispatch().Active();
+        return table;
+    }
+
+    static const Table& ForLevel(IsaLevel level) noexcept {
+        return Dispatch().ForLevel(level);
+    }
+};
+
+template <unsigned Bits>
+class PackedIntVector {
+    static_assert(Bits <= MAX_PACKED_BIT_WIDTH, "PackedIntVector stores values of at most 32 bits");
+
+public:
+    PackedIntVector() noexcept {
+        static_assert(Bits != RUNTIME_BIT_WIDTH, "RuntimePackedIntVector needs a bit width");
+    }
+
+    //  Пустой вектор ширины bits. Только для RuntimePackedIntVector
+    explicit PackedIntVector(unsigned bits) noexcept
+        : bits_(bits) {
+        static_assert(Bits == RUNTIME_BIT_WIDTH, "the bit width of PackedIntVector<Bits> is fixed");
+        assert(bits >= 1 && bits <= MAX_PACKED_BIT_WIDTH);
+    }
+
+    PackedIntVector(const PackedIntVector& other)
+        : words_(other.words_.Capacity() == 0 ? 0 : other.UsedWords() + 1)
+        , size_(other.size_)
+        , bits_(other.bits_) {
+        if (words_.Capacity() != 0) {
+            std::memcpy(words_.GetAddress(), other.words_.GetAddress(), words_.Capacity() * sizeof(uint64_t));
+        }
+    }
+
+    PackedIntVector(PackedIntVector&& other) noexcept
+        : bits_(other.bits_) {
+        Swap(other);
+    }
+
+    PackedIntVector& operator=(const PackedIntVector& rhs) {
+        if (this != &rhs) {
+            PackedIntVector copy(rhs);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    PackedIntVector& operator=(PackedIntVector&& rhs) noexcept {
+        Swap(rhs);
+        return *this;
+    }
+
+    void Swap(PackedIntVector& other) noexcept {
+        words_.Swap(other.words_);
+        std::swap(size_, other.size_);
+        std::swap(bits_, other.bits_);
+    }
+
+    unsigned BitWidth() const noexcept {
+        if constexpr (Bits != RUNTIME_BIT_WIDTH) {
+            return Bits;
+        }
+        else {
+            return bits_;
+        }
+    }
+
+    uint32_t MaxValue() const noexcept {
+        return static_cast<uint32_t>(Mask());
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
+
+    size_t Capacity() const noexcept {
+        return words_.Capacity() == 0 ? 0 : (words_.Capacity() - 1) * 64 / BitWidth();
+    }
+
+    //  Слова вектора, включая слово за последним занятым
+    Span<const uint64_t> Words() const noexcept {
+        return Span<const uint64_t>(words_.GetAddress(), words_.Capacity() == 0 ? 0 : UsedWords() + 1);
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity > Capacity()) {
+            Reallocate(new_capacity);
+        }
+    }
+
+    void ShrinkToFit() {
+        if (size_ < Capacity()) {
+            Reallocate(size_);
+        }
+    }
+
+    void Clear() noexcept {
+        ClearBits(0);
+        size_ = 0;
+    }
+
+    //  Новые значения равны value
+    void Resize(size_t new_size, uint32_t value = 0) {
+        if (new_size <= size_) {
+            ClearBits(new_size);
+            size_ = new_size;
+            return;
+        }
+        Reserve(new_size);
+        if (value == 0) {
+            size_ = new_size;
+            return;
+        }
+        while (size_ < new_size) {
+            AppendBits(value);
+        }
+    }
+
+    uint32_t Get(size_t index) const noexcept {
+        assert(index < size_);
+        return ReadPacked(words_.GetAddress(), uint64_t{ index } * BitWidth(), BitWidth());
+    }
+
+    uint32_t operator[](size_t index) const noexcept {
+        return Get(index);
+    }
+
+    void Set(size_t index, uint32_t value) noexcept {
+        assert(index < size_ && value <= MaxValue());
+        const uint64_t bit = uint64_t{ index } * BitWidth();
+        const size_t word = static_cast<size_t>(bit / 64);
+        const unsigned offset = static_cast<unsigned>(bit % 64);
+        words_[word] = (words_[word] & ~(Mask() << offset)) | (uint64_t{ value } << offset);
+        words_[word + 1] = (words_[word + 1] & ~((Mask() >> 1) >> (63 - offset))) | ((uint64_t{ value } >> 1) >> (63 - offset));
+    }
+
+    void PushBack(uint32_t value) {
+        if (size_ == Capacity()) {
+            Reallocate(size_ == 0 ? 64 / BitWidth() : size_ * 2);
+        }
+        AppendBits(value);
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        ClearBits(size_ - 1);
+        --size_;
+    }
+
+    //  Добавляет count значений из values
+    void Append(const uint32_t* values, size_t count) {
+        Reserve(size_ + count);
+        for (size_t i = 0; i < count; ++i) {
+            AppendBits(values[i]);
+        }
+    }
+
+    //  Распаковывает count значений, начиная с first, в out векторным ядром
+    void Unpack(size_t first, size_t count, uint32_t* out) const noexcept {
+        assert(first <= size_ && count <= size_ - first);
+        if (count != 0) {
+            PackedKernels::Active().unpack(words_.GetAddress(), BitWidth(), first, count, out);
+        }
+    }
+
+    //  Распаковывает все значения в Vector<uint32_t>
+    Vector<uint32_t> Unpack() const {
+        Vector<uint32_t> values;
+        values.Reserve(size_);
+        Unpack(0, size_, values.SpareBegin());
+        values.CommitSpare(size_);
+        return values;
+    }
+
+private:
+    RawMemory<uint64_t, CACHE_LINE_SIZE> words_;
+    size_t size_ = 0;
+    unsigned bits_ = Bits;
+
+    uint64_t Mask() const noexcept {
+        return (uint64_t{ 1 } << BitWidth()) - 1;
+    }
+
+    size_t UsedWords() const noexcept {
+        return static_cast<size_t>((uint64_t{ size_ } * BitWidth() + 63) / 64);
+    }
+
+    //  Вместимость должна быть больше размера: биты за пределами размера нулевые, поэтому значение только добавляется
+    void AppendBits(uint32_t value) noexcept {
+        assert(size_ < Capacity() && value <= MaxValue());
+        const uint64_t bit = uint64_t{ size_ } * BitWidth();
+        const size_t word = static_cast<size_t>(bit / 64);
+        const unsigned offset = static_cast<unsigned>(bit % 64);
+        words_[word] |= uint64_t{ value } << offset;
+        words_[word + 1] |= (uint64_t{ value } >> 1) >> (63 - offset);
+        ++size_;
+    }
+
+    //  Обнуляет биты значений, начиная со значения first, до конца занятых слов
+    void ClearBits(size_t first) noexcept {
+        if (words_.Capacity() == 0) {
+            return;
+        }
+        const uint64_t bit = uint64_t{ first } * BitWidth();
+        const size_t word = static_cast<size_t>(bit / 64);
+        const size_t used = UsedWords();
+        words_[word] &= (uint64_t{ 1 } << (bit % 64)) - 1;
+        if (word + 1 <= used) {
+            std::memset(words_ + word + 1, 0, (used - word) * sizeof(uint64_t));
+        }
+    }
+
+    void Reallocate(size_t value_capacity) {
+        if (value_capacity == 0) {
+            RawMemory<uint64_t, CACHE_LINE_SIZE> empty;
+            words_.Swap(empty);
+            return;
+        }
+        const size_t word_capacity = static_cast<size_t>((uint64_t{ value_capacity } * BitWidth() + 63) / 64) + 1;
+        RawMemory<uint64_t, CACHE_LINE_SIZE> new_words(word_capacity);
+        const size_t used = words_.Capacity() == 0 ? 0 : UsedWords();
+        if (used != 0) {
+            std::memcpy(new_words.GetAddress(), words_.GetAddress(), used * sizeof(uint64_t));
+        }
+        std::memset(new_words + used, 0, (word_capacity - used) * sizeof(uint64_t));
+        words_.Swap(new_words);
+    }
+};
+
+using RuntimePackedIntVector = PackedIntVector<RUNTIME_BIT_WIDTH>;
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <utility>
+
+#include "vector.h"
+
+/*
+*   Вектор, каждый элемент которого занимает отдельную строку кэша.
+*
+*   Предназначен для слотов, в которые пишут разные потоки (счётчики, аккумуляторы):
+*   в обычном Vector соседние элементы делят строку кэша, и запись одного потока
+*   вытесняет строку из кэшей остальных (false sharing).
+*
+*   Элементы хранятся в Vector обёрток, выровненных по CACHE_LINE_SIZE. RawMemory выделяет
+*   для таких типов память выравнивающим operator new, поэтому выравнивание сохраняется
+*   и при перевыделении. Итераторы и operator[] возвращают сами элементы, без обёрток.
+*   Методы изменения повторяют методы Vector и передаются внутреннему вектору слотов.
+*/
+template <typename T>
+class PaddedVector {
+private:
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        Slot()
+            : value() {
+        }
+
+        template <typename... Args>
+        explicit Slot(std::in_place_t, Args&&... args)
+            : value(std::forward<Args>(args)...) {
+        }
+
+        T value;
+    };
+
+    template <typename Value, typename SlotPtr>
+    class BasicIterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        BasicIterator() = default;
+
+        //  Неконстантный итератор неявно преобразуется в константный
+        template <typename OtherValue, typename OtherSlotPtr>
+        BasicIterator(const BasicIterator<OtherValue, OtherSlotPtr>& other) noexcept
+            : slot_(other.slot_) {
+        }
+
+        reference operator*() const noexcept {
+            return slot_->value;
+        }
+
+        pointer operator->() const noexcept {
+            return &slot_->value;
+        }
+
+        reference operator[](difference_type offset) const noexcept {
+            return slot_[offset].value;
+        }
+
+        BasicIterator& operator++() noexcept {
+            ++slot_;
+            return *this;
+        }
+
+        BasicIterator operator++(int) noexcept {
+            BasicIterator tmp(*this);
+            ++slot_;
+            return tmp;
+        }
+
+        BasicIterator& operator--() noexcept {
+            --slot_;
+            return *this;
+        }
+
+        BasicIterator operator--(int) noexcept {
+            BasicIterator tmp(*this);
+            --slot_;
+            return tmp;
+        }
+
+        BasicIterator& operator+=(difference_type offset) noexcept {
+            slot_ += offset;
+            return *this;
+        }
+
+        BasicIterator& operator-=(difference_type offset) noexcept {
+            slot_ -= offset;
+            return *this;
+        }
+
+        friend BasicIterator operator+(BasicIterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+
+        friend BasicIterator operator+(difference_type offset, BasicIterator it) noexcept {
+            return it += offset;
+        }
+
+        friend BasicIterator operator-(BasicIterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+
+        friend difference_type operator-(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.slot_ - rhs.slot_;
+        }
+
+        friend bool operator==(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.slot_ == rhs.slot_;
+        }
+
+        friend bool operator!=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.slot_ != rhs.slot_;
+        }
+
+        friend bool operator<(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.slot_ < rhs.slot_;
+        }
+
+        friend bool operator>(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.slot_ > rhs.slot_;
+        }
+
+        friend bool operator<=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.slot_ <= rhs.slot_;
+        }
+
+        friend bool operator>=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.slot_ >= rhs.slot_;
+        }
+
+    private:
+        friend class PaddedVector;
+
+        template <typename, typename>
+        friend class BasicIterator;
+
+        explicit BasicIterator(SlotPtr slot) noexcept
+            : slot_(slot) {
+        }
+
+        SlotPtr slot_ = nullptr;
+    };
+
+public:
+    using iterator = BasicIterator<T, Slot*>;
+    using const_iterator = BasicIterator<const T, const Slot*>;
+
+    PaddedVector() = default;
+
+    //  Создаёт size слотов, инициализированных значением по умолчанию
+    explicit PaddedVector(size_t size)
+        : slots_(size) {
+    }
+
+    void Swap(PaddedVector& other) noexcept {
+        slots_.Swap(other.slots_);
+    }
+
+    size_t Size() const noexcept {
+        return slots_.Size();
+    }
+
+    size_t Capacity() const noexcept {
+        return slots_.Capacity();
+    }
+
+    void Reserve(size_t new_capacity) {
+        slots_.Reserve(new_capacity);
+    }
+
+    void Resize(size_t new_size) {
+        slots_.Resize(new_size);
+    }
+
+    void ShrinkToFit() {
+        slots_.ShrinkToFit();
+    }
+
+    void Clear() noexcept {
+        slots_.Clear();
+    }
+
+    //  Заменяет содержимое count копиями value
+    void Assign(size_t count, const T& value) {
+        slots_.Assign(count, Slot(std::in_place, value));
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return slots_[index].value;
+    }
+
+    T& operator[](size_t index) noexcept {
+        return slots_[index].value;
+    }
+
+    template <typename Type>
+    void PushBack(Type&& value) {
+        EmplaceBack(std::forward<Type>(value));
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        return slots_.EmplaceBack(std::in_place, std::forward<Args>(args)...).value;
+    }
+
+    void PopBack() noexcept {
+        slots_.PopBack();
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        return iterator(slots_.Emplace(pos.slot_, std::in_place, std::forward<Args>(args)...));
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    iterator Erase(const_iterator pos) {
+        return iterator(slots_.Erase(pos.slot_));
+    }
+
+    //  Удаляет элемент за O(1), перемещая на его место последний
+    iterator EraseUnordered(const_iterator pos) {
+        return iterator(slots_.EraseUnordered(pos.slot_));
+    }
+
+    //  Удаляет элементы по отсортированному диапазону уникальных индексов, не сохраняя порядок
+    template <typename RandomIt>
+    void EraseUnordered(RandomIt first, RandomIt last) {
+        slots_.EraseUnordered(first, last);
+    }
+
+    /*
+    *   Сворачивает значения всех слотов операцией op, начиная с init.
+    *   Вызывается после того, как потоки закончили писать в свои слоты.
+    */
+    template <typename Result, typename BinaryOp = std::plus<>>
+    Result Reduce(Result init, BinaryOp op = {}) const {
+        return std::accumulate(begin(), end(), std::move(init), op);
+    }
+
+    iterator begin() noexcept {
+        return iterator(slots_.begin());
+    }
+
+    iterator end() noexcept {
+        return iterator(slots_.end());
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(slots_.begin());
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(slots_.end());
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+private:
+    Vector<Slot> slots_;
+};
@@ -0,0 +1,901 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "vector.h"
+
+/*
+*   Персистентный (неизменяемый) вектор на основе RRB-дерева (relaxed radix balanced tree).
+*
+*   Элементы хранятся в листьях по 32 штуки, внутренние узлы имеют до 32 потомков.
+*   Все изменяющие операции (PushBack, Set, Take, Drop, Slice, Concat) не трогают исходный вектор,
+*   а возвращают новую версию, которая разделяет с исходной все неизменённые узлы.
+*   Копируется только путь от корня до изменённого листа, поэтому операции выполняются за O(log32 n).
+*
+*   Регулярный внутренний узел содержит полные поддеревья во всех потомках, кроме последнего,
+*   и индекс в нём вычисляется сдвигом. После конкатенации и отбрасывания префикса узлы
+*   становятся «расслабленными»: они хранят таблицу накопленных размеров потомков.
+*
+*   Узлы неизменяемы и имеют атомарный счётчик ссылок, поэтому читатели могут держать
+*   старые версии в других потоках, пока писатель создаёт новые.
+*
+*   Transient — изменяемый построитель. Узлы, созданные им, помечаются его токеном
+*   и изменяются на месте, а не копируются. Persistent() превращает построитель в вектор за O(1).
+*/
+template <typename T>
+class PersistentVector {
+private:
+    static constexpr size_t BITS = 5;
+    static constexpr size_t BRANCHING = size_t(1) << BITS;
+    // Параметры плана перераспределения при конкатенации (Bagwell, Rompf. RRB-Trees)
+    static constexpr size_t INVARIANT = 1;
+    static constexpr size_t EXTRAS = 2;
+
+    struct Node;
+    struct Leaf;
+    struct Inner;
+
+    // Умный указатель на узел с интрузивным счётчиком ссылок
+    class NodePtr {
+    public:
+        NodePtr() = default;
+
+        // Принимает во владение только что созданный узел
+        explicit NodePtr(Node* node) noexcept
+            : node_(node) {
+        }
+
+        NodePtr(const NodePtr& other) noexcept
+            : node_(other.node_) {
+            if (node_ != nullptr) {
+                node_->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        NodePtr(NodePtr&& other) noexcept
+            : node_(std::exchange(other.node_, nullptr)) {
+        }
+
+        NodePtr& operator=(const NodePtr& rhs) noexcept {
+            NodePtr tmp(rhs);
+            std::swap(node_, tmp.node_);
+            return *this;
+        }
+
+        NodePtr& operator=(NodePtr&& rhs) noexcept {
+            NodePtr tmp(std::move(rhs));
+            std::swap(node_, tmp.node_);
+            return *this;
+        }
+
+        ~NodePtr() {
+            if (node_ != nullptr && node_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (node_->leaf) {
+                    delete static_cast<Leaf*>(node_);
+                }
+                else {
+                    delete static_cast<Inner*>(node_);
+                }
+            }
+        }
+
+        Node* Get() const noexcept {
+            return node_;
+        }
+
+        Node* operator->() const noexcept {
+            return node_;
+        }
+
+        explicit operator bool() const noexcept {
+            return node_ != nullptr;
+        }
+
+    private:
+        Node* node_ = nullptr;
+    };
+
+    struct Node {
+        Node(bool is_leaf, uint64_t owner) noexcept
+            : owner(owner)
+            , leaf(is_leaf) {
+        }
+
+        std::atomic<size_t> refs{ 1 };
+        // Токен построителя, которому разрешено изменять узел на месте. 0 — узел неизменяем
+        uint64_t owner;
+        // Количество элементов в листе или потомков во внутреннем узле
+        size_t count = 0;
+        const bool leaf;
+    };
+
+    struct Leaf : Node {
+        explicit Leaf(uint64_t owner)
+            : Node(true, owner) {
+        }
+
+        ~Leaf() {
+            std::destroy_n(values.GetAddress(), this->count);
+        }
+
+        RawMemory<T> values{ BRANCHING };
+    };
+
+    struct Inner : Node {
+        explicit Inner(uint64_t owner)
+            : Node(false, owner) {
+        }
+
+        NodePtr children[BRANCHING];
+        // Накопленные размеры потомков. Пуста у регулярного узла
+        RawMemory<size_t> sizes;
+    };
+
+    // Один или два узла одной высоты — результат слияния поддеревьев при конкатенации
+    struct NodePair {
+        NodePtr nodes[2];
+        size_t count = 0;
+    };
+
+public:
+    class ConstIterator;
+    class Transient;
+
+    using const_iterator = ConstIterator;
+
+    PersistentVector() = default;
+
+    explicit PersistentVector(const Vector<T>& values) {
+        Transient builder;
+        for (const T& value : values) {
+            builder.PushBack(value);
+        }
+        *this = builder.Persistent();
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        size_t begin = 0;
+        size_t end = 0;
+        const T* leaf = FindLeaf(root_.Get(), height_, index, begin, end);
+        return leaf[index - begin];
+    }
+
+    //  Возвращает новую версию с элементом, добавленным в конец
+    template <typename Type>
+    [[nodiscard]] PersistentVector PushBack(Type&& value) const {
+        return EmplaceBack(std::forward<Type>(value));
+    }
+
+    template <typename... Args>
+    [[nodiscard]] PersistentVector EmplaceBack(Args&&... args) const {
+        PersistentVector result(*this);
+        EmplaceBackIn(result.root_, result.height_, result.size_, 0, std::forward<Args>(args)...);
+        return result;
+    }
+
+    //  Возвращает новую версию, в которой элемент с индексом index заменён на value
+    template <typename Type>
+    [[nodiscard]] PersistentVector Set(size_t index, Type&& value) const {
+        assert(index < size_);
+        PersistentVector result(*this);
+        result.root_ = SetIn(root_.Get(), height_, index, 0, std::forward<Type>(value));
+        return result;
+    }
+
+    [[nodiscard]] PersistentVector PopBack() const {
+        assert(size_ != 0);
+        return Take(size_ - 1);
+    }
+
+    //  Возвращает первые n элементов
+    [[nodiscard]] PersistentVector Take(size_t n) const {
+        if (n >= size_) {
+            return *this;
+        }
+        PersistentVector result;
+        if (n != 0) {
+            result.root_ = TakeIn(root_.Get(), height_, n);
+            result.height_ = height_;
+            result.size_ = n;
+            Collapse(result.root_, result.height_);
+        }
+        return result;
+    }
+
+    //  Возвращает вектор без первых n элементов
+    [[nodiscard]] PersistentVector Drop(size_t n) const {
+        if (n >= size_) {
+            return PersistentVector();
+        }
+        PersistentVector result;
+        result.root_ = DropIn(root_.Get(), height_, n);
+        result.height_ = height_;
+        result.size_ = size_ - n;
+        Collapse(result.root_, result.height_);
+        return result;
+    }
+
+    //  Возвращает элементы с индексами [first, last)
+    [[nodiscard]] PersistentVector Slice(size_t first, size_t last) const {
+        assert(first <= last);
+        return Take(last).Drop(first);
+    }
+
+    //  Возвращает конкатенацию векторов за O(log32 n), разделяя узлы обоих исходных векторов
+    [[nodiscard]] PersistentVector Concat(const PersistentVector& other) const {
+        if (size_ == 0) {
+            return other;
+        }
+        if (other.size_ == 0) {
+            return *this;
+        }
+
+        NodePair merged = ConcatIn(root_.Get(), height_, other.root_.Get(), other.height_);
+
+        PersistentVector result;
+        result.height_ = std::max(height_, other.height_);
+        result.size_ = size_ + other.size_;
+        if (merged.count == 1) {
+            result.root_ = std::move(merged.nodes[0]);
+        }
+        else {
+            NodePtr root(new Inner(0));
+            Inner* inner = AsInner(root.Get());
+            inner->children[0] = std::move(merged.nodes[0]);
+            inner->children[1] = std::move(merged.nodes[1]);
+            inner->count = 2;
+            ++result.height_;
+            ComputeSizes(inner, result.height_);
+            result.root_ = std::move(root);
+        }
+        Collapse(result.root_, result.height_);
+        return result;
+    }
+
+    Transient AsTransient() const {
+        return Transient(*this);
+    }
+
+    Vector<T> ToVector() const {
+        Vector<T> result;
+        result.Reserve(size_);
+        for (const T& value : *this) {
+            result.PushBack(value);
+        }
+        return result;
+    }
+
+    const_iterator begin() const noexcept {
+        return ConstIterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return ConstIterator(this, size_);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    /*
+    *   Итератор проходит элементы лист за листом. Внутри листа переход к следующему
+    *   элементу выполняется за O(1), спуск от корня происходит раз в 32 элемента.
+    */
+    class ConstIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        ConstIterator() = default;
+
+        reference operator*() const noexcept {
+            return leaf_[index_ - leaf_begin_];
+        }
+
+        pointer operator->() const noexcept {
+            return leaf_ + (index_ - leaf_begin_);
+        }
+
+        ConstIterator& operator++() noexcept {
+            ++index_;
+            if (index_ == leaf_end_ && index_ < vector_->size_) {
+                Load();
+            }
+            return *this;
+        }
+
+        ConstIterator operator++(int) noexcept {
+            ConstIterator tmp(*this);
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const ConstIterator& rhs) const noexcept {
+            return index_ == rhs.index_;
+        }
+
+        bool operator!=(const ConstIterator& rhs) const noexcept {
+            return index_ != rhs.index_;
+        }
+
+    private:
+        friend class PersistentVector;
+
+        ConstIterator(const PersistentVector* vector, size_t index) noexcept
+            : vector_(vector)
+            , index_(index) {
+            if (index_ < vector_->size_) {
+                Load();
+            }
+        }
+
+        void Load() noexcept {
+            leaf_ = FindLeaf(vector_->root_.Get(), vector_->height_, index_, leaf_begin_, leaf_end_);
+        }
+
+        const PersistentVector* vector_ = nullptr;
+        size_t index_ = 0;
+        const T* leaf_ = nullptr;
+        size_t leaf_begin_ = 0;
+        size_t leaf_end_ = 0;
+    };
+
+    /*
+    *   Изменяемый построитель персистентного вектора.
+    *   Изменяет на месте узлы, созданные им самим, и копирует узлы, разделяемые с другими версиями.
+    *   После Persistent() все узлы построителя становятся неизменяемыми: он получает новый токен.
+    */
+    class Transient {
+    public:
+        Transient()
+            : owner_(NextOwner()) {
+        }
+
+        explicit Transient(const PersistentVector& source)
+            : root_(source.root_)
+            , height_(source.height_)
+            , size_(source.size_)
+            , owner_(NextOwner()) {
+        }
+
+        // Копии построителя изменяли бы одни и те же узлы, поэтому построитель только перемещается
+        Transient(const Transient&) = delete;
+        Transient& operator=(const Transient&) = delete;
+        Transient(Transient&&) noexcept = default;
+        Transient& operator=(Transient&&) noexcept = default;
+
+        size_t Size() const noexcept {
+            return size_;
+        }
+
+        const T& operator[](size_t index) const noexcept {
+            assert(index < size_);
+            size_t begin = 0;
+            size_t end = 0;
+            const T* leaf = FindLeaf(root_.Get(), height_, index, begin, end);
+            return leaf[index - begin];
+        }
+
+        template <typename Type>
+        void PushBack(Type&& value) {
+            EmplaceBack(std::forward<Type>(value));
+        }
+
+        template <typename... Args>
+        T& EmplaceBack(Args&&... args) {
+            return EmplaceBackIn(root_, height_, size_, owner_, std::forward<Args>(args)...);
+        }
+
+        template <typename Type>
+        void Set(size_t index, Type&& value) {
+            assert(index < size_);
+            root_ = SetIn(root_.Get(), height_, index, owner_, std::forward<Type>(value));
+        }
+
+        void PopBack() {
+            assert(size_ != 0);
+            PersistentVector result = Persistent().PopBack();
+            root_ = std::move(result.root_);
+            height_ = result.height_;
+            size_ = result.size_;
+        }
+
+        //  Возвращает персистентный вектор с текущим содержимым за O(1)
+        PersistentVector Persistent() {
+            PersistentVector result;
+            result.root_ = root_;
+            result.height_ = height_;
+            result.size_ = size_;
+            owner_ = NextOwner();
+            return result;
+        }
+
+    private:
+        NodePtr root_;
+        size_t height_ = 0;
+        size_t size_ = 0;
+        uint64_t owner_;
+    };
+
+private:
+    NodePtr root_;
+    // Высота дерева: 0, если корень — лист
+    size_t height_ = 0;
+    size_t size_ = 0;
+
+    static uint64_t NextOwner() noexcept {
+        static std::atomic<uint64_t> next{ 1 };
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static Leaf* AsLeaf(Node* node) noexcept {
+        assert(node->leaf);
+        return static_cast<Leaf*>(node);
+    }
+
+    static const Leaf* AsLeaf(const Node* node) noexcept {
+        assert(node->leaf);
+        return static_cast<const Leaf*>(node);
+    }
+
+    static Inner* AsInner(Node* node) noexcept {
+        assert(!node->leaf);
+        return static_cast<Inner*>(node);
+    }
+
+    static const Inner* AsInner(const Node* node) noexcept {
+        assert(!node->leaf);
+        return static_cast<const Inner*>(node);
+    }
+
+    static NodePtr Share(Node* node) noexcept {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+        return NodePtr(node);
+    }
+
+    static bool IsRelaxed(const Inner* inner) noexcept {
+        return inner->sizes.Capacity() != 0;
+    }
+
+    // Максимальное количество элементов в поддереве высоты height
+    static size_t FullSize(size_t height) noexcept {
+        const size_t shift = BITS * (height + 1);
+        return shift < std::numeric_limits<size_t>::digits ? size_t(1) << shift : std::numeric_limits<size_t>::max();
+    }
+
+    static size_t SubtreeSize(const Node* node, size_t height) noexcept {
+        if (height == 0) {
+            return node->count;
+        }
+        const Inner* inner = AsInner(node);
+        if (IsRelaxed(inner)) {
+            return inner->sizes[inner->count - 1];
+        }
+        return (inner->count - 1) * FullSize(height - 1) + SubtreeSize(inner->children[inner->count - 1].Get(), height - 1);
+    }
+
+    // Пересчитывает таблицу размеров узла. Узел с полными потомками (кроме последнего) становится регулярным
+    static void ComputeSizes(Inner* inner, size_t height) {
+        RawMemory<size_t> sizes(BRANCHING);
+        bool regular = true;
+        size_t total = 0;
+        for (size_t i = 0; i < inner->count; ++i) {
+            const size_t child_size = SubtreeSize(inner->children[i].Get(), height - 1);
+            total += child_size;
+            sizes[i] = total;
+            if (i + 1 < inner->count && child_size != FullSize(height - 1)) {
+                regular = false;
+            }
+        }
+        inner->sizes = regular ? RawMemory<size_t>() : std::move(sizes);
+    }
+
+    // Находит потомка, содержащего элемент index, и переводит index в его систему отсчёта
+    static size_t FindSlot(const Inner* inner, size_t height, size_t& index) noexcept {
+        const size_t shift = BITS * height;
+        size_t slot = index >> shift;
+        if (IsRelaxed(inner)) {
+            while (inner->sizes[slot] <= index) {
+                ++slot;
+            }
+            if (slot != 0) {
+                index -= inner->sizes[slot - 1];
+            }
+        }
+        else {
+            index -= slot << shift;
+        }
+        assert(slot < inner->count);
+        return slot;
+    }
+
+    // Возвращает элементы листа, содержащего index, и диапазон индексов [begin, end) этого листа
+    static const T* FindLeaf(const Node* node, size_t height, size_t index, size_t& begin, size_t& end) noexcept {
+        const size_t global = index;
+        for (; height > 0; --height) {
+            const Inner* inner = AsInner(node);
+            node = inner->children[FindSlot(inner, height, index)].Get();
+        }
+        begin = global - index;
+        end = begin + node->count;
+        return AsLeaf(node)->values.GetAddress();
+    }
+
+    // Возвращает узел, который разрешено изменять построителю owner: сам узел или его копию
+    static NodePtr EditableLeaf(Node* node, uint64_t owner) {
+        if (owner != 0 && node->owner == owner) {
+            return Share(node);
+        }
+        const Leaf* source = AsLeaf(node);
+        NodePtr copy(new Leaf(owner));
+        Leaf* leaf = AsLeaf(copy.Get());
+        std::uninitialized_copy_n(source->values.GetAddress(), source->count, leaf->values.GetAddress());
+        leaf->count = source->count;
+        return copy;
+    }
+
+    static NodePtr EditableInner(Node* node, uint64_t owner) {
+        if (owner != 0 && node->owner == owner) {
+            return Share(node);
+        }
+        const Inner* source = AsInner(node);
+        NodePtr copy(new Inner(owner));
+        Inner* inner = AsInner(copy.Get());
+        std::copy_n(source->children, source->count, inner->children);
+        inner->count = source->count;
+        if (IsRelaxed(source)) {
+            inner->sizes = RawMemory<size_t>(BRANCHING);
+            std::copy_n(source->sizes.GetAddress(), source->count, inner->sizes.GetAddress());
+        }
+        return copy;
+    }
+
+    // Строит цепочку узлов высоты height, ведущую к листу с единственным новым элементом
+    template <typename... Args>
+    static NodePtr NewPath(size_t height, uint64_t owner, T*& constructed, Args&&... args) {
+        if (height == 0) {
+            NodePtr node(new Leaf(owner));
+            Leaf* leaf = AsLeaf(node.Get());
+            constructed = new (leaf->values.GetAddress()) T(std::forward<Args>(args)...);
+            leaf->count = 1;
+            return node;
+        }
+        NodePtr node(new Inner(owner));
+        Inner* inner = AsInner(node.Get());
+        inner->children[0] = NewPath(height - 1, owner, constructed, std::forward<Args>(args)...);
+        inner->count = 1;
+        return node;
+    }
+
+    /*
+    *   Добавляет элемент в самый правый путь поддерева.
+    *   Возвращает пустой указатель, если путь заполнен; в этом случае аргументы не используются.
+    */
+    template <typename... Args>
+    static NodePtr PushTail(Node* node, size_t height, uint64_t owner, T*& constructed, Args&&... args) {
+        if (height == 0) {
+            if (node->count == BRANCHING) {
+                return NodePtr();
+            }
+            NodePtr result = EditableLeaf(node, owner);
+            Leaf* leaf = AsLeaf(result.Get());
+            constructed = new (leaf->values + leaf->count) T(std::forward<Args>(args)...);
+            ++leaf->count;
+            return result;
+        }
+
+        const Inner* inner = AsInner(node);
+        const size_t last = inner->count - 1;
+        NodePtr child = PushTail(inner->children[last].Get(), height - 1, owner, constructed, std::forward<Args>(args)...);
+        if (child) {
+            NodePtr result = EditableInner(node, owner);
+            Inner* edited = AsInner(result.Get());
+            edited->children[last] = std::move(child);
+            if (IsRelaxed(edited)) {
+                ++edited->sizes[last];
+            }
+            return result;
+        }
+        if (inner->count == BRANCHING) {
+            return NodePtr();
+        }
+
+        // Бывший последний потомок перестаёт быть последним: регулярным узел останется, только если он полон
+        const bool last_full = SubtreeSize(inner->children[last].Get(), height - 1) == FullSize(height - 1);
+        NodePtr path = NewPath(height - 1, owner, constructed, std::forward<Args>(args)...);
+        NodePtr result = EditableInner(node, owner);
+        Inner* edited = AsInner(result.Get());
+        edited->children[edited->count] = std::move(path);
+        ++edited->count;
+        if (IsRelaxed(edited)) {
+            edited->sizes[last + 1] = edited->sizes[last] + 1;
+        }
+        else if (!last_full) {
+            ComputeSizes(edited, height);
+        }
+        return result;
+    }
+
+    template <typename... Args>
+    static T& EmplaceBackIn(NodePtr& root, size_t& height, size_t& size, uint64_t owner, Args&&... args) {
+        T* constructed = nullptr;
+        if (!root) {
+            root = NewPath(0, owner, constructed, std::forward<Args>(args)...);
+            height = 0;
+            ++size;
+            return *constructed;
+        }
+
+        NodePtr pushed = PushTail(root.Get(), height, owner, constructed, std::forward<Args>(args)...);
+        if (pushed) {
+            root = std::move(pushed);
+            ++size;
+            return *constructed;
+        }
+
+        // Дерево заполнено: над старым корнем надстраивается новый
+        NodePtr path = NewPath(height, owner, constructed, std::forward<Args>(args)...);
+        NodePtr new_root(new Inner(owner));
+        Inner* inner = AsInner(new_root.Get());
+        inner->children[0] = std::move(root);
+        inner->children[1] = std::move(path);
+        inner->count = 2;
+        ++height;
+        if (size != FullSize(height - 1)) {
+            ComputeSizes(inner, height);
+        }
+        root = std::move(new_root);
+        ++size;
+        return *constructed;
+    }
+
+    template <typename Type>
+    static NodePtr SetIn(Node* node, size_t height, size_t index, uint64_t owner, Type&& value) {
+        if (height == 0) {
+            NodePtr result = EditableLeaf(node, owner);
+            AsLeaf(result.Get())->values[index] = std::forward<Type>(value);
+            return result;
+        }
+        const size_t slot = FindSlot(AsInner(node), height, index);
+        NodePtr child = SetIn(AsInner(node)->children[slot].Get(), height - 1, index, owner, std::forward<Type>(value));
+        NodePtr result = EditableInner(node, owner);
+        AsInner(result.Get())->children[slot] = std::move(child);
+        return result;
+    }
+
+    // Оставляет в поддереве первые n элементов (n > 0)
+    static NodePtr TakeIn(Node* node, size_t height, size_t n) {
+        if (height == 0) {
+            if (n == node->count) {
+                return Share(node);
+            }
+            NodePtr result(new Leaf(0));
+            Leaf* leaf = AsLeaf(result.Get());
+            std::uninitialized_copy_n(AsLeaf(node)->values.GetAddress(), n, leaf->values.GetAddress());
+            leaf->count = n;
+            return result;
+        }
+
+        const Inner* inner = AsInner(node);
+        size_t index = n - 1;
+        const size_t slot = FindSlot(inner, height, index);
+        NodePtr child = TakeIn(inner->children[slot].Get(), height - 1, index + 1);
+        if (slot + 1 == inner->count && child.Get() == inner->children[slot].Get()) {
+            return Share(node);
+        }
+
+        NodePtr result(new Inner(0));
+        Inner* taken = AsInner(result.Get());
+        std::copy_n(inner->children, slot, taken->children);
+        taken->children[slot] = std::move(child);
+        taken->count = slot + 1;
+        // Префикс регулярного узла остаётся регулярным
+        if (IsRelaxed(inner)) {
+            taken->sizes = RawMemory<size_t>(BRANCHING);
+            std::copy_n(inner->sizes.GetAddress(), slot, taken->sizes.GetAddress());
+            taken->sizes[slot] = n;
+        }
+        return result;
+    }
+
+    // Отбрасывает в поддереве первые n элементов (n меньше размера поддерева)
+    static NodePtr DropIn(Node* node, size_t height, size_t n) {
+        if (n == 0) {
+            return Share(node);
+        }
+        if (height == 0) {
+            NodePtr result(new Leaf(0));
+            Leaf* leaf = AsLeaf(result.Get());
+            std::uninitialized_copy_n(AsLeaf(node)->values + n, node->count - n, leaf->values.GetAddress());
+            leaf->count = node->count - n;
+            return result;
+        }
+
+        const Inner* inner = AsInner(node);
+        size_t index = n;
+        const size_t slot = FindSlot(inner, height, index);
+        NodePtr child = DropIn(inner->children[slot].Get(), height - 1, index);
+
+        NodePtr result(new Inner(0));
+        Inner* dropped = AsInner(result.Get());
+        dropped->children[0] = std::move(child);
+        std::copy(inner->children + slot + 1, inner->children + inner->count, dropped->children + 1);
+        dropped->count = inner->count - slot;
+        ComputeSizes(dropped, height);
+        return result;
+    }
+
+    // Убирает корни с единственным потомком
+    static void Collapse(NodePtr& root, size_t& height) noexcept {
+        while (height > 0 && root->count == 1) {
+            NodePtr child = AsInner(root.Get())->children[0];
+            root = std::move(child);
+            --height;
+        }
+    }
+
+    static NodePtr MergeLeaves(Node* left, Node* right) {
+        NodePtr result(new Leaf(0));
+        Leaf* leaf = AsLeaf(result.Get());
+        std::uninitialized_copy_n(AsLeaf(left)->values.GetAddress(), left->count, leaf->values.GetAddress());
+        leaf->count = left->count;
+        std::uninitialized_copy_n(AsLeaf(right)->values.GetAddress(), right->count, leaf->values + leaf->count);
+        leaf->count += right->count;
+        return result;
+    }
+
+    // Сливает два поддерева и возвращает один или два узла высоты max(left_height, right_height)
+    static NodePair ConcatIn(Node* left, size_t left_height, Node* right, size_t right_height) {
+        if (left_height > right_height) {
+            Inner* inner = AsInner(left);
+            NodePair middle = ConcatIn(inner->children[inner->count - 1].Get(), left_height - 1, right, right_height);
+            return Rebalance(inner, middle, nullptr, left_height);
+        }
+        if (left_height < right_height) {
+            Inner* inner = AsInner(right);
+            NodePair middle = ConcatIn(left, left_height, inner->children[0].Get(), right_height - 1);
+            return Rebalance(nullptr, middle, inner, right_height);
+        }
+
+        NodePair result;
+        if (left_height == 0) {
+            if (left->count + right->count <= BRANCHING) {
+                result.nodes[result.count++] = MergeLeaves(left, right);
+            }
+            else {
+                result.nodes[result.count++] = Share(left);
+                result.nodes[result.count++] = Share(right);
+            }
+            return result;
+        }
+
+        Inner* left_inner = AsInner(left);
+        Inner* right_inner = AsInner(right);
+        NodePair middle = ConcatIn(
+            left_inner->children[left_inner->count - 1].Get(), left_height - 1,
+            right_inner->children[0].Get(), right_height - 1);
+        return Rebalance(left_inner, middle, right_inner, left_height);
+    }
+
+    /*
+    *   Собирает потомков left (без последнего), middle и потомков right (без первого) — узлы высоты height - 1,
+    *   перераспределяет их содержимое так, чтобы узлов было не больше оптимального количества + EXTRAS,
+    *   и упаковывает результат в один или два узла высоты height.
+    *   Узлы, которые не нужно перераспределять, переиспользуются без копирования.
+    */
+    static NodePair Rebalance(const Inner* left, NodePair& middle, const Inner* right, size_t height) {
+        NodePtr all[2 * BRANCHING];
+        size_t count = 0;
+        if (left != nullptr) {
+            for (size_t i = 0; i + 1 < left->count; ++i) {
+                all[count++] = left->children[i];
+            }
+        }
+        for (size_t i = 0; i < middle.count; ++i) {
+            all[count++] = std::move(middle.nodes[i]);
+        }
+        if (right != nullptr) {
+            for (size_t i = 1; i < right->count; ++i) {
+                all[count++] = right->children[i];
+            }
+        }
+        assert(count <= 2 * BRANCHING);
+
+        // План перераспределения: сколько слотов окажется в каждом узле
+        size_t plan[2 * BRANCHING];
+        size_t total = 0;
+        for (size_t i = 0; i < count; ++i) {
+            plan[i] = all[i]->count;
+            total += plan[i];
+        }
+        const size_t optimal = (total + BRANCHING - 1) / BRANCHING;
+        size_t planned = count;
+        size_t i = 0;
+        while (planned > optimal + EXTRAS) {
+            while (plan[i] > BRANCHING - INVARIANT) {
+                ++i;
+            }
+            // Содержимое недозаполненного узла раздаётся следующим за ним узлам
+            size_t remaining = plan[i];
+            do {
+                const size_t merged = std::min(remaining + plan[i + 1], BRANCHING);
+                remaining = remaining + plan[i + 1] - merged;
+                plan[i] = merged;
+                ++i;
+            } while (remaining > 0);
+            for (size_t j = i; j + 1 < planned; ++j) {
+                plan[j] = plan[j + 1];
+            }
+            --planned;
+            --i;
+        }
+
+        // Выполнение плана
+        NodePtr nodes[2 * BRANCHING];
+        size_t source = 0;
+        size_t offset = 0;
+        for (size_t k = 0; k < planned; ++k) {
+            if (offset == 0 && all[source]->count == plan[k]) {
+                nodes[k] = std::move(all[source++]);
+                continue;
+            }
+            if (height == 1) {
+                nodes[k] = NodePtr(new Leaf(0));
+            }
+            else {
+                nodes[k] = NodePtr(new Inner(0));
+            }
+            Node* node = nodes[k].Get();
+            while (node->count < plan[k]) {
+                Node* from = all[source].Get();
+                const size_t take = std::min(plan[k] - node->count, from->count - offset);
+                if (height == 1) {
+                    std::uninitialized_copy_n(AsLeaf(from)->values + offset, take, AsLeaf(node)->values + node->count);
+                }
+                else {
+                    std::copy_n(AsInner(from)->children + offset, take, AsInner(node)->children + node->count);
+                }
+                node->count += take;
+                offset += take;
+                if (offset == from->count) {
+                    ++source;
+                    offset = 0;
+                }
+            }
+            if (height > 1) {
+                ComputeSizes(AsInner(node), height - 1);
+            }
+        }
+
+        NodePair result;
+        for (size_t start = 0; start < planned; start += BRANCHING) {
+            NodePtr packed(new Inner(0));
+            Inner* inner = AsInner(packed.Get());
+            inner->count = std::min(BRANCHING, planned - start);
+            std::move(nodes + start, nodes + start + inner->count, inner->children);
+            ComputeSizes(inner, height);
+            result.nodes[result.count++] = std::move(packed);
+        }
+        return result;
+    }
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "epoch.h"
+#include "vector.h"
+
+/*
+*   Вектор с одним писателем и многими читателями в стиле RCU.
+*
+*   Читатель получает ReadView — снимок буфера и размера, защищённый секцией EpochDomain.
+*   Читатели не берут блокировок и могут итерировать снимок, пока писатель добавляет элементы.
+*
+*   Писатель добавляет элементы в свободную часть текущего буфера и публикует новый размер.
+*   Когда место заканчивается, он копирует элементы в новый RawMemory, публикует его
+*   через атомарный указатель и передаёт старый буфер в EpochDomain::Retire.
+*   Старый буфер освобождается только после выхода из секций всех читателей, которые могли его видеть.
+*
+*   Элементы, видимые читателям, никогда не изменяются и не перемещаются:
+*   при росте они копируются, поэтому T должен быть копируемым.
+*   Все изменяющие методы должны вызываться из одного потока-писателя.
+*/
+template <typename T>
+class RcuVector {
+    static_assert(std::is_copy_constructible_v<T>, "RcuVector copies elements on growth");
+
+private:
+    struct Buffer {
+        explicit Buffer(size_t capacity)
+            : data(capacity) {
+        }
+
+        ~Buffer() {
+            std::destroy_n(data.GetAddress(), size.load(std::memory_order_relaxed));
+        }
+
+        RawMemory<T> data;
+        std::atomic<size_t> size{ 0 };
+    };
+
+public:
+    using const_iterator = const T*;
+
+    // Снимок вектора для читателя. Пока снимок жив, его буфер не будет освобождён
+    class ReadView {
+    public:
+        size_t Size() const noexcept {
+            return size_;
+        }
+
+        const T& operator[](size_t index) const noexcept {
+            assert(index < size_);
+            return buffer_->data[index];
+        }
+
+        const_iterator begin() const noexcept {
+            return buffer_->data.GetAddress();
+        }
+
+        const_iterator end() const noexcept {
+            return buffer_->data.GetAddress() + size_;
+        }
+
+    private:
+        friend class RcuVector;
+
+        ReadView(EpochDomain::Guard&& guard, const Buffer* buffer) noexcept
+            : guard_(std::move(guard))
+            , buffer_(buffer)
+            , size_(buffer->size.load(std::memory_order_acquire)) {
+        }
+
+        EpochDomain::Guard guard_;
+        const Buffer* buffer_;
+        size_t size_;
+    };
+
+    RcuVector()
+        : buffer_(new Buffer(0)) {
+    }
+
+    RcuVector(const RcuVector&) = delete;
+    RcuVector& operator=(const RcuVector&) = delete;
+
+    //  К моменту разрушения вектора читателей быть не должно
+    ~RcuVector() {
+        delete buffer_.load(std::memory_order_acquire);
+    }
+
+    ReadView Read() const {
+        EpochDomain::Guard guard = EpochDomain::Global().Enter();
+        // Загрузка указателя не должна переупорядочиться с записью эпохи читателя, поэтому она seq_cst
+        return ReadView(std::move(guard), buffer_.load());
+    }
+
+    /* МЕТОДЫ ПИСАТЕЛЯ */
+
+    size_t Size() const noexcept {
+        return buffer_.load(std::memory_order_relaxed)->size.load(std::memory_order_relaxed);
+    }
+
+    size_t Capacity() const noexcept {
+        return buffer_.load(std::memory_order_relaxed)->data.Capacity();
+    }
+
+    void Reserve(size_t new_capacity) {
+        Buffer* current = buffer_.load(std::memory_order_relaxed);
+        if (new_capacity <= current->data.Capacity()) {
+            return;
+        }
+        auto next = std::make_unique<Buffer>(new_capacity);
+        const size_t size = current->size.load(std::memory_order_relaxed);
+        std::uninitialized_copy_n(current->data.GetAddress(), size, next->data.GetAddress());
+        next->size.store(size, std::memory_order_relaxed);
+        Publish(next.release());
+    }
+
+    template <typename Type>
+    void PushBack(Type&& value) {
+        EmplaceBack(std::forward<Type>(value));
+    }
+
+    template <typename... Args>
+    const T& EmplaceBack(Args&&... args) {
+        Buffer* current = buffer_.load(std::memory_order_relaxed);
+        const size_t size = current->size.load(std::memory_order_relaxed);
+
+        if (current->data.Capacity() > size) {
+            const T* element = new (current->data + size) T(std::forward<Args>(args)...);
+            current->size.store(size + 1, std::memory_order_release);
+            return *element;
+        }
+
+        // Новый элемент конструируется первым: аргументы могут ссылаться на элементы старого буфера
+        auto next = std::make_unique<Buffer>(size == 0 ? 1 : size * 2);
+        const T* element = new (next->data + size) T(std::forward<Args>(args)...);
+        try {
+            std::uninitialized_copy_n(current->data.GetAddress(), size, next->data.GetAddress());
+        }
+        catch (...) {
+            std::destroy_at(next->data + size);
+            throw;
+        }
+        next->size.store(size + 1, std::memory_order_relaxed);
+        Publish(next.release());
+        return *element;
+    }
+
+    //  Публикует пустой буфер. Читатели старых снимков продолжают видеть прежние элементы
+    void Clear() {
+        Publish(new Buffer(0));
+    }
+
+private:
+    std::atomic<Buffer*> buffer_;
+
+    void Publish(Buffer* next) {
+        Buffer* previous = buffer_.exchange(next);
+        EpochDomain::Global().Retire(previous, [](void* buffer) {
+            delete static_cast<Buffer*>(buffer);
+        });
+    }
+};
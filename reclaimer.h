@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+
+/*
+*   Фоновый освободитель памяти.
+*   Освобождение блоков размером в несколько гигабайт (munmap) может занимать миллисекунды.
+*   Если режим включён, RawMemory не освобождает такие блоки сама, а передаёт их фоновому потоку.
+*   Откладывается только возврат сырой памяти: элементы разрушаются в вызывающем потоке,
+*   поэтому для тривиально разрушаемых типов всё уничтожение вектора сводится к O(1).
+*
+*   Переданные блоки связываются в односвязный список прямо в своей же памяти,
+*   так что передача блока не выделяет память и не может завершиться ошибкой.
+*   Вместе со ссылкой на следующий блок сохраняется выравнивание, с которым блок был выделен.
+*/
+class BackgroundReclaimer {
+public:
+    BackgroundReclaimer(const BackgroundReclaimer&) = delete;
+    BackgroundReclaimer& operator=(const BackgroundReclaimer&) = delete;
+
+    static BackgroundReclaimer& Instance() {
+        static BackgroundReclaimer instance;
+        return instance;
+    }
+
+    /*
+    *   Включает отложенное освобождение блоков размером не меньше threshold_bytes.
+    *   При первом вызове запускает фоновый поток.
+    */
+    void Enable(size_t threshold_bytes) {
+        {
+            std::lock_guard lock(mutex_);
+            if (!worker_.joinable()) {
+                worker_ = std::thread([this] {
+                    Run();
+                });
+            }
+        }
+        threshold_.store(std::max(threshold_bytes, sizeof(Block)), std::memory_order_release);
+    }
+
+    // Выключает отложенное освобождение и дожидается освобождения уже переданных блоков
+    void Disable() {
+        threshold_.store(0, std::memory_order_release);
+        Flush();
+    }
+
+    // Дожидается, пока фоновый поток освободит все переданные ему блоки
+    void Flush() {
+        std::unique_lock lock(mutex_);
+        drained_.wait(lock, [this] {
+            return pending_ == nullptr && in_progress_ == 0;
+        });
+    }
+
+    // Количество блоков, освобождённых фоновым потоком
+    size_t ReleasedBlocks() const noexcept {
+        return released_.load(std::memory_order_relaxed);
+    }
+
+    /*
+    *   Передаёт фоновому потоку блок buf размером bytes, выделенный с выравниванием alignment.
+    *   Возвращает false, если режим выключен или блок слишком мал — тогда его нужно освободить на месте.
+    */
+    static bool TryRetire(void* buf, size_t bytes, size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__) noexcept {
+        const size_t threshold = threshold_.load(std::memory_order_acquire);
+        if (buf == nullptr || bytes < sizeof(Block) || threshold == 0 || bytes < threshold) {
+            return false;
+        }
+        Instance().Push(buf, alignment);
+        return true;
+    }
+
+private:
+    struct Block {
+        Block* next;
+        size_t alignment;
+    };
+
+    BackgroundReclaimer() = default;
+
+    ~BackgroundReclaimer() {
+        // Блоки, освобождаемые после разрушения объекта, возвращаются в кучу на месте
+        threshold_.store(0, std::memory_order_release);
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        has_work_.notify_one();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+        ReleaseList(pending_);
+    }
+
+    void Push(void* buf, size_t alignment) noexcept {
+        Block* block = new (buf) Block{ nullptr, alignment };
+        {
+            std::lock_guard lock(mutex_);
+            block->next = pending_;
+            pending_ = block;
+        }
+        has_work_.notify_one();
+    }
+
+    void Run() {
+        std::unique_lock lock(mutex_);
+        while (true) {
+            has_work_.wait(lock, [this] {
+                return stop_ || pending_ != nullptr;
+            });
+            if (stop_) {
+                return;
+            }
+            Block* list = std::exchange(pending_, nullptr);
+            ++in_progress_;
+            lock.unlock();
+            ReleaseList(list);
+            lock.lock();
+            --in_progress_;
+            if (pending_ == nullptr && in_progress_ == 0) {
+                drained_.notify_all();
+            }
+        }
+    }
+
+    void ReleaseList(Block* list) noexcept {
+        while (list != nullptr) {
+            Block* next = list->next;
+            const size_t alignment = list->alignment;
+            if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                operator delete(static_cast<void*>(list), std::align_val_t{ alignment });
+            }
+            else {
+                operator delete(static_cast<void*>(list));
+            }
+            released_.fetch_add(1, std::memory_order_relaxed);
+            list = next;
+        }
+    }
+
+    static inline std::atomic<size_t> threshold_{ 0 };
+
+    std::mutex mutex_;
+    std::condition_variable has_work_;
+    std::condition_variable drained_;
+    Block* pending_ = nullptr;
+    size_t in_progress_ = 0;
+    bool stop_ = false;
+    std::atomic<size_t> released_{ 0 };
+    std::thread worker_;
+};
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "vector.h"
+
+// Округляет вместимость кольцевого буфера до степени двойки, чтобы позиция вычислялась маской
+inline size_t RingCapacity(size_t requested) noexcept {
+    constexpr size_t MAX_CAPACITY = (std::numeric_limits<size_t>::max() >> 1) + 1;
+    assert(requested <= MAX_CAPACITY);
+    size_t capacity = 2;
+    while (capacity < requested && capacity < MAX_CAPACITY) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/*
+*   Ограниченная очередь без блокировок для одного производителя и одного потребителя.
+*
+*   Элементы конструируются в RawMemory размещающим new и разрушаются при извлечении,
+*   так же как в Vector. Позиции головы и хвоста растут монотонно, ячейка вычисляется маской.
+*   Голова и хвост лежат на разных строках кэша, а каждая сторона кэширует последнюю
+*   прочитанную позицию другой стороны и перечитывает её, только когда по копии места или элементов
+*   меньше, чем просит операция.
+*/
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : data_(RingCapacity(capacity))
+        , mask_(data_.Capacity() - 1) {
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    ~SpscRing() {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        for (size_t pos = head_.load(std::memory_order_acquire); pos != tail; ++pos) {
+            std::destroy_at(data_ + (pos & mask_));
+        }
+    }
+
+    size_t Capacity() const noexcept {
+        return data_.Capacity();
+    }
+
+    //  Приблизительное количество элементов: точное значение известно только при отсутствии конкурентов
+    size_t SizeApprox() const noexcept {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    /* МЕТОДЫ ПРОИЗВОДИТЕЛЯ */
+
+    template <typename Type>
+    bool TryPush(Type&& value) {
+        return TryEmplace(std::forward<Type>(value));
+    }
+
+    template <typename... Args>
+    bool TryEmplace(Args&&... args) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (FreeSlots(tail, 1) == 0) {
+            return false;
+        }
+        new (data_ + (tail & mask_)) T(std::forward<Args>(args)...);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*
+    *   Копирует в очередь до count элементов, начиная с first, одной публикацией хвоста.
+    *   Возвращает количество добавленных элементов. Для перемещения используйте std::make_move_iterator.
+    */
+    template <typename InputIt>
+    size_t TryPushBatch(InputIt first, size_t count) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t n = std::min(count, FreeSlots(tail, count));
+        size_t pushed = 0;
+        try {
+            for (; pushed < n; ++pushed, ++first) {
+                new (data_ + ((tail + pushed) & mask_)) T(*first);
+            }
+        }
+        catch (...) {
+            tail_.store(tail + pushed, std::memory_order_release);
+            throw;
+        }
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    /* МЕТОДЫ ПОТРЕБИТЕЛЯ */
+
+    //  Перемещает первый элемент очереди в out. Возвращает false, если очередь пуста
+    bool TryPop(T& out) {
+        return TryPopBatch(&out, 1) == 1;
+    }
+
+    //  Перемещает до max_count элементов в out одной публикацией головы. Возвращает их количество
+    template <typename OutputIt>
+    size_t TryPopBatch(OutputIt out, size_t max_count) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (cached_tail_ - head < max_count) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+        const size_t n = std::min(max_count, cached_tail_ - head);
+        size_t popped = 0;
+        try {
+            for (; popped < n; ++popped, ++out) {
+                T* slot = data_ + ((head + popped) & mask_);
+                *out = std::move(*slot);
+                std::destroy_at(slot);
+            }
+        }
+        catch (...) {
+            head_.store(head + popped, std::memory_order_release);
+            throw;
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    RawMemory<T> data_;
+    const size_t mask_;
+
+    // Позиция потребителя и его копия позиции производителя
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{ 0 };
+    size_t cached_tail_ = 0;
+
+    // Позиция производителя и его копия позиции потребителя
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{ 0 };
+    size_t cached_head_ = 0;
+
+    //  Свободные ячейки по копии головы; копия обновляется, если их меньше wanted
+    size_t FreeSlots(size_t tail, size_t wanted) noexcept {
+        if (data_.Capacity() - (tail - cached_head_) < wanted) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+        }
+        return data_.Capacity() - (tail - cached_head_);
+    }
+};
+
+/*
+*   Ограниченная очередь без блокировок для многих производителей и потребителей (схема Вьюкова).
+*
+*   У каждой ячейки есть порядковый номер: ячейка свободна для позиции pos, когда номер равен pos,
+*   и заполнена, когда номер равен pos + 1. Производители и потребители захватывают позиции CAS-ом
+*   на своём индексе, а затем публикуют ячейку записью номера.
+*
+*   Захваченная ячейка обязана быть заполнена, иначе очередь остановится, поэтому элемент,
+*   конструктор которого может выбросить исключение, сначала создаётся вне очереди,
+*   а в ячейку перемещается (перемещающий конструктор обязан быть noexcept).
+*
+*   Пакетные операции выполняются поэлементно: ячейки соседних позиций освобождаются
+*   потребителями не по порядку, и захватить диапазон одним CAS нельзя.
+*/
+template <typename T>
+class MpmcRing {
+    static_assert(std::is_nothrow_move_constructible_v<T>, "MpmcRing moves elements into claimed cells");
+
+public:
+    explicit MpmcRing(size_t capacity)
+        : data_(RingCapacity(capacity))
+        , sequences_(new std::atomic<size_t>[data_.Capacity()])
+        , mask_(data_.Capacity() - 1) {
+        for (size_t i = 0; i < data_.Capacity(); ++i) {
+            sequences_[i].store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    ~MpmcRing() {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        for (size_t pos = head_.load(std::memory_order_acquire); pos != tail; ++pos) {
+            std::destroy_at(data_ + (pos & mask_));
+        }
+    }
+
+    size_t Capacity() const noexcept {
+        return data_.Capacity();
+    }
+
+    template <typename Type>
+    bool TryPush(Type&& value) {
+        return TryEmplace(std::forward<Type>(value));
+    }
+
+    template <typename... Args>
+    bool TryEmplace(Args&&... args) {
+        if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+            size_t pos = 0;
+            if (!Claim(tail_, 0, pos)) {
+                return false;
+            }
+            new (data_ + (pos & mask_)) T(std::forward<Args>(args)...);
+            sequences_[pos & mask_].store(pos + 1, std::memory_order_release);
+            return true;
+        }
+        else {
+            T value(std::forward<Args>(args)...);
+            return TryEmplace(std::move(value));
+        }
+    }
+
+    template <typename InputIt>
+    size_t TryPushBatch(InputIt first, size_t count) {
+        size_t pushed = 0;
+        for (; pushed < count && TryPush(*first); ++pushed, ++first) {
+        }
+        return pushed;
+    }
+
+    bool TryPop(T& out) {
+        auto assign = [&out](T&& value) {
+            out = std::move(value);
+        };
+        return PopWith(assign);
+    }
+
+    template <typename OutputIt>
+    size_t TryPopBatch(OutputIt out, size_t max_count) {
+        size_t popped = 0;
+        auto assign = [&out](T&& value) {
+            *out = std::move(value);
+        };
+        for (; popped < max_count && PopWith(assign); ++popped, ++out) {
+        }
+        return popped;
+    }
+
+private:
+    RawMemory<T> data_;
+    std::unique_ptr<std::atomic<size_t>[]> sequences_;
+    const size_t mask_;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{ 0 };
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{ 0 };
+
+    /*
+    *   Извлекает элемент из захваченной ячейки, освобождает ячейку для производителей
+    *   и только затем передаёт элемент в consume, который может выбросить исключение.
+    */
+    template <typename Consumer>
+    bool PopWith(Consumer& consume) {
+        size_t pos = 0;
+        if (!Claim(head_, 1, pos)) {
+            return false;
+        }
+        T* slot = data_ + (pos & mask_);
+        T value(std::move(*slot));
+        std::destroy_at(slot);
+        sequences_[pos & mask_].store(pos + data_.Capacity(), std::memory_order_release);
+        consume(std::move(value));
+        return true;
+    }
+
+    /*
+    *   Захватывает позицию на индексе position. Ячейка готова, когда её номер равен позиции + lag:
+    *   lag = 0 для производителя (ячейка свободна) и 1 для потребителя (ячейка заполнена).
+    */
+    bool Claim(std::atomic<size_t>& position, size_t lag, size_t& pos) noexcept {
+        pos = position.load(std::memory_order_relaxed);
+        while (true) {
+            const size_t sequence = sequences_[pos & mask_].load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + lag));
+            if (diff == 0) {
+                if (position.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
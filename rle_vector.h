@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "memory_kernels.h"
+#include "span.h"
+#include "vector.h"
+#include "vector_reduce.h"
+#include "vector_search.h"
+
+/*
+*   Вектор со сжатием серий (run-length encoding) для рядов с длинными сериями одинаковых значений.
+*
+*   Серия k — это значение RunValues()[k], повторённое до индекса RunEnds()[k] (не включая его);
+*   соседние серии всегда различаются. PushBack удлиняет последнюю серию, если значение с ней совпадает,
+*   поэтому добавление в конец — амортизированное O(1). Доступ по индексу — двоичный поиск
+*   по концам серий, O(log серий), а итератор проходит элементы по порядку за O(1) на шаг.
+*
+*   Свёртки Sum, Min и Max для RleVector работают по сериям: Min и Max — векторными ядрами
+*   ReduceKernels по значениям серий, Sum — сумма произведений значения на длину серии.
+*/
+template <typename T>
+class RleVector {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        reference operator*() const noexcept {
+            return owner_->values_[run_];
+        }
+
+        pointer operator->() const noexcept {
+            return &owner_->values_[run_];
+        }
+
+        const_iterator& operator++() noexcept {
+            if (++index_ == owner_->ends_[run_]) {
+                ++run_;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept {
+            const_iterator copy(*this);
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const noexcept {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const const_iterator& other) const noexcept {
+            return index_ != other.index_;
+        }
+
+    private:
+        friend class RleVector;
+
+        const_iterator(const RleVector* owner, size_t index, size_t run) noexcept
+            : owner_(owner)
+            , index_(index)
+            , run_(run) {
+        }
+
+        const RleVector* owner_ = nullptr;
+        size_t index_ = 0;
+        size_t run_ = 0;
+    };
+
+    RleVector() = default;
+
+    /*
+    *   Сжимает элементы values. Для арифметических типов конец серии ищется векторным ядром
+    *   поиска первого неравного элемента.
+    */
+    explicit RleVector(const Vector<T>& values) {
+        const T* data = values.begin();
+        const size_t size = values.Size();
+        for (size_t first = 0; first < size;) {
+            size_t length = 1;
+            if constexpr (std::is_arithmetic_v<T>) {
+                const auto find_not_equal = SearchKernels<T>::Active().find_if[static_cast<size_t>(CompareOp::NotEqual)];
+                length += find_not_equal(data + first + 1, size - first - 1, data[first]);
+            }
+            else {
+                while (first + length < size && data[first + length] == data[first]) {
+                    ++length;
+                }
+            }
+            AppendRun(data[first], length);
+            first += length;
+        }
+    }
+
+    size_t Size() const noexcept {
+        return ends_.Size() == 0 ? 0 : ends_[ends_.Size() - 1];
+    }
+
+    bool Empty() const noexcept {
+        return ends_.Size() == 0;
+    }
+
+    size_t RunCount() const noexcept {
+        return values_.Size();
+    }
+
+    //  Значения серий
+    Span<const T> RunValues() const noexcept {
+        return Span<const T>(values_.begin(), values_.Size());
+    }
+
+    //  Концы серий: серия k занимает индексы [RunEnds()[k - 1], RunEnds()[k])
+    Span<const size_t> RunEnds() const noexcept {
+        return Span<const size_t>(ends_.begin(), ends_.Size());
+    }
+
+    size_t RunLength(size_t run) const noexcept {
+        assert(run < RunCount());
+        return ends_[run] - (run == 0 ? 0 : ends_[run - 1]);
+    }
+
+    //  Вызывает visit(value, length) для каждой серии по порядку
+    template <typename Visit>
+    void ForEachRun(Visit&& visit) const {
+        for (size_t run = 0; run < RunCount(); ++run) {
+            visit(values_[run], RunLength(run));
+        }
+    }
+
+    //  Резервирует место под runs серий
+    void Reserve(size_t runs) {
+        values_.Reserve(runs);
+        ends_.Reserve(runs);
+    }
+
+    void Clear() noexcept {
+        values_.Clear();
+        ends_.Clear();
+    }
+
+    void PushBack(const T& value) {
+        AppendRun(value, 1);
+    }
+
+    //  Добавляет count копий value одной серией или удлиняет ими последнюю серию
+    void AppendRun(const T& value, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (!Empty() && values_[values_.Size() - 1] == value) {
+            ends_[ends_.Size() - 1] += count;
+            return;
+        }
+        const size_t end = Size() + count;
+        values_.PushBack(value);
+        try {
+            ends_.PushBack(end);
+        }
+        catch (...) {
+            values_.PopBack();
+            throw;
+        }
+    }
+
+    void PopBack() noexcept {
+        assert(!Empty());
+        const size_t last = ends_.Size() - 1;
+        if (RunLength(last) == 1) {
+            values_.PopBack();
+            ends_.PopBack();
+        }
+        else {
+            --ends_[last];
+        }
+    }
+
+    //  Номер серии, в которой находится элемент index
+    size_t RunOf(size_t index) const noexcept {
+        assert(index < Size());
+        return static_cast<size_t>(std::upper_bound(ends_.begin(), ends_.end(), index) - ends_.begin());
+    }
+
+    const T& Get(size_t index) const noexcept {
+        return values_[RunOf(index)];
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return Get(index);
+    }
+
+    //  Разворачивает серии в Vector. Каждая серия заполняется ядром заполнения
+    Vector<T> ToVector() const {
+        Vector<T> result;
+        result.Reserve(Size());
+        T* out = result.SpareBegin();
+        size_t first = 0;
+        try {
+            for (size_t run = 0; run < RunCount(); ++run) {
+                UninitializedFill(out + first, ends_[run] - first, values_[run]);
+                first = ends_[run];
+            }
+        }
+        catch (...) {
+            std::destroy_n(out, first);
+            throw;
+        }
+        result.CommitSpare(Size());
+        return result;
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, Size(), RunCount());
+    }
+
+private:
+    Vector<T> values_;
+    Vector<size_t> ends_;
+};
+
+//  Сумма элементов как сумма значений серий, умноженных на их длины
+template <typename T>
+SumType<T> Sum(const RleVector<T>& v) noexcept {
+    static_assert(std::is_arithmetic_v<T>, "Sum requires an arithmetic element type");
+    const Span<const T> values = v.RunValues();
+    const Span<const size_t> ends = v.RunEnds();
+    SumType<T> sum = 0;
+    size_t first = 0;
+    for (size_t run = 0; run < values.Size(); ++run) {
+        sum += static_cast<SumType<T>>(values[run]) * static_cast<SumType<T>>(ends[run] - first);
+        first = ends[run];
+    }
+    return sum;
+}
+
+template <typename T>
+T Min(const RleVector<T>& v) noexcept {
+    static_assert(std::is_arithmetic_v<T>, "Min requires an arithmetic element type");
+    return ReduceKernels<T>::Active().min(v.RunValues().Data(), v.RunCount());
+}
+
+template <typename T>
+T Max(const RleVector<T>& v) noexcept {
+    static_assert(std::is_arithmetic_v<T>, "Max requires an arithmetic element type");
+    return ReduceKernels<T>::Active().max(v.RunValues().Data(), v.RunCount());
+}
@@ -0,0 +1,443 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cpu_features.h"
+#include "isa_dispatch.h"
+#include "soa_vector.h"
+#include "vector.h"
+
+/*
+*   Преобразования между массивом структур Vector<Struct> и столбцами SoAVector.
+*
+*   ToSoA(records, &Struct::a, &Struct::b, ...) собирает перечисленные поля в столбцы,
+*   ToAoS(columns, &Struct::a, &Struct::b, ...) раскладывает столбцы обратно по структурам.
+*   Результат конструируется прямо в запасной памяти (SpareColumn, SpareBegin) без PushBack.
+*
+*   Поля тривиально копируемых типов размером 4 и 8 байт переносятся ядрами чтения и записи
+*   с шагом (gather/scatter): AVX2 собирает по 8 или 4 значения одной инструкцией, AVX-512 ещё
+*   и раскладывает. Остальные поля копируются конструктором копирования. Начиная с
+*   PARALLEL_CONVERT_THRESHOLD записей, каждый столбец обрабатывается частями в нескольких потоках.
+*/
+
+//  Количество записей, начиная с которого преобразование выполняется в нескольких потоках
+inline constexpr size_t PARALLEL_CONVERT_THRESHOLD = size_t{ 1 } << 16;
+
+//  Поля, которые переносят ядра чтения и записи с шагом
+template <typename Field>
+inline constexpr bool IS_STRIDED_WORD = std::is_trivially_copyable_v<Field> && (sizeof(Field) == 4 || sizeof(Field) == 8);
+
+/*
+*   Скалярные ядра. Gather читает count слов размера Word из base, base + stride, ...
+*   в непрерывный массив out, Scatter раскладывает непрерывный массив in по тем же адресам.
+*/
+struct ScalarStrided {
+    template <typename Word>
+    static void Gather(const void* base, size_t stride, size_t count, void* out) noexcept {
+        const char* source = static_cast<const char*>(base);
+        char* destination = static_cast<char*>(out);
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(destination + i * sizeof(Word), source + i * stride, sizeof(Word));
+        }
+    }
+
+    template <typename Word>
+    static void Scatter(const void* in, size_t count, void* base, size_t stride) noexcept {
+        const char* source = static_cast<const char*>(in);
+        char* destination = static_cast<char*>(base);
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(destination + i * stride, source + i * sizeof(Word), sizeof(Word));
+        }
+    }
+};
+
+#if FV_X86
+
+/*
+*   Смещения элементов задаются 32-битными индексами, поэтому шаг векторных ядер ограничен:
+*   смещение последнего элемента в регистре должно помещаться в int32_t.
+*/
+inline constexpr size_t MAX_GATHER_STRIDE = size_t{ 1 } << 24;
+
+struct Avx2Strided {
+    FV_TARGET("avx2") static void Gather32(const void* base, size_t stride, size_t count, void* out) noexcept {
+        if (stride > MAX_GATHER_STRIDE) {
+            ScalarStrided::Gather<uint32_t>(base, stride, count, out);
+            return;
+        }
+        const char* source = static_cast<const char*>(base);
+        uint32_t* destination = static_cast<uint32_t*>(out);
+        const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+            _mm256_set1_epi32(static_cast<int>(stride)));
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(source + i * stride), offsets, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), words);
+        }
+        ScalarStrided::Gather<uint32_t>(source + i * stride, stride, count - i, destination + i);
+    }
+
+    FV_TARGET("avx2") static void Gather64(const void* base, size_t stride, size_t count, void* out) noexcept {
+        if (stride > MAX_GATHER_STRIDE) {
+            ScalarStrided::Gather<uint64_t>(base, stride, count, out);
+            return;
+        }
+        const char* source = static_cast<const char*>(base);
+        uint64_t* destination = static_cast<uint64_t*>(out);
+        const __m128i offsets = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(static_cast<int>(stride)));
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m256i words = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(source + i * stride), offsets, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), words);
+        }
+        ScalarStrided::Gather<uint64_t>(source + i * stride, stride, count - i, destination + i);
+    }
+};
+
+struct Avx512Strided {
+    FV_TARGET(FV_AVX512) static void Gather32(const void* base, size_t stride, size_t count, void* out) noexcept {
+        if (stride > MAX_GATHER_STRIDE) {
+            ScalarStrided::Gather<uint32_t>(base, stride, count, out);
+            return;
+        }
+        const char* source = static_cast<const char*>(base);
+        uint32_t* destination = static_cast<uint32_t*>(out);
+        const __m512i offsets = Offsets16(stride);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const __m512i words = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, offsets, source + i * stride, 1);
+            _mm512_storeu_si512(destination + i, words);
+        }
+        ScalarStrided::Gather<uint32_t>(source + i * stride, stride, count - i, destination + i);
+    }
+
+    FV_TARGET(FV_AVX512) static void Gather64(const void* base, size_t stride, size_t count, void* out) noexcept {
+        if (stride > MAX_GATHER_STRIDE) {
+            ScalarStrided::Gather<uint64_t>(base, stride, count, out);
+            return;
+        }
+        const char* source = static_cast<const char*>(base);
+        uint64_t* destination = static_cast<uint64_t*>(out);
+        const __m256i offsets = Offsets8(stride);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m512i words = _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), 0xFF, offsets, source + i * stride, 1);
+            _mm512_storeu_si512(destination + i, words);
+        }
+        ScalarStrided::Gather<uint64_t>(source + i * stride, stride, count - i, destination + i);
+    }
+
+    FV_TARGET(FV_AVX512) static void Scatter32(const void* in, size_t count, void* base, size_t stride) noexcept {
+        if (stride > MAX_GATHER_STRIDE) {
+            ScalarStrided::Scatter<uint32_t>(in, count, base, stride);
+            return;
+        }
+        const uint32_t* source = static_cast<const uint32_t*>(in);
+        char* destination = static_cast<char*>(base);
+        const __m512i offsets = Offsets16(stride);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            _mm512_i32scatter_epi32(destination + i * stride, offsets, _mm512_loadu_si512(source + i), 1);
+        }
+        ScalarStrided::Scatter<uint32_t>(source + i, count - i, destination + i * stride, stride);
+    }
+
+    FV_TARGET(FV_AVX512) static void Scatter64(const void* in, size_t count, void* base, size_t stride) noexcept {
+        if (stride > MAX_GATHER_STRIDE) {
+            ScalarStrided::Scatter<uint64_t>(in, count, base, stride);
+            return;
+        }
+        const uint64_t* source = static_cast<const uint64_t*>(in);
+        char* destination = static_cast<char*>(base);
+        const __m256i offsets = Offsets8(stride);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            _mm512_i32scatter_epi64(destination + i * stride, offsets, _mm512_loadu_si512(source + i), 1);
+        }
+        ScalarStrided::Scatter<uint64_t>(source + i, count - i, destination + i * stride, stride);
+    }
+
+private:
+    FV_TARGET(FV_AVX512) static __m512i Offsets16(size_t stride) noexcept {
+        return _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+            _mm512_set1_epi32(static_cast<int>(stride)));
+    }
+
+    FV_TARGET(FV_AVX512) static __m256i Offsets8(size_t stride) noexcept {
+        return _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(stride)));
+    }
+};
+
+#endif
+
+/*
+*   Таблица ядер чтения и записи с шагом, устроенная так же, как SearchKernels.
+*   У SSE4.2 нет инструкций gather, поэтому уровень использует скалярные ядра;
+*   у AVX2 нет scatter, и запись с шагом на этом уровне тоже скалярная.
+*/
+class StridedKernels {
+public:
+    using GatherFn = void (*)(const void*, size_t, size_t, void*);
+    using ScatterFn = void (*)(const void*, size_t, void*, size_t);
+
+    struct Table {
+        GatherFn gather32;
+        GatherFn gather64;
+        ScatterFn scatter32;
+        ScatterFn scatter64;
+    };
+
+    static const IsaDispatch<Table>& Dispatch() noexcept {
+        static constexpr Table SCALAR{ &ScalarStrided::Gather<uint32_t>, &ScalarStrided::Gather<uint64_t>,
+            &ScalarStrided::Scatter<uint32_t>, &ScalarStrided::Scatter<uint64_t> };
+#if FV_X86
+        static constexpr Table AVX2{ &Avx2Strided::Gather32, &Avx2Strided::Gather64,
+            &ScalarStrided::Scatter<uint32_t>, &ScalarStrided::Scatter<uint64_t> };
+        static constexpr Table AVX512{ &Avx512Strided::Gather32, &Avx512Strided::Gather64,
+            &Avx512Strided::Scatter32, &Avx512Strided::Scatter64 };
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR, nullptr, &AVX2, &AVX512);
+#else
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR);
+#endif
+        return DISPATCH;
+    }
+
+    static const Table& Active() noexcept {
+        static const Table& table = Dispatch().Active();
+        return table;
+    }
+
+    static const Table& ForLevel(IsaLevel level) noexcept {
+        return Dispatch().ForLevel(level);
+    }
+};
+
+/*
+*   Делит [0, count) на непрерывные части и вызывает run(first, size) для каждой.
+*   Начиная с PARALLEL_CONVERT_THRESHOLD элементов части выполняются в max_threads потоках,
+*   по потоку на часть; первую часть выполняет вызывающий поток. Если поток или память под потоки
+*   получить не удалось, оставшиеся части выполняются в вызывающем потоке. run не должен выбрасывать исключений.
+*/
+template <typename Run>
+void ForEachChunk(size_t count, Run&& run, size_t max_threads = std::thread::hardware_concurrency()) {
+    const size_t parts = std::clamp<size_t>(std::min(max_threads, count / PARALLEL_CONVERT_THRESHOLD), 1, count == 0 ? 1 : count);
+    if (parts == 1) {
+        run(size_t{ 0 }, count);
+        return;
+    }
+    const size_t chunk = (count + parts - 1) / parts;
+    auto run_part = [&run, count, chunk](size_t part) {
+        const size_t first = std::min(part * chunk, count);
+        run(first, std::min(chunk, count - first));
+    };
+
+    std::vector<std::thread> workers;
+    size_t next = 1;
+    try {
+        // После резервирования emplace_back не перевыделяет память и может выбросить только system_error
+        workers.reserve(parts - 1);
+        for (; next < parts; ++next) {
+            workers.emplace_back(run_part, next);
+        }
+    }
+    catch (const std::system_error&) {
+    }
+    catch (const std::bad_alloc&) {
+    }
+    for (size_t part = next; part < parts; ++part) {
+        run_part(part);
+    }
+    run_part(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+
+/*
+*   Записи обрабатываются блоками по CONVERT_BLOCK: все поля блока переносятся, пока его строки
+*   кэша ещё в L1, поэтому массив структур читается и пишется за один проход, а не по разу на поле.
+*/
+inline constexpr size_t CONVERT_BLOCK = 256;
+
+//  Смещение поля field в байтах от начала объекта object
+template <typename Struct, typename Field>
+size_t FieldOffset(const Struct& object, Field Struct::* field) noexcept {
+    return static_cast<size_t>(reinterpret_cast<const char*>(&(object.*field)) - reinterpret_cast<const char*>(&object));
+}
+
+//  Конструирует в неинициализированной памяти out копии поля field записей records[0, count)
+template <typename Struct, typename Field>
+void GatherBlock(const StridedKernels::Table& kernels, const Struct* records, size_t count,
+    Field Struct::* field, size_t offset, Field* out) noexcept {
+    if constexpr (IS_STRIDED_WORD<Field>) {
+        const auto gather = sizeof(Field) == 4 ? kernels.gather32 : kernels.gather64;
+        gather(reinterpret_cast<const char*>(records) + offset, sizeof(Struct), count, out);
+    }
+    else {
+        static_assert(std::is_nothrow_copy_constructible_v<Field>);
+        for (size_t i = 0; i < count; ++i) {
+            new (out + i) Field(records[i].*field);
+        }
+    }
+}
+
+//  Записывает column[0, count) в поле field сконструированных записей out
+template <typename Struct, typename Field>
+void ScatterBlock(const StridedKernels::Table& kernels, const Field* column, size_t count,
+    Struct* out, Field Struct::* field, size_t offset) noexcept {
+    if constexpr (IS_STRIDED_WORD<Field>) {
+        const auto scatter = sizeof(Field) == 4 ? kernels.scatter32 : kernels.scatter64;
+        scatter(column, count, reinterpret_cast<char*>(out) + offset, sizeof(Struct));
+    }
+    else {
+        static_assert(std::is_nothrow_copy_assignable_v<Field>);
+        for (size_t i = 0; i < count; ++i) {
+            out[i].*field = column[i];
+        }
+    }
+}
+
+/*
+*   Поля с конструктором копирования без исключений собираются блоками в нескольких потоках.
+*   Иначе столбцы собираются по очереди в одном потоке, и при исключении уже собранные
+*   копии разрушаются.
+*/
+template <typename Struct, typename... Fields, size_t... I>
+void GatherFields(const Struct* records, size_t count, SoAVector<Fields...>& columns,
+    std::index_sequence<I...>, Fields Struct::*... fields) {
+    const auto& kernels = StridedKernels::Active();
+    const size_t offsets[] = { FieldOffset(records[0], fields)... };
+    const std::tuple<Fields*...> out(columns.template SpareColumn<I>()...);
+
+    if constexpr ((std::is_nothrow_copy_constructible_v<Fields> && ...)) {
+        ForEachChunk(count, [&](size_t first, size_t size) {
+            for (size_t block = first; block < first + size; block += CONVERT_BLOCK) {
+                const size_t n = std::min(CONVERT_BLOCK, first + size - block);
+                (GatherBlock(kernels, records + block, n, fields, offsets[I], std::get<I>(out) + block), ...);
+            }
+        });
+    }
+    else {
+        size_t gathered = 0;
+        auto gather = [&](auto field, auto* column) {
+            using Field = std::remove_pointer_t<decltype(column)>;
+            if constexpr (std::is_nothrow_copy_constructible_v<Field>) {
+                GatherBlock(kernels, records, count, field, offsets[gathered], column);
+            }
+            else {
+                size_t constructed = 0;
+                try {
+                    for (; constructed < count; ++constructed) {
+                        new (column + constructed) Field(records[constructed].*field);
+                    }
+                }
+                catch (...) {
+                    std::destroy_n(column, constructed);
+                    throw;
+                }
+            }
+            ++gathered;
+        };
+        try {
+            (gather(fields, std::get<I>(out)), ...);
+        }
+        catch (...) {
+            ((I < gathered ? static_cast<void>(std::destroy_n(std::get<I>(out), count)) : void()), ...);
+            throw;
+        }
+    }
+}
+
+/*
+*   Собирает поля fields всех записей в столбцы SoAVector в порядке перечисления.
+*   Например, ToSoA(particles, &Particle::x, &Particle::vx) даёт SoAVector<double, double>.
+*/
+template <typename Struct, typename... Fields>
+SoAVector<Fields...> ToSoA(const Vector<Struct>& records, Fields Struct::*... fields) {
+    static_assert(sizeof...(Fields) > 0, "ToSoA needs at least one field");
+    SoAVector<Fields...> columns;
+    if (records.Size() == 0) {
+        return columns;
+    }
+    columns.Reserve(records.Size());
+    GatherFields(records.begin(), records.Size(), columns, std::index_sequence_for<Fields...>{}, fields...);
+    columns.CommitSpare(records.Size());
+    return columns;
+}
+
+template <typename Struct, typename... Fields, size_t... I>
+void ScatterFields(const SoAVector<Fields...>& columns, Struct* out, std::index_sequence<I...>, Fields Struct::*... fields) {
+    const size_t count = columns.Size();
+    const auto& kernels = StridedKernels::Active();
+    const Struct probe{};
+    const size_t offsets[] = { FieldOffset(probe, fields)... };
+    const std::tuple<const Fields*...> in(columns.template Column<I>().Data()...);
+
+    // Тривиальную структуру, поля которой покрывают её целиком, обнулять перед раскладкой не нужно
+    constexpr bool COVERED = std::is_trivially_default_constructible_v<Struct> && std::is_trivially_destructible_v<Struct>
+        && (IS_STRIDED_WORD<Fields> && ...) && (sizeof(Fields) + ...) == sizeof(Struct);
+    ForEachChunk(count, [&](size_t first, size_t size) {
+        for (size_t block = first; block < first + size; block += CONVERT_BLOCK) {
+            const size_t n = std::min(CONVERT_BLOCK, first + size - block);
+            if constexpr (!COVERED) {
+                std::uninitialized_value_construct_n(out + block, n);
+            }
+            (ScatterBlock(kernels, std::get<I>(in) + block, n, out + block, fields, offsets[I]), ...);
+        }
+    });
+}
+
+template <typename Struct, typename... Fields, size_t... I>
+void AssignFields(const SoAVector<Fields...>& columns, size_t index, Struct& record,
+    std::index_sequence<I...>, Fields Struct::*... fields) {
+    ((record.*fields = columns[index].template Get<I>()), ...);
+}
+
+/*
+*   Раскладывает столбцы по полям fields новых структур; каждое поле перечисляется не больше
+*   одного раза. Поля структуры, которых нет в списке, инициализируются значением по умолчанию.
+*
+*   Если конструктор по умолчанию структуры и присваивание полей не выбрасывают исключений,
+*   записи конструируются и заполняются блоками в нескольких потоках прямо в сырой памяти вектора.
+*   Иначе все записи сначала конструируются по умолчанию, а затем по очереди получают значения полей.
+*/
+template <typename Struct, typename... Fields>
+Vector<Struct> ToAoS(const SoAVector<Fields...>& columns, Fields Struct::*... fields) {
+    static_assert(sizeof...(Fields) > 0, "ToAoS needs at least one field");
+    const size_t count = columns.Size();
+    Vector<Struct> records;
+    if (count == 0) {
+        return records;
+    }
+    records.Reserve(count);
+    Struct* out = records.SpareBegin();
+
+    if constexpr (std::is_nothrow_default_constructible_v<Struct> && (std::is_nothrow_copy_assignable_v<Fields> && ...)) {
+        ScatterFields(columns, out, std::index_sequence_for<Fields...>{}, fields...);
+    }
+    else {
+        std::uninitialized_value_construct_n(out, count);
+        try {
+            for (size_t i = 0; i < count; ++i) {
+                AssignFields(columns, i, out[i], std::index_sequence_for<Fields...>{}, fields...);
+            }
+        }
+        catch (...) {
+            std::destroy_n(out, count);
+            throw;
+        }
+    }
+    records.CommitSpare(count);
+    return records;
+}
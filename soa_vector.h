@@ -0,0 +1,602 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "span.h"
+#include "vector.h"
+
+/*
+*   Вектор записей, хранящий каждое поле в отдельном столбце (structure of arrays).
+*
+*   Цикл, которому нужны два поля из девяти, читает только их столбцы и не тянет через кэш
+*   остальные поля записи, как это делает Vector<Struct>. Столбцы — отдельные RawMemory,
+*   выровненные по строке кэша, с общими размером и вместимостью; Column<I>() отдаёт столбец
+*   как Span, который можно передать векторному ядру (Sum, Find, ...).
+*
+*   operator[] и итераторы возвращают прокси-ссылку на запись: Get<I>() даёт ссылку на поле,
+*   присваивание value_type записывает все поля, преобразование в value_type копирует запись.
+*   Рост, Reserve, Erase, EraseUnordered, PopBack и политика уменьшения вместимости
+*   ведут себя так же, как в Vector.
+*/
+template <typename... Fields>
+class SoAVector {
+    static_assert(sizeof...(Fields) > 0, "SoAVector needs at least one field");
+
+public:
+    using value_type = std::tuple<Fields...>;
+
+    static constexpr size_t FIELD_COUNT = sizeof...(Fields);
+
+    //  Выравнивание начала каждого столбца: строка кэша, достаточная и для загрузок AVX-512
+    static constexpr size_t COLUMN_ALIGNMENT = CACHE_LINE_SIZE;
+
+    template <size_t I>
+    using FieldType = std::tuple_element_t<I, value_type>;
+
+private:
+    template <typename Field>
+    using ColumnMemory = RawMemory<Field, std::max(alignof(Field), COLUMN_ALIGNMENT)>;
+
+    using Columns = std::tuple<ColumnMemory<Fields>...>;
+    using Indices = std::index_sequence_for<Fields...>;
+
+    template <bool IS_CONST>
+    using Owner = std::conditional_t<IS_CONST, const SoAVector, SoAVector>;
+
+    /*
+    *   Прокси-ссылка на запись: указатель на вектор и индекс. Действительна, пока вектор
+    *   не перевыделит память, как и ссылка на элемент Vector.
+    */
+    template <bool IS_CONST>
+    class BasicReference {
+    public:
+        //  Неконстантная ссылка неявно преобразуется в константную
+        BasicReference(const BasicReference<false>& other) noexcept
+            : owner_(other.owner_)
+            , index_(other.index_) {
+        }
+
+        template <size_t I>
+        auto& Get() const noexcept {
+            return std::get<I>(owner_->columns_)[index_];
+        }
+
+        operator value_type() const {
+            return ToValue(Indices{});
+        }
+
+        //  Записывает все поля. Как и у std::vector<bool>::reference, присваивание меняет запись, а не ссылку
+        const BasicReference& operator=(const value_type& value) const {
+            static_assert(!IS_CONST, "Cannot assign through a const SoAVector reference");
+            Assign(value, Indices{});
+            return *this;
+        }
+
+        const BasicReference& operator=(value_type&& value) const {
+            static_assert(!IS_CONST, "Cannot assign through a const SoAVector reference");
+            Assign(std::move(value), Indices{});
+            return *this;
+        }
+
+        const BasicReference& operator=(const BasicReference& other) const {
+            return *this = static_cast<value_type>(other);
+        }
+
+    private:
+        friend class SoAVector;
+
+        template <bool>
+        friend class BasicReference;
+
+        BasicReference(Owner<IS_CONST>* owner, size_t index) noexcept
+            : owner_(owner)
+            , index_(index) {
+        }
+
+        template <size_t... I>
+        value_type ToValue(std::index_sequence<I...>) const {
+            return value_type(Get<I>()...);
+        }
+
+        template <typename Value, size_t... I>
+        void Assign(Value&& value, std::index_sequence<I...>) const {
+            ((Get<I>() = std::get<I>(std::forward<Value>(value))), ...);
+        }
+
+        Owner<IS_CONST>* owner_;
+        size_t index_;
+    };
+
+    template <bool IS_CONST>
+    class BasicIterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = SoAVector::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = BasicReference<IS_CONST>;
+        using pointer = void;
+
+        BasicIterator() = default;
+
+        //  Неконстантный итератор неявно преобразуется в константный
+        template <bool OTHER_CONST, typename = std::enable_if_t<IS_CONST && !OTHER_CONST>>
+        BasicIterator(const BasicIterator<OTHER_CONST>& other) noexcept
+            : owner_(other.owner_)
+            , index_(other.index_) {
+        }
+
+        reference operator*() const noexcept {
+            return reference(owner_, index_);
+        }
+
+        reference operator[](difference_type offset) const noexcept {
+            return reference(owner_, index_ + offset);
+        }
+
+        BasicIterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        BasicIterator operator++(int) noexcept {
+            BasicIterator tmp(*this);
+            ++index_;
+            return tmp;
+        }
+
+        BasicIterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+
+        BasicIterator operator--(int) noexcept {
+            BasicIterator tmp(*this);
+            --index_;
+            return tmp;
+        }
+
+        BasicIterator& operator+=(difference_type offset) noexcept {
+            index_ += offset;
+            return *this;
+        }
+
+        BasicIterator& operator-=(difference_type offset) noexcept {
+            index_ -= offset;
+            return *this;
+        }
+
+        friend BasicIterator operator+(BasicIterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+
+        friend BasicIterator operator+(difference_type offset, BasicIterator it) noexcept {
+            return it += offset;
+        }
+
+        friend BasicIterator operator-(BasicIterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+
+        friend difference_type operator-(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+        }
+
+        friend bool operator==(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+
+        friend bool operator!=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.index_ != rhs.index_;
+        }
+
+        friend bool operator<(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.index_ < rhs.index_;
+        }
+
+        friend bool operator>(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.index_ > rhs.index_;
+        }
+
+        friend bool operator<=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.index_ <= rhs.index_;
+        }
+
+        friend bool operator>=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+            return lhs.index_ >= rhs.index_;
+        }
+
+    private:
+        friend class SoAVector;
+
+        template <bool>
+        friend class BasicIterator;
+
+        BasicIterator(Owner<IS_CONST>* owner, size_t index) noexcept
+            : owner_(owner)
+            , index_(index) {
+        }
+
+        Owner<IS_CONST>* owner_ = nullptr;
+        size_t index_ = 0;
+    };
+
+public:
+    using Reference = BasicReference<false>;
+    using ConstReference = BasicReference<true>;
+    using iterator = BasicIterator<false>;
+    using const_iterator = BasicIterator<true>;
+
+    SoAVector() = default;
+
+    //  Создаёт size записей, поля которых инициализированы значением по умолчанию
+    explicit SoAVector(size_t size)
+        : columns_(AllocateColumns(size, Indices{})) {
+        ValueConstruct(columns_, 0, size, Indices{});
+        size_ = size;
+    }
+
+    SoAVector(const SoAVector& other)
+        : columns_(AllocateColumns(other.size_, Indices{}))
+        , shrink_policy_(other.shrink_policy_) {
+        CopyColumns(other.columns_, columns_, other.size_, Indices{});
+        size_ = other.size_;
+    }
+
+    SoAVector(SoAVector&& other) noexcept {
+        Swap(other);
+    }
+
+    SoAVector& operator=(const SoAVector& rhs) {
+        if (this != &rhs) {
+            SoAVector tmp(rhs);
+            Swap(tmp);
+        }
+        return *this;
+    }
+
+    SoAVector& operator=(SoAVector&& rhs) noexcept {
+        Swap(rhs);
+        return *this;
+    }
+
+    ~SoAVector() {
+        DestroyRange(columns_, 0, size_, Indices{});
+    }
+
+    void Swap(SoAVector& other) noexcept {
+        SwapColumns(other.columns_, Indices{});
+        std::swap(size_, other.size_);
+        std::swap(shrink_policy_, other.shrink_policy_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
+
+    size_t Capacity() const noexcept {
+        return std::get<0>(columns_).Capacity();
+    }
+
+    //  Резервирует место под new_capacity записей во всех столбцах. Если вместимость достаточна, ничего не делает
+    void Reserve(size_t new_capacity) {
+        if (new_capacity > Capacity()) {
+            Reallocate(new_capacity);
+        }
+    }
+
+    void ShrinkToFit() {
+        if (Capacity() > size_) {
+            Reallocate(size_);
+        }
+    }
+
+    //  Изменяет количество записей. Новые записи инициализируются значением по умолчанию
+    void Resize(size_t new_size) {
+        Reserve(new_size);
+        if (size_ < new_size) {
+            ValueConstruct(columns_, size_, new_size - size_, Indices{});
+        }
+        else {
+            DestroyRange(columns_, new_size, size_ - new_size, Indices{});
+        }
+        size_ = new_size;
+        MaybeShrink();
+    }
+
+    void Clear() noexcept {
+        DestroyRange(columns_, 0, size_, Indices{});
+        size_ = 0;
+        MaybeShrink();
+    }
+
+    void SetShrinkPolicy(ShrinkPolicy policy) noexcept {
+        shrink_policy_ = policy;
+        MaybeShrink();
+    }
+
+    ShrinkPolicy GetShrinkPolicy() const noexcept {
+        return shrink_policy_;
+    }
+
+    Reference operator[](size_t index) noexcept {
+        assert(index < size_);
+        return Reference(this, index);
+    }
+
+    ConstReference operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return ConstReference(this, index);
+    }
+
+    //  Столбец поля I: непрерывный массив из Size() значений, выровненный по COLUMN_ALIGNMENT
+    template <size_t I>
+    Span<FieldType<I>> Column() noexcept {
+        return Span<FieldType<I>>(std::get<I>(columns_).GetAddress(), size_);
+    }
+
+    template <size_t I>
+    Span<const FieldType<I>> Column() const noexcept {
+        return Span<const FieldType<I>>(std::get<I>(columns_).GetAddress(), size_);
+    }
+
+    /*
+    *   Указатель на неинициализированную память столбца I сразу за последней записью.
+    *   В столбцах можно сконструировать до Capacity() - Size() полей и затем присоединить записи
+    *   методом CommitSpare — так же, как Vector::SpareBegin, но по столбцам.
+    */
+    template <size_t I>
+    FieldType<I>* SpareColumn() noexcept {
+        return std::get<I>(columns_) + size_;
+    }
+
+    //  Делает частью вектора n записей, все поля которых сконструированы в запасной памяти столбцов
+    void CommitSpare(size_t n) noexcept {
+        assert(size_ + n <= Capacity());
+        size_ += n;
+    }
+
+    /*
+    *   Добавляет запись, конструируя каждое поле из своего аргумента.
+    *   Аргументы могут ссылаться на поля записей этого же вектора: как и в Vector::EmplaceBack,
+    *   при росте новая запись конструируется до переноса старых.
+    */
+    template <typename... Args>
+    Reference EmplaceBack(Args&&... args) {
+        static_assert(sizeof...(Args) == FIELD_COUNT, "SoAVector::EmplaceBack takes one argument per field");
+        if (size_ < Capacity()) {
+            ConstructAt(columns_, size_, Indices{}, std::forward<Args>(args)...);
+        }
+        else {
+            Columns new_columns = AllocateColumns(size_ == 0 ? 1 : size_ * 2, Indices{});
+            ConstructAt(new_columns, size_, Indices{}, std::forward<Args>(args)...);
+            try {
+                RelocateColumns(columns_, new_columns, size_, Indices{});
+            }
+            catch (...) {
+                DestroyRange(new_columns, size_, 1, Indices{});
+                throw;
+            }
+            DestroyRange(columns_, 0, size_, Indices{});
+            columns_.swap(new_columns);
+        }
+        ++size_;
+        return Reference(this, size_ - 1);
+    }
+
+    void PushBack(const value_type& value) {
+        std::apply([this](const Fields&... fields) {
+            EmplaceBack(fields...);
+        }, value);
+    }
+
+    void PushBack(value_type&& value) {
+        std::apply([this](Fields&... fields) {
+            EmplaceBack(std::move(fields)...);
+        }, value);
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        DestroyRange(columns_, size_ - 1, 1, Indices{});
+        --size_;
+        MaybeShrink();
+    }
+
+    //  Удаляет запись, сдвигая последующие записи каждого столбца на одну позицию
+    iterator Erase(const_iterator pos) {
+        const size_t index = pos.index_;
+        assert(index < size_);
+        ShiftLeft(index, Indices{});
+        DestroyRange(columns_, size_ - 1, 1, Indices{});
+        --size_;
+        MaybeShrink();
+        return iterator(this, index);
+    }
+
+    //  Удаляет запись за O(1), перемещая на её место последнюю. Порядок записей не сохраняется
+    iterator EraseUnordered(const_iterator pos) {
+        const size_t index = pos.index_;
+        assert(index < size_);
+        if (index != size_ - 1) {
+            MoveRecord(size_ - 1, index, Indices{});
+        }
+        DestroyRange(columns_, size_ - 1, 1, Indices{});
+        --size_;
+        MaybeShrink();
+        return iterator(this, index);
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator(this, size_);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+private:
+    Columns columns_;
+    size_t size_ = 0;
+    ShrinkPolicy shrink_policy_ = ShrinkPolicy::Never;
+
+    template <size_t... I>
+    static Columns AllocateColumns(size_t capacity, std::index_sequence<I...>) {
+        return Columns(ColumnMemory<Fields>(capacity)...);
+    }
+
+    /*
+    *   Конструирует поля записи index. Если конструктор поля выбрасывает исключение,
+    *   уже сконструированные поля этой записи разрушаются.
+    */
+    template <size_t... I, typename... Args>
+    static void ConstructAt(Columns& columns, size_t index, std::index_sequence<I...>, Args&&... args) {
+        size_t constructed = 0;
+        try {
+            ((new (std::get<I>(columns) + index) Fields(std::forward<Args>(args)), ++constructed), ...);
+        }
+        catch (...) {
+            ((I < constructed ? std::destroy_at(std::get<I>(columns) + index) : void()), ...);
+            throw;
+        }
+    }
+
+    //  Разрушает записи [first, first + count) во всех столбцах
+    template <size_t... I>
+    static void DestroyRange(Columns& columns, size_t first, size_t count, std::index_sequence<I...>) noexcept {
+        (std::destroy_n(std::get<I>(columns) + first, count), ...);
+    }
+
+    /*
+    *   Применяет operation к столбцам по порядку. Если она выбрасывает исключение на столбце k,
+    *   записи [first, first + count) столбцов до k разрушаются: столбец k свои разрушает сам,
+    *   как это делают std::uninitialized_*.
+    */
+    template <size_t... I, typename Operation>
+    static void ForEachColumnOrRollback(Columns& columns, size_t first, size_t count,
+        std::index_sequence<I...>, Operation&& operation) {
+        size_t done = 0;
+        try {
+            ((operation(std::integral_constant<size_t, I>{}), ++done), ...);
+        }
+        catch (...) {
+            ((I < done ? static_cast<void>(std::destroy_n(std::get<I>(columns) + first, count)) : void()), ...);
+            throw;
+        }
+    }
+
+    template <size_t... I>
+    static void ValueConstruct(Columns& columns, size_t first, size_t count, std::index_sequence<I...> indices) {
+        ForEachColumnOrRollback(columns, first, count, indices, [&](auto column) {
+            std::uninitialized_value_construct_n(std::get<decltype(column)::value>(columns) + first, count);
+        });
+    }
+
+    template <size_t... I>
+    static void CopyColumns(const Columns& from, Columns& to, size_t count, std::index_sequence<I...> indices) {
+        ForEachColumnOrRollback(to, 0, count, indices, [&](auto column) {
+            std::uninitialized_copy_n(std::get<decltype(column)::value>(from).GetAddress(), count, std::get<decltype(column)::value>(to).GetAddress());
+        });
+    }
+
+    //  Переносится ли поле перемещением, как в Vector: если перемещение не бросает или копирования нет
+    template <typename Field>
+    static constexpr bool MOVES_ON_RELOCATION = std::is_nothrow_move_constructible_v<Field>
+        || !std::is_copy_constructible_v<Field>;
+
+    //  Переносит столбец I, если его способ переноса совпадает с проходом. Возвращает, был ли столбец перенесён
+    template <size_t I, bool COPY_PASS>
+    static bool RelocateColumn(Columns& from, Columns& to, size_t count) {
+        using Field = FieldType<I>;
+        if constexpr (MOVES_ON_RELOCATION<Field> == COPY_PASS) {
+            return false;
+        }
+        else if constexpr (COPY_PASS) {
+            std::uninitialized_copy_n(std::get<I>(from).GetAddress(), count, std::get<I>(to).GetAddress());
+            return true;
+        }
+        else {
+            std::uninitialized_move_n(std::get<I>(from).GetAddress(), count, std::get<I>(to).GetAddress());
+            return true;
+        }
+    }
+
+    /*
+    *   Переносит count записей в новые столбцы. Сначала копируются столбцы, которые переносятся
+    *   копированием: если копирование выбросит исключение, старые столбцы ещё не тронуты
+    *   перемещением, и вектор остаётся прежним, как Vector при таком же типе элементов.
+    */
+    template <size_t... I>
+    static void RelocateColumns(Columns& from, Columns& to, size_t count, std::index_sequence<I...>) {
+        bool relocated[FIELD_COUNT] = {};
+        try {
+            ((relocated[I] = RelocateColumn<I, true>(from, to, count)), ...);
+            ((relocated[I] = relocated[I] || RelocateColumn<I, false>(from, to, count)), ...);
+        }
+        catch (...) {
+            ((relocated[I] ? static_cast<void>(std::destroy_n(std::get<I>(to).GetAddress(), count)) : void()), ...);
+            throw;
+        }
+    }
+
+    void Reallocate(size_t new_capacity) {
+        assert(new_capacity >= size_);
+        Columns new_columns = AllocateColumns(new_capacity, Indices{});
+        RelocateColumns(columns_, new_columns, size_, Indices{});
+        DestroyRange(columns_, 0, size_, Indices{});
+        columns_.swap(new_columns);
+    }
+
+    // Уменьшает вместимость, если этого требует политика. Ошибки перевыделения не критичны и игнорируются
+    void MaybeShrink() noexcept {
+        if (shrink_policy_ != ShrinkPolicy::Hysteresis || size_ >= Capacity() / 4) {
+            return;
+        }
+        try {
+            Reallocate(size_ * 2);
+        }
+        catch (...) {
+        }
+    }
+
+    template <size_t... I>
+    void SwapColumns(Columns& other, std::index_sequence<I...>) noexcept {
+        (std::get<I>(columns_).Swap(std::get<I>(other)), ...);
+    }
+
+    template <size_t... I>
+    void ShiftLeft(size_t index, std::index_sequence<I...>) {
+        (std::move(std::get<I>(columns_) + index + 1, std::get<I>(columns_) + size_, std::get<I>(columns_) + index), ...);
+    }
+
+    template <size_t... I>
+    void MoveRecord(size_t from, size_t to, std::index_sequence<I...>) {
+        ((std::get<I>(columns_)[to] = std::move(std::get<I>(columns_)[from])), ...);
+    }
+};
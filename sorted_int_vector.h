@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "packed_int_vector.h"
+#include "vector.h"
+
+/*
+*   Сжатый неубывающий вектор uint64_t для отсортированных списков идентификаторов и отметок времени.
+*
+*   Значения делятся на блоки по BLOCK. Блок хранит своё первое значение (базу) и смещения остальных
+*   значений от базы, упакованные в ширину, которой хватает на смещение последнего значения блока.
+*   Смещения от базы блока (frame of reference), а не разности соседей, дают доступ по индексу за O(1)
+*   и двоичный поиск прямо по упакованным смещениям, а распаковка блока — это векторная распаковка
+*   PackedKernels и прибавление базы.
+*
+*   Базы блоков лежат отдельным массивом и служат указателями пропуска: LowerBound ищет блок двоичным
+*   поиском по базам и затем двоичным поиском внутри одного блока. Последние значения, ещё
+*   не набравшие блок, хранятся несжатыми и сжимаются, когда их становится BLOCK, поэтому
+*   добавление в конец — амортизированное O(1).
+*/
+class SortedIntVector {
+public:
+    static constexpr size_t BLOCK = 128;
+
+    SortedIntVector() = default;
+
+    //  Сжимает неубывающую последовательность values
+    explicit SortedIntVector(const Vector<uint64_t>& values) {
+        Append(values.begin(), values.Size());
+    }
+
+    size_t Size() const noexcept {
+        return blocks_.Size() * BLOCK + tail_.Size();
+    }
+
+    bool Empty() const noexcept {
+        return Size() == 0;
+    }
+
+    size_t BlockCount() const noexcept {
+        return blocks_.Size();
+    }
+
+    //  Объём сжатых данных в байтах вместе с заголовками блоков и несжатым хвостом
+    size_t CompressedBytes() const noexcept {
+        return words_.Size() * sizeof(uint64_t) + blocks_.Size() * sizeof(Block) + bases_.Size() * sizeof(uint64_t)
+            + tail_.Size() * sizeof(uint64_t);
+    }
+
+    uint64_t Back() const noexcept {
+        assert(!Empty());
+        return tail_.Size() != 0 ? tail_[tail_.Size() - 1] : Get(Size() - 1);
+    }
+
+    //  Значение не меньше последнего
+    void PushBack(uint64_t value) {
+        assert(Empty() || value >= Back());
+        tail_.PushBack(value);
+        if (tail_.Size() == BLOCK) {
+            CompressTail();
+        }
+    }
+
+    void Append(const uint64_t* values, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            PushBack(values[i]);
+        }
+    }
+
+    uint64_t Get(size_t index) const noexcept {
+        assert(index < Size());
+        const size_t block = index / BLOCK;
+        if (block == blocks_.Size()) {
+            return tail_[index % BLOCK];
+        }
+        return bases_[block] + ReadOffset(block, index % BLOCK);
+    }
+
+    uint64_t operator[](size_t index) const noexcept {
+        return Get(index);
+    }
+
+    //  Индекс первого значения, не меньшего value, либо Size()
+    size_t LowerBound(uint64_t value) const noexcept {
+        const uint64_t* bases = bases_.begin();
+        // Первый блок с базой не меньше value; ответ — в предыдущем блоке или в начале этого
+        const size_t next = static_cast<size_t>(std::lower_bound(bases, bases + bases_.Size(), value) - bases);
+        if (next > 0) {
+            const size_t block = next - 1;
+            const uint64_t target = value - bases_[block];
+            size_t low = 1;
+            size_t high = BLOCK;
+            while (low < high) {
+                const size_t middle = (low + high) / 2;
+                if (ReadOffset(block, middle) < target) {
+                    low = middle + 1;
+                }
+                else {
+                    high = middle;
+                }
+            }
+            if (low < BLOCK) {
+                return block * BLOCK + low;
+            }
+        }
+        if (next < blocks_.Size()) {
+            return next * BLOCK;
+        }
+        return blocks_.Size() * BLOCK
+            + static_cast<size_t>(std::lower_bound(tail_.begin(), tail_.end(), value) - tail_.begin());
+    }
+
+    bool Contains(uint64_t value) const noexcept {
+        const size_t index = LowerBound(value);
+        return index < Size() && Get(index) == value;
+    }
+
+    //  Распаковывает BLOCK значений блока block в out
+    void DecodeBlock(size_t block, uint64_t* out) const noexcept {
+        assert(block < blocks_.Size());
+        const Block& header = blocks_[block];
+        const uint64_t base = bases_[block];
+        const uint64_t* words = words_.begin() + header.word_offset;
+        if (header.bits <= MAX_PACKED_BIT_WIDTH) {
+            uint32_t offsets[BLOCK];
+            PackedKernels::Active().unpack(words, header.bits, 0, BLOCK, offsets);
+            for (size_t i = 0; i < BLOCK; ++i) {
+                out[i] = base + offsets[i];
+            }
+        }
+        else {
+            for (size_t i = 0; i < BLOCK; ++i) {
+                out[i] = base + ReadOffset(block, i);
+            }
+        }
+    }
+
+    //  Вызывает visit(values, count) для каждого распакованного блока и для несжатого хвоста
+    template <typename Visit>
+    void ForEachBlock(Visit&& visit) const {
+        uint64_t values[BLOCK];
+        for (size_t block = 0; block < blocks_.Size(); ++block) {
+            DecodeBlock(block, values);
+            visit(static_cast<const uint64_t*>(values), BLOCK);
+        }
+        if (tail_.Size() != 0) {
+            visit(tail_.begin(), tail_.Size());
+        }
+    }
+
+    Vector<uint64_t> ToVector() const {
+        Vector<uint64_t> result;
+        result.Reserve(Size());
+        uint64_t* out = result.SpareBegin();
+        for (size_t block = 0; block < blocks_.Size(); ++block) {
+            DecodeBlock(block, out + block * BLOCK);
+        }
+        std::copy(tail_.begin(), tail_.end(), out + blocks_.Size() * BLOCK);
+        result.CommitSpare(Size());
+        return result;
+    }
+
+    void Clear() noexcept {
+        words_.Clear();
+        blocks_.Clear();
+        bases_.Clear();
+        tail_.Clear();
+    }
+
+private:
+    struct Block {
+        uint64_t word_offset;
+        uint32_t bits;
+    };
+
+    //  Упакованные смещения всех блоков и одно нулевое слово за ними
+    Vector<uint64_t> words_;
+    Vector<Block> blocks_;
+    Vector<uint64_t> bases_;
+    Vector<uint64_t> tail_;
+
+    //  Смещение значения index от базы блока block
+    uint64_t ReadOffset(size_t block, size_t index) const noexcept {
+        const Block& header = blocks_[block];
+        const uint64_t* words = words_.begin() + header.word_offset;
+        const uint64_t bit = uint64_t{ index } * header.bits;
+        const size_t word = static_cast<size_t>(bit / 64);
+        const unsigned offset = static_cast<unsigned>(bit % 64);
+        const uint64_t value = (words[word] >> offset) | ((words[word + 1] << 1) << (63 - offset));
+        // При ширине 64 сдвиг 2 << 63 обнуляется, и маска становится из одних единиц
+        return value & ((uint64_t{ 2 } << (header.bits - 1)) - 1);
+    }
+
+    void CompressTail() {
+        const uint64_t base = tail_[0];
+        const uint64_t range = tail_[BLOCK - 1] - base;
+        unsigned bits = 1;
+        while (bits < 64 && (range >> bits) != 0) {
+            ++bits;
+        }
+        // Слово за последним блоком нулевое и становится первым словом нового блока
+        const size_t word_offset = words_.Size() == 0 ? 0 : words_.Size() - 1;
+        const size_t block_words = (BLOCK * bits + 63) / 64;
+        // Vector::Resize выделяет ровно запрошенное, поэтому вместимость удваивается явно
+        const size_t words_size = word_offset + block_words + 1;
+        if (words_size > words_.Capacity()) {
+            words_.Reserve(std::max(words_size, words_.Capacity() * 2));
+        }
+        words_.Resize(words_size);
+        uint64_t* words = words_.begin() + word_offset;
+        for (size_t i = 0; i < BLOCK; ++i) {
+            const uint64_t value = tail_[i] - base;
+            const uint64_t bit = uint64_t{ i } * bits;
+            const size_t word = static_cast<size_t>(bit / 64);
+            const unsigned offset = static_cast<unsigned>(bit % 64);
+            words[word] |= value << offset;
+            words[word + 1] |= (value >> 1) >> (63 - offset);
+        }
+        blocks_.PushBack(Block{ word_offset, bits });
+        bases_.PushBack(base);
+        tail_.Clear();
+    }
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+/*
+*   Невладеющий вид на непрерывный массив: указатель и количество элементов.
+*   Заменяет std::span, которого нет в C++17. Используется, чтобы отдать наружу
+*   столбец или буфер контейнера, например, векторному ядру, без копирования.
+*   Вид действителен, пока контейнер не перевыделит память.
+*/
+template <typename T>
+class Span {
+public:
+    using iterator = T*;
+
+    Span() = default;
+
+    Span(T* data, size_t size) noexcept
+        : data_(data)
+        , size_(size) {
+    }
+
+    //  Вид на неизменяемые элементы строится из вида на изменяемые
+    template <typename U>
+    Span(const Span<U>& other) noexcept
+        : data_(other.Data())
+        , size_(other.Size()) {
+    }
+
+    T* Data() const noexcept {
+        return data_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
+
+    T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return data_[index];
+    }
+
+    //  Часть вида из count элементов, начиная с offset
+    Span Subspan(size_t offset, size_t count) const noexcept {
+        assert(offset <= size_ && count <= size_ - offset);
+        return Span(data_ + offset, count);
+    }
+
+    iterator begin() const noexcept {
+        return data_;
+    }
+
+    iterator end() const noexcept {
+        return data_ + size_;
+    }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
@@ -0,0 +1,635 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "cpu_features.h"
+#include "isa_dispatch.h"
+#include "vector.h"
+
+/*
+*   Кодирование целых без знака в LEB128 (varint) и целых со знаком в zigzag + LEB128.
+*
+*   Значение записывается группами по 7 бит от младших к старшим, старший бит байта означает,
+*   что за ним следует ещё байт. Значения меньше 128 занимают один байт, uint32_t — до 5 байт,
+*   uint64_t — до 10. Zigzag переводит числа со знаком, близкие к нулю, в малые числа без знака:
+*   0, -1, 1, -2, ... становятся 0, 1, 2, 3, ...
+*
+*   Append* пишут байты прямо в запасную память ByteVector (SpareBegin/CommitSpare): вместимость
+*   проверяется один раз на блок значений, а не на каждый байт, как при PushBack.
+*
+*   DecodeVarints сначала считает значения векторным ядром (их столько же, сколько байт без бита
+*   продолжения), резервирует выходной вектор один раз и декодирует ядром VarintKernels.
+*   Ядро берёт маску битов продолжения сразу для 16, 32 или 64 байт: если в ней нет единиц,
+*   все байты — однобайтовые значения и расширяются до слов векторно, иначе концы значений
+*   перебираются по нулевым битам маски без побайтовых проверок.
+*/
+
+using ByteVector = Vector<uint8_t>;
+
+inline constexpr size_t MAX_VARINT32_BYTES = 5;
+inline constexpr size_t MAX_VARINT64_BYTES = 10;
+
+//  Результат ядер декодирования для оборванной или переполняющей слово последовательности
+inline constexpr size_t VARINT_ERROR = static_cast<size_t>(-1);
+
+//  Значений, для которых Append* резервируют место за один раз
+inline constexpr size_t VARINT_ENCODE_BLOCK = 1024;
+
+constexpr uint32_t ZigZagEncode(int32_t value) noexcept {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+constexpr uint64_t ZigZagEncode(int64_t value) noexcept {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+constexpr int32_t ZigZagDecode(uint32_t value) noexcept {
+    return static_cast<int32_t>((value >> 1) ^ (0u - (value & 1)));
+}
+
+constexpr int64_t ZigZagDecode(uint64_t value) noexcept {
+    return static_cast<int64_t>((value >> 1) ^ (uint64_t{ 0 } - (value & 1)));
+}
+
+//  Число байт varint-записи value
+constexpr size_t VarintSize(uint64_t value) noexcept {
+    size_t size = 1;
+    for (; value >= 0x80; value >>= 7) {
+        ++size;
+    }
+    return size;
+}
+
+//  Записывает value в out без проверки места и возвращает указатель за последним записанным байтом
+inline uint8_t* WriteVarint(uint64_t value, uint8_t* out) noexcept {
+    for (; value >= 0x80; value >>= 7) {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+/*
+*   Декодирует значение, начинающееся с байта pos, и сдвигает pos за него. Возвращает false,
+*   если данные оборвались или значение не помещается в Word; pos при этом не меняется.
+*/
+template <typename Word>
+inline bool DecodeVarint(const uint8_t* data, size_t size, size_t& pos, Word& value) noexcept {
+    constexpr size_t MAX_BYTES = sizeof(Word) == sizeof(uint32_t) ? MAX_VARINT32_BYTES : MAX_VARINT64_BYTES;
+    // Последний допустимый байт несёт только оставшиеся биты слова: 4 для uint32_t и 1 для uint64_t
+    constexpr uint8_t LAST_BYTE_MAX = sizeof(Word) == sizeof(uint32_t) ? 0x0F : 0x01;
+    Word result = 0;
+    for (size_t k = 0; k < MAX_BYTES && pos + k < size; ++k) {
+        const uint8_t byte = data[pos + k];
+        if (k == MAX_BYTES - 1 && byte > LAST_BYTE_MAX) {
+            return false;
+        }
+        result |= static_cast<Word>(byte & 0x7F) << (7 * k);
+        if (byte < 0x80) {
+            pos += k + 1;
+            value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+//  Значение из length байт, последний из которых без бита продолжения. false, если оно не помещается в Word
+template <typename Word>
+inline bool AssembleVarint(const uint8_t* bytes, size_t length, Word& value) noexcept {
+    constexpr size_t MAX_BYTES = sizeof(Word) == sizeof(uint32_t) ? MAX_VARINT32_BYTES : MAX_VARINT64_BYTES;
+    constexpr uint8_t LAST_BYTE_MAX = sizeof(Word) == sizeof(uint32_t) ? 0x0F : 0x01;
+    if (length > MAX_BYTES || (length == MAX_BYTES && bytes[MAX_BYTES - 1] > LAST_BYTE_MAX)) {
+        return false;
+    }
+    Word result = bytes[0] & 0x7F;
+    for (size_t k = 1; k < length; ++k) {
+        result |= static_cast<Word>(bytes[k] & 0x7F) << (7 * k);
+    }
+    value = result;
+    return true;
+}
+
+//  Склеивает 7-битные группы до восьми байт записи word (биты за последним байтом записи нулевые)
+constexpr uint64_t CompactVarint(uint64_t word) noexcept {
+    word &= 0x7F7F7F7F7F7F7F7FULL;
+    word = ((word & 0x7F007F007F007F00ULL) >> 1) | (word & 0x007F007F007F007FULL);
+    word = ((word & 0x3FFF00003FFF0000ULL) >> 2) | (word & 0x00003FFF00003FFFULL);
+    return ((word & 0x0FFFFFFF00000000ULL) >> 4) | (word & 0x000000000FFFFFFFULL);
+}
+
+/* СКАЛЯРНОЕ ЯДРО */
+
+struct ScalarVarint {
+    //  Число байт без бита продолжения, то есть число значений в корректных данных
+    static size_t Count(const uint8_t* data, size_t size) noexcept {
+        constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+        size_t count = 0;
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            count += sizeof(uint64_t) - static_cast<size_t>(PopCount64(word & HIGH_BITS));
+        }
+        for (; i < size; ++i) {
+            count += data[i] < 0x80 ? 1 : 0;
+        }
+        return count;
+    }
+
+    /*
+    *   Декодирует все значения data в out и возвращает их число либо VARINT_ERROR.
+    *   Значение пишется в out только после успешного разбора: для оборванных данных
+    *   место под него не выделено, а out может быть nullptr.
+    */
+    template <typename Word>
+    static size_t Decode(const uint8_t* data, size_t size, Word* out) noexcept {
+        size_t pos = 0;
+        size_t count = 0;
+        while (pos < size) {
+            Word value = 0;
+            if (!DecodeVarint(data, size, pos, value)) {
+                return VARINT_ERROR;
+            }
+            out[count++] = value;
+        }
+        return count;
+    }
+};
+
+/*
+*   Разбор окна из восьми байт по его маске битов продолжения mask: сколько значений длиной
+*   один-два байта идут подряд с начала окна (count) и сколько байт они занимают (bytes).
+*   shuffle раскладывает байты значения j в 16-битную дорожку j: младший байт в младшую половину,
+*   второй байт (если он есть) — в старшую. count равен нулю, если первое значение длиннее двух байт.
+*/
+struct VarintWindow {
+    uint8_t shuffle[16];
+    uint8_t count;
+    uint8_t bytes;
+};
+
+struct VarintWindows {
+    VarintWindow entries[256];
+};
+
+constexpr VarintWindows MakeVarintWindows() noexcept {
+    VarintWindows windows{};
+    for (unsigned mask = 0; mask < 256; ++mask) {
+        VarintWindow& window = windows.entries[mask];
+        for (uint8_t& lane : window.shuffle) {
+            lane = 0x80;
+        }
+        unsigned start = 0;
+        while (start < 8) {
+            const bool two_bytes = (mask >> start & 1) != 0;
+            if (two_bytes && (start + 1 == 8 || (mask >> (start + 1) & 1) != 0)) {
+                break;
+            }
+            window.shuffle[2 * window.count] = static_cast<uint8_t>(start);
+            if (two_bytes) {
+                window.shuffle[2 * window.count + 1] = static_cast<uint8_t>(start + 1);
+            }
+            ++window.count;
+            start += two_bytes ? 2 : 1;
+        }
+        window.bytes = static_cast<uint8_t>(start);
+    }
+    return windows;
+}
+
+inline constexpr VarintWindows VARINT_WINDOWS = MakeVarintWindows();
+
+#if FV_X86
+
+/*
+*   Дорожки ядер декодирования. ContinuationMask — биты продолжения WIDTH байт, Widen расширяет
+*   WIDTH байт до слов uint32_t или uint64_t, DecodeWindow декодирует значения окна из восьми байт
+*   по перестановке VarintWindow и пишет восемь слов, из которых значимы первые count.
+*/
+struct Sse42VarintLanes {
+    static constexpr size_t WIDTH = 16;
+
+    FV_TARGET("sse4.2") static uint64_t ContinuationMask(const uint8_t* bytes) noexcept {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes))));
+    }
+
+    FV_TARGET("sse4.2") static void Widen(const uint8_t* bytes, uint32_t* out) noexcept {
+        const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu8_epi32(values));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_cvtepu8_epi32(_mm_srli_si128(values, 4)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_cvtepu8_epi32(_mm_srli_si128(values, 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_cvtepu8_epi32(_mm_srli_si128(values, 12)));
+    }
+
+    FV_TARGET("sse4.2") static void Widen(const uint8_t* bytes, uint64_t* out) noexcept {
+        for (size_t i = 0; i < WIDTH; i += 2) {
+            uint16_t pair;
+            std::memcpy(&pair, bytes + i, sizeof(pair));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_cvtepu8_epi64(_mm_cvtsi32_si128(pair)));
+        }
+    }
+
+    FV_TARGET("sse4.2") static __m128i Window(const uint8_t* bytes, const uint8_t* shuffle) noexcept {
+        const __m128i lanes = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle)));
+        return _mm_or_si128(_mm_and_si128(lanes, _mm_set1_epi16(0x7F)), _mm_and_si128(_mm_srli_epi16(lanes, 1), _mm_set1_epi16(0x3F80)));
+    }
+
+    FV_TARGET("sse4.2") static void DecodeWindow(const uint8_t* bytes, const uint8_t* shuffle, uint32_t* out) noexcept {
+        const __m128i values = Window(bytes, shuffle);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu16_epi32(values));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_cvtepu16_epi32(_mm_srli_si128(values, 8)));
+    }
+
+    FV_TARGET("sse4.2") static void DecodeWindow(const uint8_t* bytes, const uint8_t* shuffle, uint64_t* out) noexcept {
+        const __m128i values = Window(bytes, shuffle);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu16_epi64(values));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2), _mm_cvtepu16_epi64(_mm_srli_si128(values, 4)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_cvtepu16_epi64(_mm_srli_si128(values, 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 6), _mm_cvtepu16_epi64(_mm_srli_si128(values, 12)));
+    }
+};
+
+struct Avx2VarintLanes {
+    static constexpr size_t WIDTH = 32;
+
+    FV_TARGET("avx2") static uint64_t ContinuationMask(const uint8_t* bytes) noexcept {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes))));
+    }
+
+    FV_TARGET("avx2") static void Widen(const uint8_t* bytes, uint32_t* out) noexcept {
+        for (size_t i = 0; i < WIDTH; i += 8) {
+            const __m128i values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_cvtepu8_epi32(values));
+        }
+    }
+
+    FV_TARGET("avx2") static void Widen(const uint8_t* bytes, uint64_t* out) noexcept {
+        for (size_t i = 0; i < WIDTH; i += 4) {
+            uint32_t quad;
+            std::memcpy(&quad, bytes + i, sizeof(quad));
+            const __m128i values = _mm_cvtsi32_si128(static_cast<int>(quad));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_cvtepu8_epi64(values));
+        }
+    }
+
+    FV_TARGET("avx2") static __m128i Window(const uint8_t* bytes, const uint8_t* shuffle) noexcept {
+        const __m128i lanes = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle)));
+        return _mm_or_si128(_mm_and_si128(lanes, _mm_set1_epi16(0x7F)), _mm_and_si128(_mm_srli_epi16(lanes, 1), _mm_set1_epi16(0x3F80)));
+    }
+
+    FV_TARGET("avx2") static void DecodeWindow(const uint8_t* bytes, const uint8_t* shuffle, uint32_t* out) noexcept {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu16_epi32(Window(bytes, shuffle)));
+    }
+
+    FV_TARGET("avx2") static void DecodeWindow(const uint8_t* bytes, const uint8_t* shuffle, uint64_t* out) noexcept {
+        const __m128i values = Window(bytes, shuffle);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu16_epi64(values));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4), _mm256_cvtepu16_epi64(_mm_srli_si128(values, 8)));
+    }
+};
+
+struct Avx512VarintLanes {
+    static constexpr size_t WIDTH = 64;
+
+    FV_TARGET(FV_AVX512) static uint64_t ContinuationMask(const uint8_t* bytes) noexcept {
+        return _mm512_movepi8_mask(_mm512_loadu_si512(bytes));
+    }
+
+    FV_TARGET(FV_AVX512) static void Widen(const uint8_t* bytes, uint32_t* out) noexcept {
+        for (size_t i = 0; i < WIDTH; i += 16) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+            _mm512_storeu_si512(out + i, _mm512_maskz_cvtepu8_epi32(0xFFFF, values));
+        }
+    }
+
+    FV_TARGET(FV_AVX512) static void Widen(const uint8_t* bytes, uint64_t* out) noexcept {
+        for (size_t i = 0; i < WIDTH; i += 8) {
+            const __m128i values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + i));
+            _mm512_storeu_si512(out + i, _mm512_maskz_cvtepu8_epi64(0xFF, values));
+        }
+    }
+
+    FV_TARGET(FV_AVX512) static __m128i Window(const uint8_t* bytes, const uint8_t* shuffle) noexcept {
+        const __m128i lanes = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle)));
+        return _mm_or_si128(_mm_and_si128(lanes, _mm_set1_epi16(0x7F)), _mm_and_si128(_mm_srli_epi16(lanes, 1), _mm_set1_epi16(0x3F80)));
+    }
+
+    FV_TARGET(FV_AVX512) static void DecodeWindow(const uint8_t* bytes, const uint8_t* shuffle, uint32_t* out) noexcept {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu16_epi32(Window(bytes, shuffle)));
+    }
+
+    FV_TARGET(FV_AVX512) static void DecodeWindow(const uint8_t* bytes, const uint8_t* shuffle, uint64_t* out) noexcept {
+        _mm512_storeu_si512(out, _mm512_maskz_cvtepu16_epi64(0xFF, Window(bytes, shuffle)));
+    }
+};
+
+/*
+*   ОБОБЩЁННЫЕ ЯДРА. Встраиваются в обёртки уровней, поэтому регистры не передаются между
+*   функциями с разными наборами инструкций (см. vector_search.h).
+*/
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+template <typename Lanes>
+FV_FORCE_INLINE size_t CountVarintsKernel(const uint8_t* data, size_t size) noexcept {
+    constexpr size_t WIDTH = Lanes::WIDTH;
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + WIDTH <= size; i += WIDTH) {
+        count += WIDTH - static_cast<size_t>(PopCount64(Lanes::ContinuationMask(data + i)));
+    }
+    return count + ScalarVarint::Count(data + i, size - i);
+}
+
+/*
+*   Каждый проход начинается на границе значения и берёт маску следующих WIDTH байт. Значения,
+*   заканчивающиеся в них, собираются по нулевым битам маски, а значение, которое продолжается
+*   за ними, начинает следующий проход. WIDTH не меньше 16, а значение не длиннее 10 байт,
+*   поэтому маска без нулей означает испорченные данные.
+*
+*   Значения длиной один-два байта декодируются окнами по восемь байт через VARINT_WINDOWS.
+*   Окно пишет восемь слов, поэтому оно применяется, только когда в проходе осталось не меньше
+*   восьми концов значений и выход заведомо вмещает эти слова. Более длинное значение
+*   собирается без ветвлений из одного чтения uint64_t (CompactVarint), поэтому за проходом
+*   должно оставаться ещё восемь байт данных.
+*/
+template <typename Lanes, typename Word>
+FV_FORCE_INLINE size_t DecodeVarintsKernel(const uint8_t* data, size_t size, Word* out) noexcept {
+    constexpr size_t WIDTH = Lanes::WIDTH;
+    constexpr size_t MAX_BYTES = sizeof(Word) == sizeof(uint32_t) ? MAX_VARINT32_BYTES : MAX_VARINT64_BYTES;
+    constexpr uint64_t ALL_ENDS = WIDTH == 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << WIDTH) - 1;
+    size_t pos = 0;
+    size_t count = 0;
+    while (pos + WIDTH + sizeof(uint64_t) <= size) {
+        const uint64_t continuation = Lanes::ContinuationMask(data + pos);
+        if (continuation == 0) {
+            Lanes::Widen(data + pos, out + count);
+            pos += WIDTH;
+            count += WIDTH;
+            continue;
+        }
+        uint64_t ends = ~continuation & ALL_ENDS;
+        if (ends == 0) {
+            return VARINT_ERROR;
+        }
+        size_t start = 0;
+        do {
+            if (start + 8 <= WIDTH && PopCount64(ends) >= 8) {
+                const VarintWindow& window = VARINT_WINDOWS.entries[(continuation >> start) & 0xFF];
+                if (window.count != 0) {
+                    Lanes::DecodeWindow(data + pos + start, window.shuffle, out + count);
+                    count += window.count;
+                    start += window.bytes;
+                    ends = start == 64 ? 0 : ends & (~uint64_t{ 0 } << start);
+                    continue;
+                }
+            }
+            const size_t end = static_cast<size_t>(CountTrailingZeros64(ends));
+            const size_t length = end - start + 1;
+            if (length <= sizeof(uint64_t)) {
+                uint64_t word;
+                std::memcpy(&word, data + pos + start, sizeof(word));
+                const uint64_t value = CompactVarint(word & (~uint64_t{ 0 } >> (64 - 8 * length)));
+                if (length > MAX_BYTES || value > static_cast<Word>(-1)) {
+                    return VARINT_ERROR;
+                }
+                out[count] = static_cast<Word>(value);
+            }
+            else if (!AssembleVarint(data + pos + start, length, out[count])) {
+                return VARINT_ERROR;
+            }
+            ++count;
+            start = end + 1;
+            ends &= ends - 1;
+        } while (ends != 0);
+        pos += start;
+    }
+    const size_t tail = ScalarVarint::Decode(data + pos, size - pos, out + count);
+    return tail == VARINT_ERROR ? VARINT_ERROR : count + tail;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+struct Sse42Varint {
+    FV_TARGET("sse4.2,popcnt") static size_t Count(const uint8_t* data, size_t size) noexcept {
+        return CountVarintsKernel<Sse42VarintLanes>(data, size);
+    }
+
+    template <typename Word>
+    FV_TARGET("sse4.2,popcnt") static size_t Decode(const uint8_t* data, size_t size, Word* out) noexcept {
+        return DecodeVarintsKernel<Sse42VarintLanes>(data, size, out);
+    }
+};
+
+struct Avx2Varint {
+    FV_TARGET("avx2,popcnt") static size_t Count(const uint8_t* data, size_t size) noexcept {
+        return CountVarintsKernel<Avx2VarintLanes>(data, size);
+    }
+
+    template <typename Word>
+    FV_TARGET("avx2,popcnt") static size_t Decode(const uint8_t* data, size_t size, Word* out) noexcept {
+        return DecodeVarintsKernel<Avx2VarintLanes>(data, size, out);
+    }
+};
+
+struct Avx512Varint {
+    FV_TARGET(FV_AVX512 ",popcnt") static size_t Count(const uint8_t* data, size_t size) noexcept {
+        return CountVarintsKernel<Avx512VarintLanes>(data, size);
+    }
+
+    template <typename Word>
+    FV_TARGET(FV_AVX512 ",popcnt") static size_t Decode(const uint8_t* data, size_t size, Word* out) noexcept {
+        return DecodeVarintsKernel<Avx512VarintLanes>(data, size, out);
+    }
+};
+
+#endif
+
+/*
+*   Таблица ядер varint. count — число значений (байт без бита продолжения), decode32 и decode64
+*   декодируют все данные в массив, в котором есть место под count слов.
+*/
+class VarintKernels {
+public:
+    using CountFn = size_t (*)(const uint8_t*, size_t);
+    using Decode32Fn = size_t (*)(const uint8_t*, size_t, uint32_t*);
+    using Decode64Fn = size_t (*)(const uint8_t*, size_t, uint64_t*);
+
+    struct Table {
+        CountFn count;
+        Decode32Fn decode32;
+        Decode64Fn decode64;
+    };
+
+    static const IsaDispatch<Table>& Dispatch() noexcept {
+        static constexpr Table SCALAR{ &ScalarVarint::Count, &ScalarVarint::Decode<uint32_t>, &ScalarVarint::Decode<uint64_t> };
+#if FV_X86
+        static constexpr Table SSE42{ &Sse42Varint::Count, &Sse42Varint::Decode<uint32_t>, &Sse42Varint::Decode<uint64_t> };
+        static constexpr Table AVX2{ &Avx2Varint::Count, &Avx2Varint::Decode<uint32_t>, &Avx2Varint::Decode<uint64_t> };
+        static constexpr Table AVX512{ &Avx512Varint::Count, &Avx512Varint::Decode<uint32_t>, &Avx512Varint::Decode<uint64_t> };
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR, &SSE42, &AVX2, &AVX512);
+#else
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR);
+#endif
+        return DISPATCH;
+    }
+
+    static const Table& Active() noexcept {
+        static const Table& table = Dispatch().Active();
+        return table;
+    }
+
+    static const Table& ForLevel(IsaLevel level) noexcept {
+        return Dispatch().ForLevel(level);
+    }
+};
+
+/*
+*   Запасная память под extra элементов за концом v. Vector::Reserve выделяет ровно запрошенное,
+*   поэтому при повторных добавлениях вместимость удваивается явно.
+*/
+template <typename T>
+T* GrowSpare(Vector<T>& v, size_t extra) {
+    const size_t required = v.Size() + extra;
+    if (required > v.Capacity()) {
+        v.Reserve(std::max(required, v.Capacity() * 2));
+    }
+    return v.SpareBegin();
+}
+
+/* КОДИРОВАНИЕ */
+
+inline void AppendVarint(ByteVector& bytes, uint64_t value) {
+    uint8_t* const begin = GrowSpare(bytes, MAX_VARINT64_BYTES);
+    bytes.CommitSpare(static_cast<size_t>(WriteVarint(value, begin) - begin));
+}
+
+inline void AppendZigZag(ByteVector& bytes, int64_t value) {
+    AppendVarint(bytes, ZigZagEncode(value));
+}
+
+//  Пишет encode(values[i]) блоками по VARINT_ENCODE_BLOCK значений с одной проверкой вместимости на блок
+template <typename Value, typename Encode>
+void AppendEncoded(ByteVector& bytes, const Value* values, size_t count, Encode encode) {
+    constexpr size_t MAX_BYTES = sizeof(Value) == sizeof(uint32_t) ? MAX_VARINT32_BYTES : MAX_VARINT64_BYTES;
+    for (size_t first = 0; first < count; first += VARINT_ENCODE_BLOCK) {
+        const size_t block = std::min(VARINT_ENCODE_BLOCK, count - first);
+        uint8_t* const begin = GrowSpare(bytes, block * MAX_BYTES);
+        uint8_t* out = begin;
+        for (size_t i = first; i < first + block; ++i) {
+            out = WriteVarint(encode(values[i]), out);
+        }
+        bytes.CommitSpare(static_cast<size_t>(out - begin));
+    }
+}
+
+inline void AppendVarints(ByteVector& bytes, const uint32_t* values, size_t count) {
+    AppendEncoded(bytes, values, count, [](uint32_t value) {
+        return value;
+    });
+}
+
+inline void AppendVarints(ByteVector& bytes, const uint64_t* values, size_t count) {
+    AppendEncoded(bytes, values, count, [](uint64_t value) {
+        return value;
+    });
+}
+
+inline void AppendZigZags(ByteVector& bytes, const int32_t* values, size_t count) {
+    AppendEncoded(bytes, values, count, [](int32_t value) {
+        return ZigZagEncode(value);
+    });
+}
+
+inline void AppendZigZags(ByteVector& bytes, const int64_t* values, size_t count) {
+    AppendEncoded(bytes, values, count, [](int64_t value) {
+        return ZigZagEncode(value);
+    });
+}
+
+/* ДЕКОДИРОВАНИЕ */
+
+//  Число значений в data: число байт без бита продолжения
+inline size_t CountVarints(const uint8_t* data, size_t size) noexcept {
+    return VarintKernels::Active().count(data, size);
+}
+
+/*
+*   Декодирует все значения data и добавляет их в конец out. Возвращает false и оставляет out
+*   без изменений, если данные оборваны посередине значения или значение не помещается в слово.
+*/
+inline bool DecodeVarints(const uint8_t* data, size_t size, Vector<uint32_t>& out) {
+    uint32_t* const spare = GrowSpare(out, CountVarints(data, size));
+    const size_t count = VarintKernels::Active().decode32(data, size, spare);
+    if (count == VARINT_ERROR) {
+        return false;
+    }
+    out.CommitSpare(count);
+    return true;
+}
+
+inline bool DecodeVarints(const uint8_t* data, size_t size, Vector<uint64_t>& out) {
+    uint64_t* const spare = GrowSpare(out, CountVarints(data, size));
+    const size_t count = VarintKernels::Active().decode64(data, size, spare);
+    if (count == VARINT_ERROR) {
+        return false;
+    }
+    out.CommitSpare(count);
+    return true;
+}
+
+//  Декодирует zigzag-значения: слова без знака декодируются на место и затем переводятся в числа со знаком
+inline bool DecodeZigZags(const uint8_t* data, size_t size, Vector<int32_t>& out) {
+    int32_t* const spare = GrowSpare(out, CountVarints(data, size));
+    uint32_t* const words = reinterpret_cast<uint32_t*>(spare);
+    const size_t count = VarintKernels::Active().decode32(data, size, words);
+    if (count == VARINT_ERROR) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        spare[i] = ZigZagDecode(words[i]);
+    }
+    out.CommitSpare(count);
+    return true;
+}
+
+inline bool DecodeZigZags(const uint8_t* data, size_t size, Vector<int64_t>& out) {
+    int64_t* const spare = GrowSpare(out, CountVarints(data, size));
+    uint64_t* const words = reinterpret_cast<uint64_t*>(spare);
+    const size_t count = VarintKernels::Active().decode64(data, size, words);
+    if (count == VARINT_ERROR) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        spare[i] = ZigZagDecode(words[i]);
+    }
+    out.CommitSpare(count);
+    return true;
+}
+
+inline bool DecodeVarints(const ByteVector& bytes, Vector<uint32_t>& out) {
+    return DecodeVarints(bytes.begin(), bytes.Size(), out);
+}
+
+inline bool DecodeVarints(const ByteVector& bytes, Vector<uint64_t>& out) {
+    return DecodeVarints(bytes.begin(), bytes.Size(), out);
+}
+
+inline bool DecodeZigZags(const ByteVector& bytes, Vector<int32_t>& out) {
+    return DecodeZigZags(bytes.begin(), bytes.Size(), out);
+}
+
+inline bool DecodeZigZags(const ByteVector& bytes, Vector<int64_t>& out) {
+    return DecodeZigZags(bytes.begin(), bytes.Size(), out);
+}
@@ -7,8 +7,21 @@
 #include <memory>
 #include <algorithm>
 
-template <typename T>
+#include "memory_kernels.h"
+#include "reclaimer.h"
+
+// Размер строки кэша, по которому выравниваются данные, разделяемые между потоками
+inline constexpr size_t CACHE_LINE_SIZE = 64;
+
+/*
+*   Сырая память под capacity элементов типа T. Alignment задаёт выравнивание буфера: по умолчанию
+*   это выравнивание T, а контейнеры, которые отдают память векторным ядрам, выравнивают её по строке кэша.
+*/
+template <typename T, size_t Alignment = alignof(T)>
 class RawMemory { 
+    static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+        "RawMemory alignment must be a power of two not less than alignof(T)");
+
 public:
     RawMemory() = default;
 
@@ -18,7 +31,7 @@ public:
     }
 
     ~RawMemory() {
-        Deallocate(buffer_);
+        Deallocate(buffer_, capacity_);
     }
 
     RawMemory(const RawMemory&) = delete;
@@ -80,22 +93,71 @@ private:
     T* buffer_ = nullptr;
     size_t capacity_ = 0;
 
+    // Выравнивание больше, чем гарантирует обычный operator new, требует выравнивающих перегрузок
+    static constexpr bool OVER_ALIGNED = Alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
     // Выделяет сырую память под n элементов и возвращает указатель на неё
     static T* Allocate(size_t n) {
-        return n != 0 ? static_cast<T*>(operator new(n * sizeof(T))) : nullptr;
+        if (n == 0) {
+            return nullptr;
+        }
+        if constexpr (OVER_ALIGNED) {
+            return static_cast<T*>(operator new(n * sizeof(T), std::align_val_t{ Alignment }));
+        }
+        else {
+            return static_cast<T*>(operator new(n * sizeof(T)));
+        }
     }
 
-    // Освобождает сырую память, выделенную ранее по адресу buf при помощи Allocate
-    static void Deallocate(T* buf) noexcept {
-        operator delete(buf);
+    /*
+    *   Освобождает сырую память под n элементов, выделенную ранее по адресу buf при помощи Allocate.
+    *   Крупные блоки при включённом BackgroundReclaimer освобождаются в фоновом потоке.
+    */
+    static void Deallocate(T* buf, size_t n) noexcept {
+        if (BackgroundReclaimer::TryRetire(buf, n * sizeof(T), Alignment)) {
+            return;
+        }
+        if constexpr (OVER_ALIGNED) {
+            operator delete(buf, std::align_val_t{ Alignment });
+        }
+        else {
+            operator delete(buf);
+        }
     }
 };
 
+/*
+*   Политика уменьшения вместимости вектора.
+*   Never — вместимость никогда не уменьшается автоматически (поведение по умолчанию).
+*   Hysteresis — после удаления элементов, если размер стал меньше четверти вместимости,
+*   буфер перевыделяется под удвоенный размер. Зазор между порогами роста и уменьшения
+*   не даёт вектору перевыделять память на каждом чередовании вставки и удаления.
+*/
+enum class ShrinkPolicy {
+    Never,
+    Hysteresis
+};
+
+/*
+*   Политика переноса элементов при перевыделении буфера (рост, Reserve, ShrinkToFit).
+*   Cached — элементы перемещаются или копируются обычными записями (поведение по умолчанию).
+*   Streaming — тривиально копируемые элементы объёмом больше NonTemporalThreshold() копируются
+*   потоковыми записями мимо кэша. Перенос сотен мегабайт тогда не вытесняет из кэша последнего
+*   уровня рабочий набор остальной программы, но сам может быть медленнее: новый буфер ещё
+*   не отображён в память, и ядро ОС всё равно обнуляет его страницы через кэш.
+*/
+enum class RelocationPolicy {
+    Cached,
+    Streaming
+};
+
 template <typename T>
 class Vector {
 private:
     RawMemory<T> data_;
     size_t size_ = 0;
+    ShrinkPolicy shrink_policy_ = ShrinkPolicy::Never;
+    RelocationPolicy relocation_policy_ = RelocationPolicy::Cached;
 
 public:
     Vector() = default;
@@ -113,6 +175,18 @@ public:
         std::uninitialized_value_construct_n(data_.GetAddress(), size);
     }
 
+    /*
+    *   Конструктор, создающий size копий value за один проход по памяти, без предварительного
+    *   конструирования значений по умолчанию. Тривиально копируемые типы размером 1, 2, 4 и 8 байт
+    *   заполняются векторными ядрами.
+    */
+    Vector(size_t size, const T& value)
+        : data_(size)
+        , size_(size)  //
+    {
+        UninitializedFill(data_.GetAddress(), size, value);
+    }
+
     /*
     *   Чтобы создать копию контейнера Vector, выделим память под нужное количество элементов,
     *   а затем сконструируем в ней копию элементов оригинального контейнера,
@@ -123,7 +197,9 @@ public:
     */
     Vector(const Vector& other)
         : data_(other.size_)
-        , size_(other.size_)  //
+        , size_(other.size_)
+        , shrink_policy_(other.shrink_policy_)
+        , relocation_policy_(other.relocation_policy_)  //
     {
         std::uninitialized_copy_n(other.data_.GetAddress(), other.size_, data_.GetAddress());
     }
@@ -136,10 +212,13 @@ public:
     /*
     *   Оператор копирующего присваивания.
     *   Выполняется за O(N), где N — максимум из размеров векторов, участвующих в операции.
+    *   Присваивание, как и Assign, копирует элементы, а политики уменьшения вместимости и переноса остаются своими.
     */
     Vector& operator=(const Vector& rhs) {
         if (rhs.size_ > data_.Capacity()) {
             Vector<T> tmp(rhs);
+            tmp.shrink_policy_ = shrink_policy_;
+            tmp.relocation_policy_ = relocation_policy_;
             Swap(tmp);
         }
         else {
@@ -151,9 +230,7 @@ public:
                 );
                 std::copy(rhs.data_.GetAddress(), rhs.data_.GetAddress() + size_, data_.GetAddress());
             }
-
-            if (size_ > rhs.size_) {
-                
+            else {
                 std::destroy_n(
                     data_.GetAddress() + rhs.size_,
                     size_ - rhs.size_
@@ -165,9 +242,13 @@ public:
         return *this;
     }
 
-    /*  Оператор перемещающего присваивания. Выполняется за O(1) и не выбрасывает исключений. */
+    /*
+    *   Оператор перемещающего присваивания. Выполняется за O(1) и не выбрасывает исключений.
+    *   Обмениваются только элементы: политики, как и при копирующем присваивании, остаются своими.
+    */
     Vector& operator=(Vector&& rhs) noexcept {
-        Swap(rhs);
+        data_.Swap(rhs.data_);
+        std::swap(size_, rhs.size_);
         return *this;
     }
 
@@ -178,6 +259,8 @@ public:
     void Swap(Vector& other) noexcept {
         data_.Swap(other.data_);
         std::swap(size_, other.size_);
+        std::swap(shrink_policy_, other.shrink_policy_);
+        std::swap(relocation_policy_, other.relocation_policy_);
     }
 
     /*
@@ -192,21 +275,76 @@ public:
             return;
         }
 
-        RawMemory<T> new_data(new_capacity);
+        Reallocate(new_capacity);
+    }
 
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            // Конструируем элементы в new_data, перемещая их из data_
-            std::uninitialized_move_n(data_.GetAddress(), size_, new_data.GetAddress());
+    /*
+    *   Метод Assign заменяет содержимое вектора count копиями value.
+    *   Память перевыделяется, только если count превышает вместимость.
+    *   value может ссылаться на элемент самого вектора.
+    */
+    void Assign(size_t count, const T& value) {
+        if (count > data_.Capacity()) {
+            Vector tmp(count, value);
+            tmp.shrink_policy_ = shrink_policy_;
+            tmp.relocation_policy_ = relocation_policy_;
+            Swap(tmp);
+            return;
+        }
+        if constexpr (IS_PATTERN_FILLABLE<T>) {
+            // Тривиально копируемые элементы не нужно разрушать: вся память заполняется заново,
+            // большие объёмы — потоковыми записями мимо кэша
+            OverwriteFill(data_.GetAddress(), count, value);
         }
         else {
-            // Конструируем элементы в new_data, копируя их из data_
-            std::uninitialized_copy_n(data_.GetAddress(), size_, new_data.GetAddress());
+            std::fill_n(data_.GetAddress(), std::min(size_, count), value);
+            if (count > size_) {
+                std::uninitialized_fill_n(data_ + size_, count - size_, value);
+            }
+            else {
+                std::destroy_n(data_ + count, size_ - count);
+            }
         }
-        // Разрушаем элементы в data_
+        size_ = count;
+        MaybeShrink();
+    }
+
+    /*
+    *   Метод ShrinkToFit уменьшает вместимость вектора до его размера,
+    *   перемещая элементы в новый буфер так же, как это делает Reserve.
+    *   Алгоритмическая сложность: O(размер вектора).
+    */
+    void ShrinkToFit() {
+        if (data_.Capacity() > size_) {
+            Reallocate(size_);
+        }
+    }
+
+    /*
+    *   Метод Clear разрушает все элементы вектора. Вместимость сохраняется,
+    *   если только политика уменьшения вместимости не требует обратного.
+    */
+    void Clear() noexcept {
         std::destroy_n(data_.GetAddress(), size_);
-        // Избавляемся от старой сырой памяти, обменивая её на новую
-        data_.Swap(new_data);
-        // При выходе из метода старая память будет возвращена в кучу
+        size_ = 0;
+        MaybeShrink();
+    }
+
+    void SetShrinkPolicy(ShrinkPolicy policy) noexcept {
+        shrink_policy_ = policy;
+        MaybeShrink();
+    }
+
+    ShrinkPolicy GetShrinkPolicy() const noexcept {
+        return shrink_policy_;
+    }
+
+    void SetRelocationPolicy(RelocationPolicy policy) noexcept {
+        relocation_policy_ = policy;
+    }
+
+    RelocationPolicy GetRelocationPolicy() const noexcept {
+        return relocation_policy_;
     }
 
     /*  Для корректного разрушения контейнера Vector нужно сначала вызвать DestroyN,
@@ -255,6 +393,7 @@ public:
             std::destroy_n(data_ + new_size, size_ - new_size);
         }
         size_ = new_size;
+        MaybeShrink();
     }
 
     /*
@@ -273,6 +412,7 @@ public:
     void PopBack() noexcept {
         std::destroy_at(data_ + size_ - 1);
         --size_;
+        MaybeShrink();
     }
 
     /*
@@ -293,14 +433,7 @@ public:
         else {           
             RawMemory<T> new_data(Size() == 0 ? 1 : Size() * 2);
             auto tmp = new (new_data.GetAddress() + Size()) T(std::forward<Args>(args)...);
-            if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-                // Конструируем элементы в new_data, перемещая их из data_
-                std::uninitialized_move_n(data_.GetAddress(), Size(), new_data.GetAddress());
-            }
-            else {
-                // Конструируем элементы в new_data, копируя их из data_
-                std::uninitialized_copy_n(data_.GetAddress(), Size(), new_data.GetAddress());
-            }
+            RelocateN(data_.GetAddress(), Size(), new_data.GetAddress());
             std::destroy_n(data_.GetAddress(), Size());
             data_.Swap(new_data);
             ++size_;
@@ -308,6 +441,21 @@ public:
         }
     }
 
+    /*
+    *   Метод SpareBegin возвращает указатель на неинициализированную память сразу за последним элементом.
+    *   В ней можно сконструировать до Capacity() - Size() элементов и затем присоединить их
+    *   к вектору методом CommitSpare, минуя проверку вместимости на каждом EmplaceBack.
+    */
+    T* SpareBegin() noexcept {
+        return data_ + size_;
+    }
+
+    //  Метод CommitSpare делает частью вектора n элементов, сконструированных в запасной памяти
+    void CommitSpare(size_t n) noexcept {
+        assert(size_ + n <= data_.Capacity());
+        size_ += n;
+    }
+
     /* ИТЕРАТОРЫ */
 
     using iterator = T*;
@@ -365,7 +513,68 @@ public:
         std::destroy_at(end() - 1);
 
         --size_;
-        return position_elemet;
+        return ShrinkAndRelocate(position_elemet);
+    }
+
+    /*
+    *   Метод EraseUnordered удаляет элемент за O(1), не сохраняя порядок элементов:
+    *   на место удаляемого перемещается последний элемент вектора, после чего разрушается хвост.
+    *   Возвращает итератор на элемент, занявший позицию pos (или end(), если удалялся последний).
+    */
+    iterator EraseUnordered(const_iterator pos) {
+        if (pos == end()) {
+            return end();
+        }
+
+        auto position_elemet = begin() + (pos - cbegin());
+
+        if (position_elemet != end() - 1) {
+            *position_elemet = std::move(*(end() - 1));
+        }
+
+        std::destroy_at(end() - 1);
+
+        --size_;
+        return ShrinkAndRelocate(position_elemet);
+    }
+
+    /*
+    *   Пакетный вариант EraseUnordered. Принимает отсортированный по возрастанию диапазон
+    *   уникальных индексов и за один проход заполняет «дыры» элементами с конца вектора,
+    *   пропуская те из них, которые сами подлежат удалению. Затем разрушает освободившийся хвост.
+    *   Алгоритмическая сложность: O(количество удаляемых элементов).
+    */
+    template <typename RandomIt>
+    void EraseUnordered(RandomIt first, RandomIt last) {
+        const size_t count = static_cast<size_t>(last - first);
+        assert(count <= size_);
+        assert(std::is_sorted(first, last));
+        assert(std::adjacent_find(first, last) == last);
+
+        // Граница живой части вектора: элементы в [tail, size_) уже удалены или перемещены
+        size_t tail = size_;
+        // Индексы в [back, count) относятся к хвосту и уже отброшены
+        size_t back = count;
+
+        for (size_t i = 0; i < count; ++i) {
+            const size_t hole = static_cast<size_t>(first[i]);
+            assert(hole < size_);
+
+            // Удаляемые элементы в самом конце не нужно никуда перемещать
+            while (back > i && static_cast<size_t>(first[back - 1]) == tail - 1) {
+                --back;
+                --tail;
+            }
+            if (hole >= tail) {
+                break;
+            }
+            --tail;
+            data_[hole] = std::move(data_[tail]);
+        }
+
+        std::destroy_n(data_ + (size_ - count), count);
+        size_ -= count;
+        MaybeShrink();
     }
 
     //  Метод Insert вставляет элемент в заданную позицию вектора
@@ -380,6 +589,63 @@ public:
     }
 
 private:
+    /*
+    *   Перевыделяет буфер под new_capacity элементов (не меньше размера вектора),
+    *   перемещая или копируя в него существующие элементы.
+    */
+    void Reallocate(size_t new_capacity) {
+        assert(new_capacity >= size_);
+
+        RawMemory<T> new_data(new_capacity);
+
+        // Конструируем элементы в new_data, перемещая или копируя их из data_
+        RelocateN(data_.GetAddress(), size_, new_data.GetAddress());
+        // Разрушаем элементы в data_
+        std::destroy_n(data_.GetAddress(), size_);
+        // Избавляемся от старой сырой памяти, обменивая её на новую
+        data_.Swap(new_data);
+        // При выходе из метода старая память будет возвращена в кучу
+    }
+
+    /*
+    *   Конструирует в сырой памяти dst count элементов из src: перемещает их, если перемещение
+    *   не выбрасывает исключений, иначе копирует. При политике RelocationPolicy::Streaming
+    *   большие массивы тривиально копируемых элементов копируются потоковыми записями.
+    */
+    void RelocateN(T* src, size_t count, T* dst) const {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (relocation_policy_ == RelocationPolicy::Streaming && count * sizeof(T) >= NonTemporalThreshold()) {
+                StreamCopy(dst, src, count * sizeof(T));
+                return;
+            }
+        }
+        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+            std::uninitialized_move_n(src, count, dst);
+        }
+        else {
+            std::uninitialized_copy_n(src, count, dst);
+        }
+    }
+
+    // Уменьшает вместимость, если этого требует политика. Ошибки перевыделения не критичны и игнорируются
+    void MaybeShrink() noexcept {
+        if (shrink_policy_ != ShrinkPolicy::Hysteresis || size_ >= data_.Capacity() / 4) {
+            return;
+        }
+        try {
+            Reallocate(size_ * 2);
+        }
+        catch (...) {
+        }
+    }
+
+    // Применяет политику уменьшения вместимости и пересчитывает итератор pos для нового буфера
+    iterator ShrinkAndRelocate(iterator pos) noexcept {
+        const size_t offset = pos - begin();
+        MaybeShrink();
+        return begin() + offset;
+    }
+
     // Вызывает деструкторы n объектов массива по адресу buf
     static void DestroyN(T* buf, size_t n) noexcept {
         for (size_t i = 0; i != n; ++i) {
@@ -431,7 +697,7 @@ private:
 
         if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
             // Конструируем элементы в new_data, перемещая их из data_
-            std::uninitialized_move_n(data_.GetAddress(), offset, new_data.GetAddress());
+            RelocateN(data_.GetAddress(), offset, new_data.GetAddress());
         }
         else {
             //убрал копирование, терминал не пропускает такое решение
@@ -453,7 +719,7 @@ private:
         if (size_ > offset) {
             if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
                 // Конструируем элементы в new_data, перемещая их из data_
-                std::uninitialized_move_n(
+                RelocateN(
                     data_.GetAddress() + offset,
                     size_ - offset,
                     new_data.GetAddress() + offset + 1);
@@ -0,0 +1,873 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "cpu_features.h"
+#include "isa_dispatch.h"
+#include "vector.h"
+#include "vector_search.h"
+
+/*
+*   Векторные свёртки Vector: Sum, Min, Max, ArgMin, ArgMax и Dot.
+*
+*   Ядра ведут по четыре независимых аккумулятора, чтобы задержка сложения (4 такта и больше)
+*   не ограничивала пропускную способность, и сворачивают их только в конце.
+*   Векторные ядра есть для int32_t, float и double на уровнях SSE4.2, AVX2 (с FMA) и AVX-512;
+*   остальные арифметические типы используют скалярные ядра с теми же четырьмя аккумуляторами.
+*
+*   Сумма целых накапливается в 64 битах (SumType), поэтому сумма Vector<int32_t> не переполняется.
+*   Min и Max пропускают NaN. Для пустого вектора они возвращают нейтральный элемент:
+*   std::numeric_limits<T>::max() / lowest() для целых и ±бесконечность для чисел с плавающей точкой.
+*/
+
+template <typename T>
+using SumType = std::conditional_t<std::is_floating_point_v<T>, T,
+    std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>;
+
+/*
+*   Режим суммирования чисел с плавающей точкой.
+*   Fast — векторное суммирование в несколько аккумуляторов. Порядок сложения зависит
+*   от уровня ядер, поэтому результат на разных процессорах может отличаться в младших битах.
+*   Pairwise — попарное суммирование блоками: ошибка растёт как O(log n), а не O(n).
+*   Kahan — суммирование с компенсацией ошибки округления, самое точное и самое медленное.
+*   Pairwise и Kahan не зависят от уровня ядер и дают одинаковый результат на любом процессоре,
+*   если сборка не разрешает компилятору переставлять операции (-ffast-math).
+*   Для целых типов режим не влияет на результат.
+*/
+enum class SumMode {
+    Fast,
+    Pairwise,
+    Kahan
+};
+
+template <typename T>
+constexpr T MinIdentity() noexcept {
+    if constexpr (std::numeric_limits<T>::has_infinity) {
+        return std::numeric_limits<T>::infinity();
+    }
+    else {
+        return std::numeric_limits<T>::max();
+    }
+}
+
+template <typename T>
+constexpr T MaxIdentity() noexcept {
+    if constexpr (std::numeric_limits<T>::has_infinity) {
+        return -std::numeric_limits<T>::infinity();
+    }
+    else {
+        return std::numeric_limits<T>::lowest();
+    }
+}
+
+struct ScalarReduce {
+    template <typename T>
+    static SumType<T> Sum(const T* data, size_t size) noexcept {
+        SumType<T> acc[4] = {};
+        size_t i = 0;
+        for (; i + 4 <= size; i += 4) {
+            for (size_t k = 0; k < 4; ++k) {
+                acc[k] += data[i + k];
+            }
+        }
+        for (; i < size; ++i) {
+            acc[0] += data[i];
+        }
+        return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }
+
+    // Сравнение x < best ложно для NaN, поэтому NaN пропускаются
+    template <typename T>
+    static T Min(const T* data, size_t size) noexcept {
+        T best = MinIdentity<T>();
+        for (size_t i = 0; i < size; ++i) {
+            best = data[i] < best ? data[i] : best;
+        }
+        return best;
+    }
+
+    template <typename T>
+    static T Max(const T* data, size_t size) noexcept {
+        T best = MaxIdentity<T>();
+        for (size_t i = 0; i < size; ++i) {
+            best = data[i] > best ? data[i] : best;
+        }
+        return best;
+    }
+
+    template <typename T>
+    static SumType<T> Dot(const T* lhs, const T* rhs, size_t size) noexcept {
+        SumType<T> acc[4] = {};
+        size_t i = 0;
+        for (; i + 4 <= size; i += 4) {
+            for (size_t k = 0; k < 4; ++k) {
+                acc[k] += static_cast<SumType<T>>(lhs[i + k]) * rhs[i + k];
+            }
+        }
+        for (; i < size; ++i) {
+            acc[0] += static_cast<SumType<T>>(lhs[i]) * rhs[i];
+        }
+        return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }
+
+    //  Блоки до PAIRWISE_BLOCK элементов складываются последовательно, блоки между собой — попарно
+    template <typename T>
+    static T PairwiseSum(const T* data, size_t size) noexcept {
+        constexpr size_t PAIRWISE_BLOCK = 128;
+        if (size <= PAIRWISE_BLOCK) {
+            T sum = T();
+            for (size_t i = 0; i < size; ++i) {
+                sum += data[i];
+            }
+            return sum;
+        }
+        const size_t half = (size / 2 + PAIRWISE_BLOCK - 1) / PAIRWISE_BLOCK * PAIRWISE_BLOCK;
+        return PairwiseSum(data, half) + PairwiseSum(data + half, size - half);
+    }
+
+    template <typename T>
+    static T KahanSum(const T* data, size_t size) noexcept {
+        T sum = T();
+        T compensation = T();
+        for (size_t i = 0; i < size; ++i) {
+            // compensation хранит младшие биты, потерянные на предыдущем сложении, и возвращает их в сумму
+            const T value = data[i] - compensation;
+            const T next = sum + value;
+            compensation = (next - sum) - value;
+            sum = next;
+        }
+        return sum;
+    }
+};
+
+#if FV_X86
+
+/*
+*   Регистры одного уровня для свёрток. Сумма int32 расширяется до int64 прямо при загрузке:
+*   половина регистра int32 превращается в полный регистр int64, поэтому аккумулятор
+*   суммы int32 состоит из двух регистров (SumAccumulator).
+*   Min и Max вызываются как Min(data, acc): при NaN в data инструкции возвращают второй операнд.
+*   Horizontal* сворачивают регистр через массив в фиксированном порядке.
+*/
+template <typename T>
+struct Sse42ReduceLanes;
+
+template <>
+struct Sse42ReduceLanes<float> {
+    using Register = __m128;
+    using SumAccumulator = __m128;
+    static constexpr size_t LANES = 4;
+
+    FV_TARGET("sse4.2") static Register Broadcast(float value) noexcept {
+        return _mm_set1_ps(value);
+    }
+
+    FV_TARGET("sse4.2") static Register Load(const float* data) noexcept {
+        return _mm_loadu_ps(data);
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator SumZero() noexcept {
+        return _mm_setzero_ps();
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator SumAdd(SumAccumulator acc, const float* data) noexcept {
+        return _mm_add_ps(acc, Load(data));
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator SumMerge(SumAccumulator lhs, SumAccumulator rhs) noexcept {
+        return _mm_add_ps(lhs, rhs);
+    }
+
+    FV_TARGET("sse4.2") static float HorizontalSum(SumAccumulator acc) noexcept {
+        alignas(16) float lanes[LANES];
+        _mm_store_ps(lanes, acc);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    FV_TARGET("sse4.2") static Register Min(Register data, Register acc) noexcept {
+        return _mm_min_ps(data, acc);
+    }
+
+    FV_TARGET("sse4.2") static Register Max(Register data, Register acc) noexcept {
+        return _mm_max_ps(data, acc);
+    }
+
+    FV_TARGET("sse4.2") static void Store(float* lanes, Register value) noexcept {
+        _mm_storeu_ps(lanes, value);
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator MulAdd(const float* lhs, const float* rhs, SumAccumulator acc) noexcept {
+        return _mm_add_ps(_mm_mul_ps(Load(lhs), Load(rhs)), acc);
+    }
+};
+
+template <>
+struct Sse42ReduceLanes<double> {
+    using Register = __m128d;
+    using SumAccumulator = __m128d;
+    static constexpr size_t LANES = 2;
+
+    FV_TARGET("sse4.2") static Register Broadcast(double value) noexcept {
+        return _mm_set1_pd(value);
+    }
+
+    FV_TARGET("sse4.2") static Register Load(const double* data) noexcept {
+        return _mm_loadu_pd(data);
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator SumZero() noexcept {
+        return _mm_setzero_pd();
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator SumAdd(SumAccumulator acc, const double* data) noexcept {
+        return _mm_add_pd(acc, Load(data));
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator SumMerge(SumAccumulator lhs, SumAccumulator rhs) noexcept {
+        return _mm_add_pd(lhs, rhs);
+    }
+
+    FV_TARGET("sse4.2") static double HorizontalSum(SumAccumulator acc) noexcept {
+        alignas(16) double lanes[LANES];
+        _mm_store_pd(lanes, acc);
+        return lanes[0] + lanes[1];
+    }
+
+    FV_TARGET("sse4.2") static Register Min(Register data, Register acc) noexcept {
+        return _mm_min_pd(data, acc);
+    }
+
+    FV_TARGET("sse4.2") static Register Max(Register data, Register acc) noexcept {
+        return _mm_max_pd(data, acc);
+    }
+
+    FV_TARGET("sse4.2") static void Store(double* lanes, Register value) noexcept {
+        _mm_storeu_pd(lanes, value);
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator MulAdd(const double* lhs, const double* rhs, SumAccumulator acc) noexcept {
+        return _mm_add_pd(_mm_mul_pd(Load(lhs), Load(rhs)), acc);
+    }
+};
+
+template <>
+struct Sse42ReduceLanes<int32_t> {
+    using Register = __m128i;
+    static constexpr size_t LANES = 4;
+
+    struct SumAccumulator {
+        __m128i low;
+        __m128i high;
+    };
+
+    FV_TARGET("sse4.2") static Register Broadcast(int32_t value) noexcept {
+        return _mm_set1_epi32(value);
+    }
+
+    FV_TARGET("sse4.2") static Register Load(const int32_t* data) noexcept {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator SumZero() noexcept {
+        return { _mm_setzero_si128(), _mm_setzero_si128() };
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator SumAdd(SumAccumulator acc, const int32_t* data) noexcept {
+        const __m128i low = _mm_cvtepi32_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)));
+        const __m128i high = _mm_cvtepi32_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + 2)));
+        return { _mm_add_epi64(acc.low, low), _mm_add_epi64(acc.high, high) };
+    }
+
+    FV_TARGET("sse4.2") static SumAccumulator SumMerge(SumAccumulator lhs, SumAccumulator rhs) noexcept {
+        return { _mm_add_epi64(lhs.low, rhs.low), _mm_add_epi64(lhs.high, rhs.high) };
+    }
+
+    FV_TARGET("sse4.2") static int64_t HorizontalSum(SumAccumulator acc) noexcept {
+        alignas(16) int64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(acc.low, acc.high));
+        return lanes[0] + lanes[1];
+    }
+
+    FV_TARGET("sse4.2") static Register Min(Register data, Register acc) noexcept {
+        return _mm_min_epi32(data, acc);
+    }
+
+    FV_TARGET("sse4.2") static Register Max(Register data, Register acc) noexcept {
+        return _mm_max_epi32(data, acc);
+    }
+
+    FV_TARGET("sse4.2") static void Store(int32_t* lanes, Register value) noexcept {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), value);
+    }
+};
+
+template <typename T>
+struct Avx2ReduceLanes;
+
+template <>
+struct Avx2ReduceLanes<float> {
+    using Register = __m256;
+    using SumAccumulator = __m256;
+    static constexpr size_t LANES = 8;
+
+    FV_TARGET("avx2,fma") static Register Broadcast(float value) noexcept {
+        return _mm256_set1_ps(value);
+    }
+
+    FV_TARGET("avx2,fma") static Register Load(const float* data) noexcept {
+        return _mm256_loadu_ps(data);
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator SumZero() noexcept {
+        return _mm256_setzero_ps();
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator SumAdd(SumAccumulator acc, const float* data) noexcept {
+        return _mm256_add_ps(acc, Load(data));
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator SumMerge(SumAccumulator lhs, SumAccumulator rhs) noexcept {
+        return _mm256_add_ps(lhs, rhs);
+    }
+
+    FV_TARGET("avx2,fma") static float HorizontalSum(SumAccumulator acc) noexcept {
+        alignas(32) float lanes[LANES];
+        _mm256_store_ps(lanes, acc);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+    FV_TARGET("avx2,fma") static Register Min(Register data, Register acc) noexcept {
+        return _mm256_min_ps(data, acc);
+    }
+
+    FV_TARGET("avx2,fma") static Register Max(Register data, Register acc) noexcept {
+        return _mm256_max_ps(data, acc);
+    }
+
+    FV_TARGET("avx2,fma") static void Store(float* lanes, Register value) noexcept {
+        _mm256_storeu_ps(lanes, value);
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator MulAdd(const float* lhs, const float* rhs, SumAccumulator acc) noexcept {
+        return _mm256_fmadd_ps(Load(lhs), Load(rhs), acc);
+    }
+};
+
+template <>
+struct Avx2ReduceLanes<double> {
+    using Register = __m256d;
+    using SumAccumulator = __m256d;
+    static constexpr size_t LANES = 4;
+
+    FV_TARGET("avx2,fma") static Register Broadcast(double value) noexcept {
+        return _mm256_set1_pd(value);
+    }
+
+    FV_TARGET("avx2,fma") static Register Load(const double* data) noexcept {
+        return _mm256_loadu_pd(data);
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator SumZero() noexcept {
+        return _mm256_setzero_pd();
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator SumAdd(SumAccumulator acc, const double* data) noexcept {
+        return _mm256_add_pd(acc, Load(data));
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator SumMerge(SumAccumulator lhs, SumAccumulator rhs) noexcept {
+        return _mm256_add_pd(lhs, rhs);
+    }
+
+    FV_TARGET("avx2,fma") static double HorizontalSum(SumAccumulator acc) noexcept {
+        alignas(32) double lanes[LANES];
+        _mm256_store_pd(lanes, acc);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    FV_TARGET("avx2,fma") static Register Min(Register data, Register acc) noexcept {
+        return _mm256_min_pd(data, acc);
+    }
+
+    FV_TARGET("avx2,fma") static Register Max(Register data, Register acc) noexcept {
+        return _mm256_max_pd(data, acc);
+    }
+
+    FV_TARGET("avx2,fma") static void Store(double* lanes, Register value) noexcept {
+        _mm256_storeu_pd(lanes, value);
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator MulAdd(const double* lhs, const double* rhs, SumAccumulator acc) noexcept {
+        return _mm256_fmadd_pd(Load(lhs), Load(rhs), acc);
+    }
+};
+
+template <>
+struct Avx2ReduceLanes<int32_t> {
+    using Register = __m256i;
+    static constexpr size_t LANES = 8;
+
+    struct SumAccumulator {
+        __m256i low;
+        __m256i high;
+    };
+
+    FV_TARGET("avx2,fma") static Register Broadcast(int32_t value) noexcept {
+        return _mm256_set1_epi32(value);
+    }
+
+    FV_TARGET("avx2,fma") static Register Load(const int32_t* data) noexcept {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator SumZero() noexcept {
+        return { _mm256_setzero_si256(), _mm256_setzero_si256() };
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator SumAdd(SumAccumulator acc, const int32_t* data) noexcept {
+        const __m256i low = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+        const __m256i high = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 4)));
+        return { _mm256_add_epi64(acc.low, low), _mm256_add_epi64(acc.high, high) };
+    }
+
+    FV_TARGET("avx2,fma") static SumAccumulator SumMerge(SumAccumulator lhs, SumAccumulator rhs) noexcept {
+        return { _mm256_add_epi64(lhs.low, rhs.low), _mm256_add_epi64(lhs.high, rhs.high) };
+    }
+
+    FV_TARGET("avx2,fma") static int64_t HorizontalSum(SumAccumulator acc) noexcept {
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc.low, acc.high));
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    FV_TARGET("avx2,fma") static Register Min(Register data, Register acc) noexcept {
+        return _mm256_min_epi32(data, acc);
+    }
+
+    FV_TARGET("avx2,fma") static Register Max(Register data, Register acc) noexcept {
+        return _mm256_max_epi32(data, acc);
+    }
+
+    FV_TARGET("avx2,fma") static void Store(int32_t* lanes, Register value) noexcept {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), value);
+    }
+};
+
+/*
+*   Немаскированные min, max и cvtepi32_epi64 AVX-512 в GCC 12 построены на _mm512_undefined_*,
+*   что вызывает ложное предупреждение о неинициализированной переменной. Маскированные формы
+*   с полной маской компилируются в те же инструкции.
+*/
+template <typename T>
+struct Avx512ReduceLanes;
+
+template <>
+struct Avx512ReduceLanes<float> {
+    using Register = __m512;
+    using SumAccumulator = __m512;
+    static constexpr size_t LANES = 16;
+
+    FV_TARGET(FV_AVX512) static Register Broadcast(float value) noexcept {
+        return _mm512_set1_ps(value);
+    }
+
+    FV_TARGET(FV_AVX512) static Register Load(const float* data) noexcept {
+        return _mm512_loadu_ps(data);
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator SumZero() noexcept {
+        return _mm512_setzero_ps();
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator SumAdd(SumAccumulator acc, const float* data) noexcept {
+        return _mm512_add_ps(acc, Load(data));
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator SumMerge(SumAccumulator lhs, SumAccumulator rhs) noexcept {
+        return _mm512_add_ps(lhs, rhs);
+    }
+
+    FV_TARGET(FV_AVX512) static float HorizontalSum(SumAccumulator acc) noexcept {
+        alignas(64) float lanes[LANES];
+        _mm512_store_ps(lanes, acc);
+        float sum[4] = {};
+        for (size_t i = 0; i < LANES; ++i) {
+            sum[i % 4] += lanes[i];
+        }
+        return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    }
+
+    FV_TARGET(FV_AVX512) static Register Min(Register data, Register acc) noexcept {
+        return _mm512_mask_min_ps(acc, 0xFFFF, data, acc);
+    }
+
+    FV_TARGET(FV_AVX512) static Register Max(Register data, Register acc) noexcept {
+        return _mm512_mask_max_ps(acc, 0xFFFF, data, acc);
+    }
+
+    FV_TARGET(FV_AVX512) static void Store(float* lanes, Register value) noexcept {
+        _mm512_storeu_ps(lanes, value);
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator MulAdd(const float* lhs, const float* rhs, SumAccumulator acc) noexcept {
+        return _mm512_fmadd_ps(Load(lhs), Load(rhs), acc);
+    }
+};
+
+template <>
+struct Avx512ReduceLanes<double> {
+    using Register = __m512d;
+    using SumAccumulator = __m512d;
+    static constexpr size_t LANES = 8;
+
+    FV_TARGET(FV_AVX512) static Register Broadcast(double value) noexcept {
+        return _mm512_set1_pd(value);
+    }
+
+    FV_TARGET(FV_AVX512) static Register Load(const double* data) noexcept {
+        return _mm512_loadu_pd(data);
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator SumZero() noexcept {
+        return _mm512_setzero_pd();
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator SumAdd(SumAccumulator acc, const double* data) noexcept {
+        return _mm512_add_pd(acc, Load(data));
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator SumMerge(SumAccumulator lhs, SumAccumulator rhs) noexcept {
+        return _mm512_add_pd(lhs, rhs);
+    }
+
+    FV_TARGET(FV_AVX512) static double HorizontalSum(SumAccumulator acc) noexcept {
+        alignas(64) double lanes[LANES];
+        _mm512_store_pd(lanes, acc);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+    FV_TARGET(FV_AVX512) static Register Min(Register data, Register acc) noexcept {
+        return _mm512_mask_min_pd(acc, 0xFF, data, acc);
+    }
+
+    FV_TARGET(FV_AVX512) static Register Max(Register data, Register acc) noexcept {
+        return _mm512_mask_max_pd(acc, 0xFF, data, acc);
+    }
+
+    FV_TARGET(FV_AVX512) static void Store(double* lanes, Register value) noexcept {
+        _mm512_storeu_pd(lanes, value);
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator MulAdd(const double* lhs, const double* rhs, SumAccumulator acc) noexcept {
+        return _mm512_fmadd_pd(Load(lhs), Load(rhs), acc);
+    }
+};
+
+template <>
+struct Avx512ReduceLanes<int32_t> {
+    using Register = __m512i;
+    static constexpr size_t LANES = 16;
+
+    struct SumAccumulator {
+        __m512i low;
+        __m512i high;
+    };
+
+    FV_TARGET(FV_AVX512) static Register Broadcast(int32_t value) noexcept {
+        return _mm512_set1_epi32(value);
+    }
+
+    FV_TARGET(FV_AVX512) static Register Load(const int32_t* data) noexcept {
+        return _mm512_loadu_si512(data);
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator SumZero() noexcept {
+        return { _mm512_setzero_si512(), _mm512_setzero_si512() };
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator SumAdd(SumAccumulator acc, const int32_t* data) noexcept {
+        const __m512i low = _mm512_maskz_cvtepi32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)));
+        const __m512i high = _mm512_maskz_cvtepi32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 8)));
+        return { _mm512_add_epi64(acc.low, low), _mm512_add_epi64(acc.high, high) };
+    }
+
+    FV_TARGET(FV_AVX512) static SumAccumulator SumMerge(SumAccumulator lhs, SumAccumulator rhs) noexcept {
+        return { _mm512_add_epi64(lhs.low, rhs.low), _mm512_add_epi64(lhs.high, rhs.high) };
+    }
+
+    FV_TARGET(FV_AVX512) static int64_t HorizontalSum(SumAccumulator acc) noexcept {
+        alignas(64) int64_t lanes[8];
+        _mm512_store_si512(lanes, _mm512_add_epi64(acc.low, acc.high));
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+    FV_TARGET(FV_AVX512) static Register Min(Register data, Register acc) noexcept {
+        return _mm512_mask_min_epi32(acc, 0xFFFF, data, acc);
+    }
+
+    FV_TARGET(FV_AVX512) static Register Max(Register data, Register acc) noexcept {
+        return _mm512_mask_max_epi32(acc, 0xFFFF, data, acc);
+    }
+
+    FV_TARGET(FV_AVX512) static void Store(int32_t* lanes, Register value) noexcept {
+        _mm512_storeu_si512(lanes, value);
+    }
+};
+
+/*
+*   ОБОБЩЁННЫЕ ЯДРА. Как и ядра поиска, встраиваются в обёртки с FV_TARGET,
+*   поэтому предупреждение GCC о смене ABI для регистров здесь отключено.
+*/
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+template <typename Lanes, typename T>
+FV_FORCE_INLINE SumType<T> SumKernel(const T* data, size_t size) noexcept {
+    constexpr size_t LANES = Lanes::LANES;
+    auto acc0 = Lanes::SumZero();
+    auto acc1 = Lanes::SumZero();
+    auto acc2 = Lanes::SumZero();
+    auto acc3 = Lanes::SumZero();
+    size_t i = 0;
+    for (; i + 4 * LANES <= size; i += 4 * LANES) {
+        acc0 = Lanes::SumAdd(acc0, data + i);
+        acc1 = Lanes::SumAdd(acc1, data + i + LANES);
+        acc2 = Lanes::SumAdd(acc2, data + i + 2 * LANES);
+        acc3 = Lanes::SumAdd(acc3, data + i + 3 * LANES);
+    }
+    for (; i + LANES <= size; i += LANES) {
+        acc0 = Lanes::SumAdd(acc0, data + i);
+    }
+    const auto acc = Lanes::SumMerge(Lanes::SumMerge(acc0, acc1), Lanes::SumMerge(acc2, acc3));
+    return Lanes::HorizontalSum(acc) + ScalarReduce::Sum(data + i, size - i);
+}
+
+template <typename Lanes, bool IS_MIN, typename T>
+FV_FORCE_INLINE T MinMaxKernel(const T* data, size_t size) noexcept {
+    constexpr size_t LANES = Lanes::LANES;
+    const T identity = IS_MIN ? MinIdentity<T>() : MaxIdentity<T>();
+    constexpr auto step = IS_MIN ? &Lanes::Min : &Lanes::Max;
+    auto acc0 = Lanes::Broadcast(identity);
+    auto acc1 = acc0;
+    auto acc2 = acc0;
+    auto acc3 = acc0;
+    size_t i = 0;
+    for (; i + 4 * LANES <= size; i += 4 * LANES) {
+        acc0 = step(Lanes::Load(data + i), acc0);
+        acc1 = step(Lanes::Load(data + i + LANES), acc1);
+        acc2 = step(Lanes::Load(data + i + 2 * LANES), acc2);
+        acc3 = step(Lanes::Load(data + i + 3 * LANES), acc3);
+    }
+    for (; i + LANES <= size; i += LANES) {
+        acc0 = step(Lanes::Load(data + i), acc0);
+    }
+    T lanes[LANES + 1];
+    Lanes::Store(lanes, step(step(acc0, acc1), step(acc2, acc3)));
+    lanes[LANES] = IS_MIN ? ScalarReduce::Min(data + i, size - i) : ScalarReduce::Max(data + i, size - i);
+    return IS_MIN ? ScalarReduce::Min(lanes, LANES + 1) : ScalarReduce::Max(lanes, LANES + 1);
+}
+
+template <typename Lanes, typename T>
+FV_FORCE_INLINE T DotKernel(const T* lhs, const T* rhs, size_t size) noexcept {
+    constexpr size_t LANES = Lanes::LANES;
+    auto acc0 = Lanes::SumZero();
+    auto acc1 = Lanes::SumZero();
+    auto acc2 = Lanes::SumZero();
+    auto acc3 = Lanes::SumZero();
+    size_t i = 0;
+    for (; i + 4 * LANES <= size; i += 4 * LANES) {
+        acc0 = Lanes::MulAdd(lhs + i, rhs + i, acc0);
+        acc1 = Lanes::MulAdd(lhs + i + LANES, rhs + i + LANES, acc1);
+        acc2 = Lanes::MulAdd(lhs + i + 2 * LANES, rhs + i + 2 * LANES, acc2);
+        acc3 = Lanes::MulAdd(lhs + i + 3 * LANES, rhs + i + 3 * LANES, acc3);
+    }
+    for (; i + LANES <= size; i += LANES) {
+        acc0 = Lanes::MulAdd(lhs + i, rhs + i, acc0);
+    }
+    const auto acc = Lanes::SumMerge(Lanes::SumMerge(acc0, acc1), Lanes::SumMerge(acc2, acc3));
+    return Lanes::HorizontalSum(acc) + ScalarReduce::Dot(lhs + i, rhs + i, size - i);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+struct Sse42Reduce {
+    template <typename T>
+    FV_TARGET("sse4.2") static SumType<T> Sum(const T* data, size_t size) noexcept {
+        return SumKernel<Sse42ReduceLanes<T>>(data, size);
+    }
+
+    template <typename T>
+    FV_TARGET("sse4.2") static T Min(const T* data, size_t size) noexcept {
+        return MinMaxKernel<Sse42ReduceLanes<T>, true>(data, size);
+    }
+
+    template <typename T>
+    FV_TARGET("sse4.2") static T Max(const T* data, size_t size) noexcept {
+        return MinMaxKernel<Sse42ReduceLanes<T>, false>(data, size);
+    }
+
+    template <typename T>
+    FV_TARGET("sse4.2") static SumType<T> Dot(const T* lhs, const T* rhs, size_t size) noexcept {
+        return DotKernel<Sse42ReduceLanes<T>>(lhs, rhs, size);
+    }
+};
+
+struct Avx2Reduce {
+    template <typename T>
+    FV_TARGET("avx2,fma") static SumType<T> Sum(const T* data, size_t size) noexcept {
+        return SumKernel<Avx2ReduceLanes<T>>(data, size);
+    }
+
+    template <typename T>
+    FV_TARGET("avx2,fma") static T Min(const T* data, size_t size) noexcept {
+        return MinMaxKernel<Avx2ReduceLanes<T>, true>(data, size);
+    }
+
+    template <typename T>
+    FV_TARGET("avx2,fma") static T Max(const T* data, size_t size) noexcept {
+        return MinMaxKernel<Avx2ReduceLanes<T>, false>(data, size);
+    }
+
+    template <typename T>
+    FV_TARGET("avx2,fma") static SumType<T> Dot(const T* lhs, const T* rhs, size_t size) noexcept {
+        return DotKernel<Avx2ReduceLanes<T>>(lhs, rhs, size);
+    }
+};
+
+struct Avx512Reduce {
+    template <typename T>
+    FV_TARGET(FV_AVX512) static SumType<T> Sum(const T* data, size_t size) noexcept {
+        return SumKernel<Avx512ReduceLanes<T>>(data, size);
+    }
+
+    template <typename T>
+    FV_TARGET(FV_AVX512) static T Min(const T* data, size_t size) noexcept {
+        return MinMaxKernel<Avx512ReduceLanes<T>, true>(data, size);
+    }
+
+    template <typename T>
+    FV_TARGET(FV_AVX512) static T Max(const T* data, size_t size) noexcept {
+        return MinMaxKernel<Avx512ReduceLanes<T>, false>(data, size);
+    }
+
+    template <typename T>
+    FV_TARGET(FV_AVX512) static SumType<T> Dot(const T* lhs, const T* rhs, size_t size) noexcept {
+        return DotKernel<Avx512ReduceLanes<T>>(lhs, rhs, size);
+    }
+};
+
+#endif
+
+/*
+*   Таблица ядер свёрток для типа T, устроенная так же, как SearchKernels.
+*   Скалярное произведение целых векторными ядрами не считается.
+*/
+template <typename T>
+class ReduceKernels {
+public:
+    using SumFn = SumType<T> (*)(const T*, size_t);
+    using MinMaxFn = T (*)(const T*, size_t);
+    using DotFn = SumType<T> (*)(const T*, const T*, size_t);
+
+    struct Table {
+        SumFn sum;
+        MinMaxFn min;
+        MinMaxFn max;
+        DotFn dot;
+    };
+
+    static constexpr bool HAS_SIMD = FV_X86
+        && (std::is_same_v<T, int32_t> || std::is_same_v<T, float> || std::is_same_v<T, double>);
+
+    static const IsaDispatch<Table>& Dispatch() noexcept {
+        static constexpr Table SCALAR = MakeTable<ScalarReduce>();
+#if FV_X86
+        if constexpr (HAS_SIMD) {
+            static constexpr Table SSE42 = MakeTable<Sse42Reduce>();
+            static constexpr Table AVX2 = MakeTable<Avx2Reduce>();
+            static constexpr Table AVX512 = MakeTable<Avx512Reduce>();
+            static constexpr IsaDispatch<Table> DISPATCH(&SCALAR, &SSE42, &AVX2, &AVX512);
+            return DISPATCH;
+        }
+#endif
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR);
+        return DISPATCH;
+    }
+
+    static const Table& Active() noexcept {
+        static const Table& table = Dispatch().Active();
+        return table;
+    }
+
+    static const Table& ForLevel(IsaLevel level) noexcept {
+        return Dispatch().ForLevel(level);
+    }
+
+private:
+    template <typename Isa>
+    static constexpr Table MakeTable() noexcept {
+        if constexpr (std::is_floating_point_v<T>) {
+            return Table{ &Isa::template Sum<T>, &Isa::template Min<T>, &Isa::template Max<T>, &Isa::template Dot<T> };
+        }
+        else {
+            return Table{ &Isa::template Sum<T>, &Isa::template Min<T>, &Isa::template Max<T>, &ScalarReduce::Dot<T> };
+        }
+    }
+};
+
+template <typename T>
+SumType<T> Sum(const Vector<T>& v, SumMode mode = SumMode::Fast) noexcept {
+    static_assert(std::is_arithmetic_v<T>, "Sum requires an arithmetic element type");
+    if constexpr (std::is_floating_point_v<T>) {
+        if (mode == SumMode::Pairwise) {
+            return ScalarReduce::PairwiseSum(v.begin(), v.Size());
+        }
+        if (mode == SumMode::Kahan) {
+            return ScalarReduce::KahanSum(v.begin(), v.Size());
+        }
+    }
+    (void)mode;
+    return ReduceKernels<T>::Active().sum(v.begin(), v.Size());
+}
+
+template <typename T>
+T Min(const Vector<T>& v) noexcept {
+    static_assert(std::is_arithmetic_v<T>, "Min requires an arithmetic element type");
+    return ReduceKernels<T>::Active().min(v.begin(), v.Size());
+}
+
+template <typename T>
+T Max(const Vector<T>& v) noexcept {
+    static_assert(std::is_arithmetic_v<T>, "Max requires an arithmetic element type");
+    return ReduceKernels<T>::Active().max(v.begin(), v.Size());
+}
+
+/*
+*   Индекс первого минимального элемента, либо NOT_FOUND для пустого вектора и вектора из одних NaN.
+*   Выполняется в два векторных прохода: Min, затем IndexOf найденного значения.
+*/
+template <typename T>
+size_t ArgMin(const Vector<T>& v) noexcept {
+    return IndexOf(v, Min(v));
+}
+
+template <typename T>
+size_t ArgMax(const Vector<T>& v) noexcept {
+    return IndexOf(v, Max(v));
+}
+
+//  Скалярное произведение векторов одинакового размера. Для целых накапливается в 64 битах
+template <typename T>
+SumType<T> Dot(const Vector<T>& lhs, const Vector<T>& rhs) noexcept {
+    static_assert(std::is_arithmetic_v<T>, "Dot requires an arithmetic element type");
+    assert(lhs.Size() == rhs.Size());
+    return ReduceKernels<T>::Active().dot(lhs.begin(), rhs.begin(), lhs.Size());
+}
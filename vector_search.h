@@ -0,0 +1,474 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "cpu_features.h"
+#include "isa_dispatch.h"
+#include "vector.h"
+
+/*
+*   Векторный поиск в Vector<int32_t> и Vector<float>.
+*
+*   Ядра сравнивают за одну инструкцию 4 (SSE4.2) или 8 (AVX2) элементов и обрабатывают
+*   по два регистра за итерацию. Результат сравнения сворачивается в битовую маску:
+*   её младший установленный бит даёт позицию найденного элемента, число бит — количество совпадений.
+*   Уровень ядер выбирается один раз через IsaDispatch. Для остальных арифметических типов
+*   и процессоров без SSE4.2 используются скалярные версии тех же функций.
+*
+*   Сравнение float следует встроенным операторам: NaN не равен ничему, а -0.0 равен 0.0.
+*/
+
+enum class CompareOp {
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual
+};
+
+inline constexpr size_t COMPARE_OP_COUNT = 6;
+
+// Возвращается функциями IndexOf, если элемент не найден
+inline constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+template <CompareOp OP, typename T>
+constexpr bool Satisfies(T lhs, T rhs) noexcept {
+    if constexpr (OP == CompareOp::Equal) {
+        return lhs == rhs;
+    }
+    else if constexpr (OP == CompareOp::NotEqual) {
+        return lhs != rhs;
+    }
+    else if constexpr (OP == CompareOp::Less) {
+        return lhs < rhs;
+    }
+    else if constexpr (OP == CompareOp::LessEqual) {
+        return lhs <= rhs;
+    }
+    else if constexpr (OP == CompareOp::Greater) {
+        return lhs > rhs;
+    }
+    else {
+        return lhs >= rhs;
+    }
+}
+
+/* СКАЛЯРНЫЕ ЯДРА. Возвращают size, если элемент не найден */
+
+struct ScalarSearch {
+    template <typename T, CompareOp OP>
+    static size_t FindIf(const T* data, size_t size, T value) noexcept {
+        size_t i = 0;
+        while (i < size && !Satisfies<OP>(data[i], value)) {
+            ++i;
+        }
+        return i;
+    }
+
+    template <typename T, CompareOp OP>
+    static size_t CountIf(const T* data, size_t size, T value) noexcept {
+        size_t count = 0;
+        for (size_t i = 0; i < size; ++i) {
+            count += Satisfies<OP>(data[i], value) ? 1 : 0;
+        }
+        return count;
+    }
+
+    template <typename T>
+    static size_t FindAny(const T* data, size_t size, const T* needles, size_t needle_count) noexcept {
+        for (size_t i = 0; i < size; ++i) {
+            for (size_t j = 0; j < needle_count; ++j) {
+                if (data[i] == needles[j]) {
+                    return i;
+                }
+            }
+        }
+        return size;
+    }
+};
+
+#if FV_X86
+
+/*
+*   Регистры одного уровня для одного типа элементов: Broadcast, Load и Compare<OP>,
+*   возвращающий маску дорожек, для которых выполняется data OP needle.
+*   В SSE и AVX2 для int32 есть только сравнения на равенство и «больше»,
+*   остальные получаются перестановкой операндов и инверсией маски.
+*/
+template <typename T>
+struct Sse42Lanes;
+
+template <>
+struct Sse42Lanes<int32_t> {
+    using Register = __m128i;
+    static constexpr size_t LANES = 4;
+    static constexpr uint32_t ALL = 0xF;
+
+    FV_TARGET("sse4.2") static Register Broadcast(int32_t value) noexcept {
+        return _mm_set1_epi32(value);
+    }
+
+    FV_TARGET("sse4.2") static Register Load(const int32_t* data) noexcept {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    }
+
+    template <CompareOp OP>
+    FV_TARGET("sse4.2") static uint32_t Compare(Register data, Register needle) noexcept {
+        if constexpr (OP == CompareOp::Equal || OP == CompareOp::NotEqual) {
+            const uint32_t mask = Mask(_mm_cmpeq_epi32(data, needle));
+            return OP == CompareOp::Equal ? mask : mask ^ ALL;
+        }
+        else if constexpr (OP == CompareOp::Greater || OP == CompareOp::LessEqual) {
+            const uint32_t mask = Mask(_mm_cmpgt_epi32(data, needle));
+            return OP == CompareOp::Greater ? mask : mask ^ ALL;
+        }
+        else {
+            const uint32_t mask = Mask(_mm_cmpgt_epi32(needle, data));
+            return OP == CompareOp::Less ? mask : mask ^ ALL;
+        }
+    }
+
+    FV_TARGET("sse4.2") static uint32_t Mask(Register compared) noexcept {
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(compared)));
+    }
+};
+
+template <>
+struct Sse42Lanes<float> {
+    using Register = __m128;
+    static constexpr size_t LANES = 4;
+
+    FV_TARGET("sse4.2") static Register Broadcast(float value) noexcept {
+        return _mm_set1_ps(value);
+    }
+
+    FV_TARGET("sse4.2") static Register Load(const float* data) noexcept {
+        return _mm_loadu_ps(data);
+    }
+
+    template <CompareOp OP>
+    FV_TARGET("sse4.2") static uint32_t Compare(Register data, Register needle) noexcept {
+        Register compared;
+        if constexpr (OP == CompareOp::Equal) {
+            compared = _mm_cmpeq_ps(data, needle);
+        }
+        else if constexpr (OP == CompareOp::NotEqual) {
+            compared = _mm_cmpneq_ps(data, needle);
+        }
+        else if constexpr (OP == CompareOp::Less) {
+            compared = _mm_cmplt_ps(data, needle);
+        }
+        else if constexpr (OP == CompareOp::LessEqual) {
+            compared = _mm_cmple_ps(data, needle);
+        }
+        else if constexpr (OP == CompareOp::Greater) {
+            compared = _mm_cmpgt_ps(data, needle);
+        }
+        else {
+            compared = _mm_cmpge_ps(data, needle);
+        }
+        return static_cast<uint32_t>(_mm_movemask_ps(compared));
+    }
+};
+
+template <typename T>
+struct Avx2Lanes;
+
+template <>
+struct Avx2Lanes<int32_t> {
+    using Register = __m256i;
+    static constexpr size_t LANES = 8;
+    static constexpr uint32_t ALL = 0xFF;
+
+    FV_TARGET("avx2") static Register Broadcast(int32_t value) noexcept {
+        return _mm256_set1_epi32(value);
+    }
+
+    FV_TARGET("avx2") static Register Load(const int32_t* data) noexcept {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    }
+
+    template <CompareOp OP>
+    FV_TARGET("avx2") static uint32_t Compare(Register data, Register needle) noexcept {
+        if constexpr (OP == CompareOp::Equal || OP == CompareOp::NotEqual) {
+            const uint32_t mask = Mask(_mm256_cmpeq_epi32(data, needle));
+            return OP == CompareOp::Equal ? mask : mask ^ ALL;
+        }
+        else if constexpr (OP == CompareOp::Greater || OP == CompareOp::LessEqual) {
+            const uint32_t mask = Mask(_mm256_cmpgt_epi32(data, needle));
+            return OP == CompareOp::Greater ? mask : mask ^ ALL;
+        }
+        else {
+            const uint32_t mask = Mask(_mm256_cmpgt_epi32(needle, data));
+            return OP == CompareOp::Less ? mask : mask ^ ALL;
+        }
+    }
+
+    FV_TARGET("avx2") static uint32_t Mask(Register compared) noexcept {
+        return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(compared)));
+    }
+};
+
+template <>
+struct Avx2Lanes<float> {
+    using Register = __m256;
+    static constexpr size_t LANES = 8;
+
+    FV_TARGET("avx2") static Register Broadcast(float value) noexcept {
+        return _mm256_set1_ps(value);
+    }
+
+    FV_TARGET("avx2") static Register Load(const float* data) noexcept {
+        return _mm256_loadu_ps(data);
+    }
+
+    // Упорядоченные предикаты ложны для NaN, NotEqual — неупорядоченный, как оператор !=
+    template <CompareOp OP>
+    FV_TARGET("avx2") static uint32_t Compare(Register data, Register needle) noexcept {
+        Register compared;
+        if constexpr (OP == CompareOp::Equal) {
+            compared = _mm256_cmp_ps(data, needle, _CMP_EQ_OQ);
+        }
+        else if constexpr (OP == CompareOp::NotEqual) {
+            compared = _mm256_cmp_ps(data, needle, _CMP_NEQ_UQ);
+        }
+        else if constexpr (OP == CompareOp::Less) {
+            compared = _mm256_cmp_ps(data, needle, _CMP_LT_OQ);
+        }
+        else if constexpr (OP == CompareOp::LessEqual) {
+            compared = _mm256_cmp_ps(data, needle, _CMP_LE_OQ);
+        }
+        else if constexpr (OP == CompareOp::Greater) {
+            compared = _mm256_cmp_ps(data, needle, _CMP_GT_OQ);
+        }
+        else {
+            compared = _mm256_cmp_ps(data, needle, _CMP_GE_OQ);
+        }
+        return static_cast<uint32_t>(_mm256_movemask_ps(compared));
+    }
+};
+
+/*
+*   ОБОБЩЁННЫЕ ЯДРА. Встраиваются в обёртки Sse42Search и Avx2Search, поэтому регистры
+*   никогда не передаются между функциями с разными наборами инструкций, и предупреждение GCC
+*   о смене ABI для таких аргументов здесь отключено.
+*/
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+template <typename Lanes, CompareOp OP, typename T>
+FV_FORCE_INLINE size_t FindIfKernel(const T* data, size_t size, T value) noexcept {
+    constexpr size_t LANES = Lanes::LANES;
+    const auto needle = Lanes::Broadcast(value);
+    size_t i = 0;
+    for (; i + 2 * LANES <= size; i += 2 * LANES) {
+        const uint32_t low = Lanes::template Compare<OP>(Lanes::Load(data + i), needle);
+        const uint32_t high = Lanes::template Compare<OP>(Lanes::Load(data + i + LANES), needle);
+        if ((low | high) != 0) {
+            return i + CountTrailingZeros(low | (high << LANES));
+        }
+    }
+    for (; i + LANES <= size; i += LANES) {
+        const uint32_t mask = Lanes::template Compare<OP>(Lanes::Load(data + i), needle);
+        if (mask != 0) {
+            return i + CountTrailingZeros(mask);
+        }
+    }
+    return i + ScalarSearch::FindIf<T, OP>(data + i, size - i, value);
+}
+
+template <typename Lanes, CompareOp OP, typename T>
+FV_FORCE_INLINE size_t CountIfKernel(const T* data, size_t size, T value) noexcept {
+    constexpr size_t LANES = Lanes::LANES;
+    const auto needle = Lanes::Broadcast(value);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 2 * LANES <= size; i += 2 * LANES) {
+        const uint32_t low = Lanes::template Compare<OP>(Lanes::Load(data + i), needle);
+        const uint32_t high = Lanes::template Compare<OP>(Lanes::Load(data + i + LANES), needle);
+        count += PopCount(low | (high << LANES));
+    }
+    return count + ScalarSearch::CountIf<T, OP>(data + i, size - i, value);
+}
+
+template <typename Lanes, typename T>
+FV_FORCE_INLINE size_t FindAnyKernel(const T* data, size_t size, const T* needles, size_t needle_count) noexcept {
+    constexpr size_t LANES = Lanes::LANES;
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        const auto values = Lanes::Load(data + i);
+        uint32_t mask = 0;
+        for (size_t j = 0; j < needle_count; ++j) {
+            mask |= Lanes::template Compare<CompareOp::Equal>(values, Lanes::Broadcast(needles[j]));
+        }
+        if (mask != 0) {
+            return i + CountTrailingZeros(mask);
+        }
+    }
+    return i + ScalarSearch::FindAny(data + i, size - i, needles, needle_count);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+struct Sse42Search {
+    template <typename T, CompareOp OP>
+    FV_TARGET("sse4.2,popcnt") static size_t FindIf(const T* data, size_t size, T value) noexcept {
+        return FindIfKernel<Sse42Lanes<T>, OP>(data, size, value);
+    }
+
+    template <typename T, CompareOp OP>
+    FV_TARGET("sse4.2,popcnt") static size_t CountIf(const T* data, size_t size, T value) noexcept {
+        return CountIfKernel<Sse42Lanes<T>, OP>(data, size, value);
+    }
+
+    template <typename T>
+    FV_TARGET("sse4.2,popcnt") static size_t FindAny(const T* data, size_t size, const T* needles, size_t needle_count) noexcept {
+        return FindAnyKernel<Sse42Lanes<T>>(data, size, needles, needle_count);
+    }
+};
+
+struct Avx2Search {
+    template <typename T, CompareOp OP>
+    FV_TARGET("avx2,popcnt") static size_t FindIf(const T* data, size_t size, T value) noexcept {
+        return FindIfKernel<Avx2Lanes<T>, OP>(data, size, value);
+    }
+
+    template <typename T, CompareOp OP>
+    FV_TARGET("avx2,popcnt") static size_t CountIf(const T* data, size_t size, T value) noexcept {
+        return CountIfKernel<Avx2Lanes<T>, OP>(data, size, value);
+    }
+
+    template <typename T>
+    FV_TARGET("avx2,popcnt") static size_t FindAny(const T* data, size_t size, const T* needles, size_t needle_count) noexcept {
+        return FindAnyKernel<Avx2Lanes<T>>(data, size, needles, needle_count);
+    }
+};
+
+#endif
+
+/*
+*   Таблица ядер поиска для типа T. Active() — таблица активного уровня (ActiveIsaLevel),
+*   Dispatch() позволяет получить и сравнить таблицы всех уровней.
+*   Уровень AVX-512 собственных ядер поиска не имеет и использует AVX2.
+*/
+template <typename T>
+class SearchKernels {
+public:
+    using FindIfFn = size_t (*)(const T*, size_t, T);
+    using CountIfFn = size_t (*)(const T*, size_t, T);
+    using FindAnyFn = size_t (*)(const T*, size_t, const T*, size_t);
+
+    struct Table {
+        FindIfFn find_if[COMPARE_OP_COUNT];
+        CountIfFn count_if[COMPARE_OP_COUNT];
+        FindAnyFn find_any;
+    };
+
+    static constexpr bool HAS_SIMD = FV_X86 && (std::is_same_v<T, int32_t> || std::is_same_v<T, float>);
+
+    static const IsaDispatch<Table>& Dispatch() noexcept {
+        static constexpr Table SCALAR = MakeTable<ScalarSearch>();
+#if FV_X86
+        if constexpr (HAS_SIMD) {
+            static constexpr Table SSE42 = MakeTable<Sse42Search>();
+            static constexpr Table AVX2 = MakeTable<Avx2Search>();
+            static constexpr IsaDispatch<Table> DISPATCH(&SCALAR, &SSE42, &AVX2);
+            return DISPATCH;
+        }
+#endif
+        static constexpr IsaDispatch<Table> DISPATCH(&SCALAR);
+        return DISPATCH;
+    }
+
+    static const Table& Active() noexcept {
+        static const Table& table = Dispatch().Active();
+        return table;
+    }
+
+    static const Table& ForLevel(IsaLevel level) noexcept {
+        return Dispatch().ForLevel(level);
+    }
+
+private:
+    template <typename Isa>
+    static constexpr Table MakeTable() noexcept {
+        return MakeTable<Isa>(std::make_index_sequence<COMPARE_OP_COUNT>());
+    }
+
+    template <typename Isa, size_t... OPS>
+    static constexpr Table MakeTable(std::index_sequence<OPS...>) noexcept {
+        return Table{
+            { &Isa::template FindIf<T, static_cast<CompareOp>(OPS)>... },
+            { &Isa::template CountIf<T, static_cast<CompareOp>(OPS)>... },
+            &Isa::template FindAny<T>
+        };
+    }
+};
+
+/*
+*   Функции поиска по Vector арифметического типа. Искомое значение имеет тип элемента,
+*   поэтому в Vector<float> можно искать литерал 1, а не только 1.0f.
+*/
+
+template <typename T>
+using SearchValue = std::enable_if_t<std::is_arithmetic_v<T>, T>;
+
+//  Индекс первого элемента, для которого выполняется element OP value, либо NOT_FOUND
+template <typename T>
+size_t IndexOfIf(const Vector<T>& v, CompareOp op, SearchValue<T> value) noexcept {
+    const size_t index = SearchKernels<T>::Active().find_if[static_cast<size_t>(op)](v.begin(), v.Size(), value);
+    return index == v.Size() ? NOT_FOUND : index;
+}
+
+template <typename T>
+size_t IndexOf(const Vector<T>& v, SearchValue<T> value) noexcept {
+    return IndexOfIf(v, CompareOp::Equal, value);
+}
+
+template <typename T>
+typename Vector<T>::const_iterator Find(const Vector<T>& v, SearchValue<T> value) noexcept {
+    return v.begin() + SearchKernels<T>::Active().find_if[static_cast<size_t>(CompareOp::Equal)](v.begin(), v.Size(), value);
+}
+
+template <typename T>
+bool Contains(const Vector<T>& v, SearchValue<T> value) noexcept {
+    return IndexOf(v, value) != NOT_FOUND;
+}
+
+//  Первый элемент, не равный value. Удобен для проверки, что вектор заполнен одним значением
+template <typename T>
+typename Vector<T>::const_iterator FindFirstNotEqual(const Vector<T>& v, SearchValue<T> value) noexcept {
+    return v.begin() + SearchKernels<T>::Active().find_if[static_cast<size_t>(CompareOp::NotEqual)](v.begin(), v.Size(), value);
+}
+
+//  Количество элементов, для которых выполняется element OP value
+template <typename T>
+size_t CountIf(const Vector<T>& v, CompareOp op, SearchValue<T> value) noexcept {
+    return SearchKernels<T>::Active().count_if[static_cast<size_t>(op)](v.begin(), v.Size(), value);
+}
+
+template <typename T>
+size_t Count(const Vector<T>& v, SearchValue<T> value) noexcept {
+    return CountIf(v, CompareOp::Equal, value);
+}
+
+//  Первый элемент, равный любому из needles. Каждый блок элементов сравнивается со всеми иглами
+template <typename T>
+typename Vector<T>::const_iterator FindAny(const Vector<T>& v, const Vector<T>& needles) noexcept {
+    static_assert(std::is_arithmetic_v<T>, "FindAny requires an arithmetic element type");
+    return v.begin() + SearchKernels<T>::Active().find_any(v.begin(), v.Size(), needles.begin(), needles.Size());
+}
+
+template <typename T>
+size_t IndexOfAny(const Vector<T>& v, const Vector<T>& needles) noexcept {
+    const auto it = FindAny(v, needles);
+    return it == v.end() ? NOT_FOUND : static_cast<size_t>(it - v.begin());
+}